@@ -1,4 +1,5 @@
 #include "EstimateEvaluator.hh"
+#include <algorithm>
 
 namespace H2D {
 
@@ -9,7 +10,7 @@ namespace H2D {
 #define NOSELCLASSES 28
 
 EstimateEvaluator::EstimateEvaluator() : _theta(), _aggregates(), _aggregatesNZ(), _qerrProfile(),
-                                         _thetaFixed(), _aggrFixed(4), _aggrFixedNZ(4), _countBadFixedNZ(4), _total(0), _qselPercentile(),_allQuerySelPercentiles(),_queryClass(NOTHETA, std::vector<std::vector<uint>>(NOSELCLASSES, std::vector<uint>(NOQERRCLASSES, 0))),det_v() {
+                                         _thetaFixed(), _aggrFixed(4), _aggrFixedNZ(4), _countBadFixedNZ(4), _total(0), _qselPercentile(),_allQuerySelPercentiles(),_queryClass(NOTHETA, std::vector<std::vector<uint>>(NOSELCLASSES, std::vector<uint>(NOQERRCLASSES, 0))),_latency(NOSELCLASSES),det_v() {
   _thetaFixed.push_back(500);
   _thetaFixed.push_back(1000);
   _thetaFixed.push_back(5000);
@@ -59,6 +60,14 @@ EstimateEvaluator::init() {
   for(uint i = 0; i < _countBadFixedNZ.size(); ++i) {
     _countBadFixedNZ[i] = 0;
   }
+  for(auto& lHist : _latency) {
+    lHist.init();
+  }
+  for(auto& lTheta : _queryClass) {
+    for(auto& lSelClass : lTheta) {
+      std::fill(lSelClass.begin(), lSelClass.end(), 0);
+    }
+  }
 
   //for(uint i = 0; i < no_theta(); ++i) {
   //  for(uint j = 0; j < 3; ++j) {
@@ -158,6 +167,49 @@ EstimateEvaluator::step(const uint aTrueValue, const uint aEstimate) {
 }
 
 
+/*
+ * merge: x must have been initialized like *this (same thetas, same total)
+ * and must have seen a disjoint set of queries.
+ * all counters are merged exactly, the sums of the aggregates are
+ * added in the order of the merge calls.
+ */
+
+void
+EstimateEvaluator::merge(const EstimateEvaluator& x) {
+  for(uint i = 0; i < no_theta(); ++i) {
+    _aggregates[i].merge(x._aggregates[i]);
+    _aggregatesNZ[i].merge(x._aggregatesNZ[i]);
+    for(uint j = 0; j < _qerrProfile[i].size(); ++j) {
+      _qerrProfile[i][j] += x._qerrProfile[i][j];
+    }
+  }
+  for(uint i = 0; i < 4; ++i) {
+    _aggrFixed[i].merge(x._aggrFixed[i]);
+    _aggrFixedNZ[i].merge(x._aggrFixedNZ[i]);
+    _countBadFixedNZ[i] += x._countBadFixedNZ[i];
+  }
+  for(uint i = 0; i < 6; ++i) {
+    for(uint j = 0; j < 4; ++j) {
+      _qselPercentile[i][j] += x._qselPercentile[i][j];
+    }
+  }
+  for(uint j = 0; j < 4; ++j) {
+    _allQuerySelPercentiles[j] += x._allQuerySelPercentiles[j];
+  }
+  for(uint i = 0; i < _queryClass.size(); ++i) {
+    for(uint j = 0; j < _queryClass[i].size(); ++j) {
+      for(uint k = 0; k < _queryClass[i][j].size(); ++k) {
+        _queryClass[i][j][k] += x._queryClass[i][j][k];
+      }
+    }
+  }
+  for(uint i = 0; i < _latency.size(); ++i) {
+    _latency[i].merge(x._latency[i]);
+  }
+  det_v.insert(det_v.end(), x.det_v.begin(), x.det_v.end());
+}
+
+
 void
 EstimateEvaluator::fin() {
   for(uint i = 0; i < no_theta(); ++i) {
@@ -193,6 +245,13 @@ EstimateEvaluator::nstep(const uint aTrueValue, const uint aEstimate) {
     }
 
 
+void
+EstimateEvaluator::lstep(const uint aTrueValue, const uint64_t aCycles) {
+  const uint lSelClass = std::min<uint>(NOSELCLASSES - 1, selectivity_class(std::max<uint>(1, aTrueValue), std::max<uint>(1, _total)));
+  _latency[lSelClass].step(aCycles);
+}
+
+
 
 void
 EstimateEvaluator::step(const uint aTrueValue, const uint aEstimate, std::ostream& fos) {
@@ -303,7 +362,7 @@ for (const auto& t : _queryClass) {
 		 
                 os << s[qe];
                 if (qe < s.size() - 1) {
-                    std::cout << " ";
+                    os << " ";
                 }
             }
 	    os<< std::endl;
@@ -315,6 +374,33 @@ for (const auto& t : _queryClass) {
 return os;
 }
 
+/*
+ * one line per non-empty selectivity class and one for all queries:
+ * <marker> <selclass> n avg p50 p90 p99 p999 max
+ */
+
+std::ostream&
+EstimateEvaluator::lprint(std::ostream& os, const std::string& aLineMarker, const double aCyclesPerUnit) const {
+  LatencyHistogram lAll;
+  os << aLineMarker << ' ' << std::setw(3) << "sel";
+  const char* lCol[7] = { "n", "avg", "p50", "p90", "p99", "p999", "max" };
+  for(uint j = 0; j < 7; ++j) {
+    os << ' ' << std::setw(10) << lCol[j];
+  }
+  os << std::endl;
+  for(uint i = 0; i < _latency.size(); ++i) {
+    if(0 == _latency[i].n()) {
+      continue;
+    }
+    os << aLineMarker << ' ' << std::setw(3) << i << ' ';
+    _latency[i].print(os, aCyclesPerUnit) << std::endl;
+    lAll.merge(_latency[i]);
+  }
+  os << aLineMarker << ' ' << std::setw(3) << "all" << ' ';
+  lAll.print(os, aCyclesPerUnit) << std::endl;
+  return os;
+}
+
 
 std::ostream&
 EstimateEvaluator::print(std::ostream& os) const {
@@ -7,6 +7,7 @@
 #include "infra/aggregate.hh"
 #include "infra/tmath.hh"
 #include "infra/q.hh"
+#include "LatencyHistogram.hh"
 #include <cmath>
 namespace H2D {
 
@@ -33,6 +34,8 @@ class EstimateEvaluator {
     void step(const uint aTrueValue, const uint aEstimate); 
     void step(const uint aTrueValue, const uint aEstimate, std::ostream& fos);
     void nstep(const uint aTrueValue, const uint aEstimate);
+    void lstep(const uint aTrueValue, const uint64_t aCycles); // latency of one estimate
+    void merge(const EstimateEvaluator& x); // add in the counts of an evaluator with the same thetas
     void fin();
   public:
     inline uint no_theta() const { return _theta.size(); }
@@ -55,6 +58,8 @@ class EstimateEvaluator {
   public:
     std::ostream& print(std::ostream& os) const;
     std::ostream& nprint(std::ostream& os) const;
+    // latency quantiles per selectivity class, aCyclesPerUnit as in LatencyHistogram::print
+    std::ostream& lprint(std::ostream& os, const std::string& aLineMarker, const double aCyclesPerUnit) const;
     std::ostream& printShort(std::ostream& os) const;
     std::ostream& printAllforOneEst(std::ostream& os) const;
 
@@ -80,6 +85,7 @@ class EstimateEvaluator {
     uint _qselPercentile[6][4] = {0};
     uint _allQuerySelPercentiles[4] = {0};
     uint_vvvt _queryClass;
+    std::vector<LatencyHistogram> _latency; // indexed by selectivity class
 
 
     struct EstDetail {
@@ -0,0 +1,78 @@
+#include "LatencyHistogram.hh"
+
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+namespace H2D {
+
+
+LatencyHistogram::LatencyHistogram() : _count(), _n(0), _sum(0), _max(0) {
+}
+
+void
+LatencyHistogram::init() {
+  memset(_count, 0, sizeof(_count));
+  _n   = 0;
+  _sum = 0;
+  _max = 0;
+}
+
+void
+LatencyHistogram::merge(const LatencyHistogram& x) {
+  for(uint i = 0; i < k_no_bucket; ++i) {
+    _count[i] += x._count[i];
+  }
+  _n   += x._n;
+  _sum += x._sum;
+  if(x._max > _max) {
+    _max = x._max;
+  }
+}
+
+uint64_t
+LatencyHistogram::bucket_hi(const uint aBucket) {
+  const uint lGroup = aBucket / k_sub;
+  if(1 >= lGroup) {
+    return aBucket; // exact
+  }
+  const uint     lShift = lGroup - 1;
+  const uint64_t lLo    = ((uint64_t) (k_sub + (aBucket % k_sub))) << lShift;
+  return (lLo + ((((uint64_t) 1) << lShift) - 1));
+}
+
+uint64_t
+LatencyHistogram::quantile(const double aQuantile) const {
+  if(0 == _n) {
+    return 0;
+  }
+  uint64_t lRank = (uint64_t) std::ceil(aQuantile * (double) _n);
+  if(0 == lRank) {
+    lRank = 1;
+  }
+  uint64_t lCum = 0;
+  for(uint i = 0; i < k_no_bucket; ++i) {
+    lCum += _count[i];
+    if(lCum >= lRank) {
+      return std::min<uint64_t>(bucket_hi(i), _max);
+    }
+  }
+  return _max;
+}
+
+std::ostream&
+LatencyHistogram::print(std::ostream& os, const double aCyclesPerUnit, const int aFieldWidth) const {
+  os << std::setw(aFieldWidth) << n() << ' '
+     << std::setw(aFieldWidth) << (uint64_t) std::round(avg() / aCyclesPerUnit) << ' '
+     << std::setw(aFieldWidth) << (uint64_t) std::round(quantile(0.5)   / aCyclesPerUnit) << ' '
+     << std::setw(aFieldWidth) << (uint64_t) std::round(quantile(0.9)   / aCyclesPerUnit) << ' '
+     << std::setw(aFieldWidth) << (uint64_t) std::round(quantile(0.99)  / aCyclesPerUnit) << ' '
+     << std::setw(aFieldWidth) << (uint64_t) std::round(quantile(0.999) / aCyclesPerUnit) << ' '
+     << std::setw(aFieldWidth) << (uint64_t) std::round(max()           / aCyclesPerUnit);
+  return os;
+}
+
+
+} // end namespace
+
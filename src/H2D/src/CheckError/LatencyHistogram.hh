@@ -0,0 +1,62 @@
+#ifndef H2D_CHECK_ERROR_LATENCY_HISTOGRAM_HH
+#define H2D_CHECK_ERROR_LATENCY_HISTOGRAM_HH
+
+#include <iostream>
+#include <inttypes.h>
+
+namespace H2D {
+
+/*
+ * LatencyHistogram
+ * log-linear histogram of latencies (in clock cycles):
+ * values below 2^k_sub_log are counted exactly, above that every power of
+ * two is split into 2^k_sub_log sub buckets, i.e., the relative error of
+ * a quantile is at most 2^-k_sub_log (12.5%).
+ * step is O(1) and allocation free, max is exact.
+ */
+
+class LatencyHistogram {
+  public:
+    static constexpr uint k_sub_log   = 3;
+    static constexpr uint k_sub       = (1 << k_sub_log);
+    static constexpr uint k_no_bucket = (64 - k_sub_log + 1) * k_sub;
+  public:
+    LatencyHistogram();
+  public:
+    void init();
+    inline void step(const uint64_t aCycles) {
+                  ++_count[bucket(aCycles)];
+                  ++_n;
+                  _sum += aCycles;
+                  if(aCycles > _max) { _max = aCycles; }
+                }
+    void merge(const LatencyHistogram& x);
+  public:
+    inline uint64_t n()   const { return _n; }
+    inline uint64_t max() const { return _max; }
+    inline double   avg() const { return ((0 == _n) ? 0.0 : ((double) _sum / (double) _n)); }
+    // upper bound of the bucket containing the aQuantile-quantile, capped by max
+    uint64_t quantile(const double aQuantile) const;
+  public:
+    // one line: n, avg, p50, p90, p99, p999, max
+    // aCyclesPerUnit: divide cycles by this (e.g. cycles per ns), 1 prints cycles
+    std::ostream& print(std::ostream& os, const double aCyclesPerUnit = 1.0, const int aFieldWidth = 10) const;
+  public:
+    static inline uint bucket(const uint64_t x) {
+                         if(x < k_sub) {
+                           return (uint) x;
+                         }
+                         const uint lLog = 63 - __builtin_clzll(x);
+                         return ((lLog - k_sub_log + 1) * k_sub + ((x >> (lLog - k_sub_log)) & (k_sub - 1)));
+                       }
+    static uint64_t bucket_hi(const uint aBucket); // largest value falling into aBucket
+  private:
+    uint64_t _count[k_no_bucket];
+    uint64_t _n;
+    uint64_t _sum;
+    uint64_t _max;
+};
+
+} // end namespace
+
+#endif
@@ -12,6 +12,28 @@ EXGB::EXGB(const Data2dim &aData, const H2D::Cb &aCb,
   setEnriched(1);
 }
 
+// 4: log area estimate, 5: log sample estimate
+void EXGB::fill_features(const query_t &aQuery, float *aRowOut) const {
+  XGBEstimator::fill_features(aQuery, aRowOut);
+  aRowOut[4] = feature(std::log(_areaEst.estimate(aQuery)));
+  aRowOut[5] = feature(std::log(_sampleEst.estimate(aQuery)));
+}
+
+// area and sample estimates through estimate_batch
+void EXGB::fill_features_batch(const query_t *aBegin, const uint aN,
+                               float *aMatOut) const {
+  std::vector<double> lArea(aN);
+  std::vector<double> lSample(aN);
+  _areaEst.estimate_batch(aBegin, aN, lArea.data());
+  _sampleEst.estimate_batch(aBegin, aN, lSample.data());
+  for (uint i = 0; i < aN; ++i) {
+    float *lRow = aMatOut + (size_t)i * 6;
+    XGBEstimator::fill_features(aBegin[i], lRow);
+    lRow[4] = feature(std::log(lArea[i]));
+    lRow[5] = feature(std::log(lSample[i]));
+  }
+}
+
 void EXGB::fill_libsvm_trainfiles() const {
 
   std::ofstream train_out_file;
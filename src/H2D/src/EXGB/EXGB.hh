@@ -31,6 +31,10 @@ public:
 public:
   virtual void fill_libsvm_trainfiles() const;
   virtual void fill_libsvm_testfiles() const;
+  virtual uint num_features() const { return 6; }
+  virtual void fill_features(const query_t &aQuery, float *aRowOut) const;
+  virtual void fill_features_batch(const query_t *aBegin, const uint aN,
+                                   float *aMatOut) const;
 
 private:
   Data2dim _data;
@@ -1,4 +1,5 @@
 #include "EqDepHist.hh"
+#include "../../../infra/binary_search.hh"
 
 namespace H2D {
 
@@ -15,6 +16,7 @@ EqDepHist::EqDepHist(const Data2dim& aData,
                      const bool      aTrace)
               : EstimatorBase2dim(aQ, aTheta),
                 _outlier(), 
+                _outlierIndex(),
                 _kind(aKind),
                 _nx(aNx), _ny(aNy), 
                 _rx(aRx), _ry(aRy), 
@@ -22,7 +24,8 @@ EqDepHist::EqDepHist(const Data2dim& aData,
                 _vx(),
                 _vy(),
                 _regp(0),
-                _trace(aTrace) {
+                _trace(aTrace),
+                _xlo(), _xhi(), _yBegin(), _ylo(), _yhi(), _ycf(), _ycum() {
   if(trace()) {
     std::cout << "Equi-Depth-Histogram: params: " << aNx << ", " << aNy << ", " << aPhi << std::endl;
   }
@@ -67,11 +70,13 @@ EqDepHist::EqDepHist(const Data2dim& aData,
   Data2dim lRegular;
   if(8 < aPhi) {
     aData.split(lRegular, _outlier, aPhi);
+    _outlierIndex.init(_outlier);
   } else {
     lRegular = aData;
   }
 
   initVx(lRegular);
+  initSoA();
 
 
   // first test
@@ -379,6 +384,35 @@ EqDepHist::initVyR(Data2dim& aData, const uint aBegin, const uint aEnd, const ui
 
 }
 
+// the x-buckets in use are followed by default entries (cf 0) in _vx
+void
+EqDepHist::initSoA() {
+  uint lNoX = 0;
+  while(lNoX < vx().size() && 0 < vx()[lNoX].cf()) {
+    ++lNoX;
+  }
+  _xlo.resize(lNoX);
+  _xhi.resize(lNoX);
+  _yBegin.assign(1, 0);
+  _ylo.clear();
+  _yhi.clear();
+  _ycf.clear();
+  _ycum.assign(1, 0.0);
+  for(uint i = 0; i < lNoX; ++i) {
+    _xlo[i] = vx()[i].lo();
+    _xhi[i] = vx()[i].hi();
+    if(i < vy().size()) {
+      for(const entry_t& e : vy()[i]) {
+        _ylo.push_back(e.lo());
+        _yhi.push_back(e.hi());
+        _ycf.push_back(e.cf());
+        _ycum.push_back(_ycum.back() + e.cf());
+      }
+    }
+    _yBegin.push_back(_ylo.size());
+  }
+}
+
 uint
 EqDepHist::findEnd(const Data2dim& aData,
                    const uint aBegin, // beginning of new bucket
@@ -453,17 +487,36 @@ EqDepHist::estimate(const rectangle_t& r) const {
   return std::max<double>(minEstimate(), lEstimate);
 }
 
+void
+EqDepHist::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  std::vector<uint> lOutlierCount(aN);
+  for(size_t i = 0; i < aN; ++i) {
+    lOutlierCount[i] = outlierCount(aBegin[i].rectangle());
+  }
+  for(size_t i = 0; i < aN; ++i) {
+    const rectangle_t& r = aBegin[i].rectangle();
+    double lEstimate = 0;
+    if(k_simple == kind()) {
+      lEstimate += estimateIntervals(r);
+    } else
+    if(k_matrix == kind()) {
+      lEstimate += estimateIntervalsR(r);
+    }
+    lEstimate += (double) lOutlierCount[i];
+    aEstOut[i] = std::max<double>(minEstimate(), lEstimate);
+  }
+}
+
 double
 EqDepHist::estimateIntervals(const rectangle_t& r) const {
   double lRes = 0.0;
-  for(uint i = 0; i < vx().size(); ++i) {
-    if(vx()[i].hi() <= r.xlo()) {
-      continue;
-    }
-    if(r.xhi() <= vx()[i].lo()) {
+  const uint lNoX = _xlo.size();
+  // skip the x-buckets with hi <= r.xlo()
+  for(uint i = upper_bound_branchless(r.xlo(), _xhi.data(), lNoX); i < lNoX; ++i) {
+    if(r.xhi() <= _xlo[i]) {
       break;
     }
-    lRes += estimateY(r, i, vx()[i].lo(), vx()[i].hi());
+    lRes += estimateY(r, i, _xlo[i], _xhi[i]);
   }
   return lRes;
 }
@@ -477,14 +530,6 @@ EqDepHist::estimateY(const rectangle_t& aRecQuery,
   const bool lTrace = false;
   double lRes = 0.0;
 
-  const entry_vt& lVy = vy()[aIdxX];
-
-  rectangle_t lRecIsec; // will contain intersection query rect, tile rect
-  rectangle_t lRecTile; // tile rectangle
-  
-  lRecTile.xlo(aXlo);
-  lRecTile.xhi(aXhi);
-
   if(lTrace) {
     std::cout << "EqDepHist::estimateY: params: " 
               << aRecQuery << ",  "
@@ -494,84 +539,105 @@ EqDepHist::estimateY(const rectangle_t& aRecQuery,
               << std::endl;
   }
 
-  for(uint j = 0; j < lVy.size(); ++j) {
-    const entry_t& e = lVy[j];
-    if(e.hi() <= aRecQuery.ylo()) {
-      continue;
-    }
-    if(aRecQuery.yhi() <= e.lo()) {
-      break;
+  // y-buckets touched: first with hi > ylo up to (excl.) first with lo >= yhi
+  const uint    lBegin = _yBegin[aIdxX];
+  const uint    lNoY   = _yBegin[aIdxX + 1] - lBegin;
+  const double* lLo    = _ylo.data() + lBegin;
+  const double* lHi    = _yhi.data() + lBegin;
+  const uint lFirst = upper_bound_branchless(aRecQuery.ylo(), lHi, lNoY);
+  const uint lLast  = std::max<uint>(lFirst, lower_bound_branchless(aRecQuery.yhi(), lLo, lNoY));
+
+  // y-buckets contained in [ylo, yhi]: lo >= ylo and hi <= yhi.
+  // the y-buckets are built from y-sorted data, i.e. lo[j+1] >= hi[j],
+  // so all touched ones but the first and the last are contained.
+  // with the x-bucket contained in [xlo, xhi] they contribute their cf,
+  // otherwise (then aXlo < aXhi) the fraction of the x-bucket covered.
+  // visited x-buckets with aXlo == aXhi are always contained.
+  uint lInBegin = lFirst;
+  uint lInEnd   = lLast;
+  if(lFirst < lLast) {
+    lInBegin += (lLo[lFirst] < aRecQuery.ylo());
+    lInEnd   -= (aRecQuery.yhi() < lHi[lLast - 1]);
+    lInEnd    = std::max<uint>(lInBegin, lInEnd);
+  }
+  if(lInBegin < lInEnd) {
+    const double lSum = _ycum[lBegin + lInEnd] - _ycum[lBegin + lInBegin];
+    if(aRecQuery.xlo() <= aXlo && aXhi <= aRecQuery.xhi()) {
+      lRes += lSum;
+    } else {
+      const double lXIsecLo = std::max<double>(aRecQuery.xlo(), aXlo);
+      const double lXIsecHi = std::min<double>(aRecQuery.xhi(), aXhi);
+      lRes += ((lXIsecHi - lXIsecLo) / (aXhi - aXlo)) * lSum;
     }
+  }
 
-    // problematic cases:
-    // e.lo() == e.hi()
-    // aXlo() == aXhi()
-    lRecTile.ylo(e.lo());
-    lRecTile.yhi(e.hi());
-    if(aRecQuery.contains(lRecTile)) {
-      const double lEstimate = (double) e.cf();
-      lRes += lEstimate;
-    } else
-    if(e.lo() < e.hi() && aXlo < aXhi) {
-      lRecIsec.isec(aRecQuery, lRecTile);
-
-      const double lEstimate = (lRecIsec.area() / lRecTile.area()) * e.cf();
-      lRes += lEstimate;
-
-      if(lTrace) {
-        std::cout << "  query rectangle: " << aRecQuery << std::endl;
-        std::cout << "  tile  rectangle: " << lRecTile  << std::endl;
-        std::cout << "  isec  rectangle: " << lRecIsec  << std::endl;
-        std::cout << "  cum   frequency: " << e.cf()    << std::endl;
-        std::cout << "  isec  area     : " << lRecIsec.area() << std::endl;
-        std::cout << "  tile  area     : " << lRecTile.area() << std::endl;
-        std::cout << "  estimate       : " << lEstimate       << std::endl;
-      }
-    } else {
-      if(e.lo() >= e.hi()) {
-        // not e.hi() <= aRecQuery.ylo()
-        // and
-        // not aRecQuery.yhi() <= e.lo()
-        // and e.lo() >= e.hi()
-        // implies 
-        // aRecQuery.ylo() < e.hi() <= e.lo() < aRecQuery.yhi()
-        // thus: check only on aXlo, aXhi
-        const double lXIsecLo = std::max<double>(aRecQuery.xlo(), aXlo);
-        const double lXIsecHi = std::min<double>(aRecQuery.xhi(), aXhi);
-        const double lEstimate = ((lXIsecHi - lXIsecLo) / (aXhi - aXlo)) * e.cf();
-        lRes += lEstimate;
-        // std::cout << "BOOM Y" << std::endl;
-        // std::cerr << "BOOM Y" << std::endl;
-        // std::cout << "stop: " << "continue!" << std::endl;
-      } else
-      if(aXlo >= aXhi) {
-        const double lYIsecLo = std::max<double>(aRecQuery.ylo(), e.lo());
-        const double lYIsecHi = std::min<double>(aRecQuery.yhi(), e.hi());
-        const double lEstimate = ((lYIsecHi - lYIsecLo) / (e.hi() - e.lo())) * e.cf();
-        lRes += lEstimate;
-        // std::cout << "BOOM X" << std::endl;
-        // std::cerr << "BOOM X" << std::endl;
-        // std::cout << "stop: " << (1/0) << std::endl;
-      }
+  // partially covered y-buckets at both ends
+  for(uint j = lFirst; j < lLast; ++j) {
+    if(lInBegin <= j && j < lInEnd) {
+      j = lInEnd - 1;
+      continue;
+    }
+    const double lEstimate = estimateBucket(aRecQuery, aXlo, aXhi, lLo[j], lHi[j], _ycf[lBegin + j]);
+    lRes += lEstimate;
+    if(lTrace) {
+      std::cout << "  y-bucket " << j << ": [" << lLo[j] << ", " << lHi[j] << "] "
+                << ", cf: " << _ycf[lBegin + j]
+                << ", estimate: " << lEstimate << std::endl;
     }
   }
 
   return lRes;
 }
 
+// as in the former bucket loop of estimateY:
+// problematic cases:
+// e.lo() == e.hi()
+// aXlo() == aXhi()
+double
+EqDepHist::estimateBucket(const rectangle_t& aRecQuery,
+                          const double aXlo, const double aXhi,
+                          const double aYlo, const double aYhi, const uint aCf) {
+  rectangle_t lRecTile(aXlo, aYlo, aXhi, aYhi);
+  if(aRecQuery.contains(lRecTile)) {
+    return (double) aCf;
+  }
+  if(aYlo < aYhi && aXlo < aXhi) {
+    rectangle_t lRecIsec;
+    lRecIsec.isec(aRecQuery, lRecTile);
+    return (lRecIsec.area() / lRecTile.area()) * aCf;
+  }
+  if(aYlo >= aYhi) {
+    // not aYhi <= aRecQuery.ylo()
+    // and
+    // not aRecQuery.yhi() <= aYlo
+    // and aYlo >= aYhi
+    // implies 
+    // aRecQuery.ylo() < aYhi <= aYlo < aRecQuery.yhi()
+    // thus: check only on aXlo, aXhi
+    const double lXIsecLo = std::max<double>(aRecQuery.xlo(), aXlo);
+    const double lXIsecHi = std::min<double>(aRecQuery.xhi(), aXhi);
+    return ((lXIsecHi - lXIsecLo) / (aXhi - aXlo)) * aCf;
+  }
+  if(aXlo >= aXhi) {
+    const double lYIsecLo = std::max<double>(aRecQuery.ylo(), aYlo);
+    const double lYIsecHi = std::min<double>(aRecQuery.yhi(), aYhi);
+    return ((lYIsecHi - lYIsecLo) / (aYhi - aYlo)) * aCf;
+  }
+  return 0.0;
+}
+
 
 
 double
 EqDepHist::estimateIntervalsR(const rectangle_t& r) const {
   double lRes = 0.0;
-  for(uint i = 0; i < vx().size(); ++i) {
-    if(vx()[i].hi() <= r.xlo()) {
-      continue;
-    }
-    if(r.xhi() <= vx()[i].lo()) {
+  const uint lNoX = _xlo.size();
+  // skip the x-buckets with hi <= r.xlo()
+  for(uint i = upper_bound_branchless(r.xlo(), _xhi.data(), lNoX); i < lNoX; ++i) {
+    if(r.xhi() <= _xlo[i]) {
       break;
     }
-    lRes += estimateYR(r, i, vx()[i].lo(), vx()[i].hi());
+    lRes += estimateYR(r, i, _xlo[i], _xhi[i]);
   }
   return lRes;
 }
@@ -585,16 +651,8 @@ EqDepHist::estimateYR(const rectangle_t& aRecQuery,
   const bool lTrace = false;
   double lRes = 0.0;
 
-  const entry_vt& lVy = vy()[aIdxX];
-
-  rectangle_t lRecIsec; // will contain intersection query rect, tile rect
-  rectangle_t lRecTile; // tile rectangle
-  
-  lRecTile.xlo(aXlo);
-  lRecTile.xhi(aXhi);
-
   if(lTrace) {
-    std::cout << "EqDepHist::estimateY: params: " 
+    std::cout << "EqDepHist::estimateYR: params: " 
               << aRecQuery << ",  "
               << aIdxX << ", "
               << aXlo  << ", "
@@ -602,70 +660,46 @@ EqDepHist::estimateYR(const rectangle_t& aRecQuery,
               << std::endl;
   }
 
-  for(uint j = 0; j < lVy.size(); ++j) {
-    const entry_t& e = lVy[j];
-    if(e.hi() <= aRecQuery.ylo()) {
+  // y-buckets touched: first with hi > ylo up to (excl.) first with lo >= yhi
+  const uint    lBegin = _yBegin[aIdxX];
+  const uint    lNoY   = _yBegin[aIdxX + 1] - lBegin;
+  const double* lLo    = _ylo.data() + lBegin;
+  const double* lHi    = _yhi.data() + lBegin;
+  const uint lFirst = upper_bound_branchless(aRecQuery.ylo(), lHi, lNoY);
+  const uint lLast  = std::max<uint>(lFirst, lower_bound_branchless(aRecQuery.yhi(), lLo, lNoY));
+
+  // with the x-bucket contained, the y-buckets contained in [ylo, yhi]
+  // contribute their cf, all others are estimated by their RegP
+  // (all touched ones but the first and the last are contained, see estimateY)
+  uint lInBegin = lFirst;
+  uint lInEnd   = lFirst;
+  if(lFirst < lLast && aRecQuery.xlo() <= aXlo && aXhi <= aRecQuery.xhi()) {
+    lInBegin += (lLo[lFirst] < aRecQuery.ylo());
+    lInEnd    = std::max<uint>(lInBegin, lLast - (aRecQuery.yhi() < lHi[lLast - 1]));
+    lRes += _ycum[lBegin + lInEnd] - _ycum[lBegin + lInBegin];
+  }
+
+  for(uint j = lFirst; j < lLast; ++j) {
+    if(lInBegin <= j && j < lInEnd) {
+      j = lInEnd - 1;
       continue;
     }
-    if(aRecQuery.yhi() <= e.lo()) {
-      break;
-    }
-
-    // problematic cases:
-    // e.lo() == e.hi()
-    // aXlo() == aXhi()
-    lRecTile.ylo(e.lo());
-    lRecTile.yhi(e.hi());
-    if(aRecQuery.contains(lRecTile)) {
-      const double lEstimate = (double) e.cf();
-      lRes += lEstimate;
-    } else
-    if(e.lo() < e.hi() && aXlo < aXhi) {
-      lRecIsec.isec(aRecQuery, lRecTile);
-      double lEstimate = 0;
-      if(k_matrix == kind()) {
-        lEstimate = _regp[aIdxX * ny() + j].estimate(aRecQuery);
-        lRes += lEstimate;
+    double lEstimate = 0;
+    if(lLo[j] < lHi[j] && aXlo < aXhi) {
+      rectangle_t lRecTile(aXlo, lLo[j], aXhi, lHi[j]);
+      if(aRecQuery.contains(lRecTile)) {
+        lEstimate = (double) _ycf[lBegin + j];
       } else {
-        lEstimate = (lRecIsec.area() / lRecTile.area()) * e.cf();
-        lRes += lEstimate;
-      }
-
-      if(lTrace) {
-        std::cout << "  query rectangle: " << aRecQuery << std::endl;
-        std::cout << "  tile  rectangle: " << lRecTile  << std::endl;
-        std::cout << "  isec  rectangle: " << lRecIsec  << std::endl;
-        std::cout << "  cum   frequency: " << e.cf()    << std::endl;
-        std::cout << "  isec  area     : " << lRecIsec.area() << std::endl;
-        std::cout << "  tile  area     : " << lRecTile.area() << std::endl;
-        std::cout << "  estimate       : " << lEstimate       << std::endl;
+        lEstimate = _regp[aIdxX * ny() + j].estimate(aRecQuery);
       }
     } else {
-      if(e.lo() >= e.hi()) {
-        // not e.hi() <= aRecQuery.ylo()
-        // and
-        // not aRecQuery.yhi() <= e.lo()
-        // and e.lo() >= e.hi()
-        // implies 
-        // aRecQuery.ylo() < e.hi() <= e.lo() < aRecQuery.yhi()
-        // thus: check only on aXlo, aXhi
-        const double lXIsecLo = std::max<double>(aRecQuery.xlo(), aXlo);
-        const double lXIsecHi = std::min<double>(aRecQuery.xhi(), aXhi);
-        const double lEstimate = ((lXIsecHi - lXIsecLo) / (aXhi - aXlo)) * e.cf();
-        lRes += lEstimate;
-        // std::cout << "BOOM Y" << std::endl;
-        // std::cerr << "BOOM Y" << std::endl;
-        // std::cout << "stop: " << "continue!" << std::endl;
-      } else
-      if(aXlo >= aXhi) {
-        const double lYIsecLo = std::max<double>(aRecQuery.ylo(), e.lo());
-        const double lYIsecHi = std::min<double>(aRecQuery.yhi(), e.hi());
-        const double lEstimate = ((lYIsecHi - lYIsecLo) / (e.hi() - e.lo())) * e.cf();
-        lRes += lEstimate;
-        // std::cout << "BOOM X" << std::endl;
-        // std::cerr << "BOOM X" << std::endl;
-        // std::cout << "stop: " << (1/0) << std::endl;
-      }
+      lEstimate = estimateBucket(aRecQuery, aXlo, aXhi, lLo[j], lHi[j], _ycf[lBegin + j]);
+    }
+    lRes += lEstimate;
+    if(lTrace) {
+      std::cout << "  y-bucket " << j << ": [" << lLo[j] << ", " << lHi[j] << "] "
+                << ", cf: " << _ycf[lBegin + j]
+                << ", estimate: " << lEstimate << std::endl;
     }
   }
 
@@ -675,14 +709,7 @@ EqDepHist::estimateYR(const rectangle_t& aRecQuery,
 
 uint
 EqDepHist::outlierCount(const rectangle_t& r) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithin(r);
 }
 
 uint
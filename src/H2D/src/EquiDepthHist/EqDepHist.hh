@@ -7,12 +7,23 @@
 #include "infra/types.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/RegularPartitioning2dim.hh"
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/summaryline.hh"
 
 namespace H2D {
 
+/*
+ * class EqDepHist
+ * the buckets are built into _vx, _vy (entry_t), then copied by initSoA
+ * into boundary arrays for estimation: the x-buckets in _xlo, _xhi and
+ * the y-buckets of all x-buckets one after another in _ylo, _yhi, _ycf
+ * with prefix sums _ycum. the y-buckets of x-bucket i are
+ * [_yBegin[i], _yBegin[i+1]). both bounds are non-decreasing, hence the
+ * y-buckets touched by a query and those fully contained in it are
+ * found by binary search, the latter are summed up from _ycum.
+ */
 
 class EqDepHist : public EstimatorBase2dim {
   public:
@@ -63,6 +74,7 @@ class EqDepHist : public EstimatorBase2dim {
   public:
     virtual double estimate(const rectangle_t& r) const;
     virtual double estimate(const query_t& lQuery) const;
+    virtual void   estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
   public:
     uint   outlierCount(const rectangle_t& r) const;
     // for k_simple
@@ -97,8 +109,14 @@ class EqDepHist : public EstimatorBase2dim {
     void initVx(Data2dim& aData);
     void initVy(Data2dim& aData, const uint aBegin, const uint aEnd, const uint aIdxX);
     void initVyR(Data2dim& aData, const uint aBegin, const uint aEnd, const uint aIdxX);
+    void initSoA();
+    // estimate for y-bucket [aYlo,aYhi] of x-bucket [aXlo,aXhi] not contained in aRecQuery
+    static double estimateBucket(const rectangle_t& aRecQuery,
+                                 const double aXlo, const double aXhi,
+                                 const double aYlo, const double aYhi, const uint aCf);
   private:
     Data2dim   _outlier;
+    OutlierIndex _outlierIndex;
     kind_t     _kind;
     uint       _nx;
     uint       _ny;
@@ -109,6 +127,13 @@ class EqDepHist : public EstimatorBase2dim {
     entry_vvt  _vy;
     regp_at    _regp; // array
     bool       _trace;
+    std::vector<double>   _xlo;    // non-empty x-buckets
+    std::vector<double>   _xhi;
+    std::vector<uint32_t> _yBegin; // y-buckets of x-bucket i: [_yBegin[i], _yBegin[i+1])
+    std::vector<double>   _ylo;
+    std::vector<double>   _yhi;
+    std::vector<uint32_t> _ycf;
+    std::vector<double>   _ycum;   // _ycum[k] = sum of _ycf[0..k)
 };
 
 
@@ -1,7 +1,17 @@
 #include "GxTree.hh"
 
+#include <deque>
+#include <queue>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string.h>
+
 #include "estimate_t.hh"
 #include "encode_t.hh"
+#include "infra/binfile.hh"
 
 namespace H2D {
 
@@ -14,17 +24,22 @@ using namespace Gxt;
  */
 
 
-GxTree::Node::Node(const Data2dim&    aData,
+GxTree::Node::Node(      Data2dim&    aPoints,
+                   const uint         aBegin,
+                   const uint         aEnd,
                    const rectangle_t& aTr,
                    const uint         aLevel,
                    const Node*        aParent,
+                   const uint         aNodeId,
                    const GxTree&      aGxTree)
-               : _data(aData),
+               : _points(aPoints),
+                 _begin(aBegin),
+                 _end(aEnd),
                  _tr(aTr),
                  _br(),
                  _brd(),
                  _brdd(),
-                 _cumFreq(aData.total()),
+                 _cumFreq(aPoints.total(aBegin, aEnd)),
                  _tr_regp16x16(),
                  _br_regp16x16(),
                  _tr_mm2(),
@@ -32,16 +47,16 @@ GxTree::Node::Node(const Data2dim&    aData,
                  _mm3(),
                  _mm5(),
                  _regpPxO(),
-                 _dataPxO(),
+                 _tileBegin(),
                  _childrenPxO(),
                  _level(aLevel),
-                 _nodeId(aGxTree.getNodeId()),
+                 _nodeId(aNodeId),
                  _brCode(0),
                  _hasBr(-1),
                  _anares(),
                  _myEncoding() {
 
-  init(aData, aTr, aParent, aGxTree);
+  init(aTr, aParent, aGxTree);
 
   assert(0 < cumFreq());
 }
@@ -69,11 +84,8 @@ GxTree::Node::expandChild(const uint i, const uint j, const GxTree& aGxTree) {
   }
 
 
-  rectangle_t lChildTile;
-  regpPxO().mkRectangle(i, j, lChildTile);
-  Node* lChildNode = new Node(dataPxO(i,j), lChildTile, level() + 1, this, aGxTree);
-
-  _childrenPxO(i,j) = lChildNode; 
+  Node* lChildNode = newChild(i, j, aGxTree.getNodeId(), aGxTree);
+  linkChild(i, j, lChildNode, aGxTree);
   if(aGxTree.trace()) {
     std::cout << "EXIT: expandChild of " << nodeId() << '@' << level() << ": "
               << "child(" << i << ',' << j << ") = "
@@ -84,17 +96,35 @@ GxTree::Node::expandChild(const uint i, const uint j, const GxTree& aGxTree) {
   return lChildNode; 
 }
 
+GxTree::Node*
+GxTree::Node::newChild(const uint i, const uint j, const uint aNodeId, const GxTree& aGxTree) const {
+  rectangle_t lChildTile;
+  regpPxO().mkRectangle(i, j, lChildTile);
+  return new Node(_points, beginPxO(i,j), endPxO(i,j), lChildTile, level() + 1, this, aNodeId, aGxTree);
+}
+
 void
-GxTree::Node::init(const Data2dim& aData, const rectangle_t& aTr, 
+GxTree::Node::linkChild(const uint i, const uint j, Node* aChild, const GxTree& aGxTree) {
+  _childrenPxO(i,j) = aChild;
+  aGxTree.incNo(aChild->nodeType());
+  if(nodeType() > aChild->nodeType()) {
+    std::cout << "parent " << nodeName(nodeType()) 
+              << " and child " << nodeName(aChild->nodeType())
+              << std::endl;
+  }
+}
+
+void
+GxTree::Node::init(const rectangle_t& aTr, 
                    const Node* aParent, const GxTree& aGxTree) {
   // set cumFreq
-  _cumFreq = aData.total();
+  _cumFreq = data().total(begin(), end());
 
   // set bounding parent tile rectangle
   _tr = aTr; // must have happened in constructor
 
   // set bounding rectangle by data
-  aData.getBoundingRectangle(_br);
+  data().getBoundingRectangle(_br, begin(), end());
 
   // _tr is the outer tile rectangle and is the input
   // for those datapoints falling into _tr, we calculate their true
@@ -105,8 +135,8 @@ GxTree::Node::init(const Data2dim& aData, const rectangle_t& aTr,
   // it can either be _tr or _brd, depending on the node type used.
   // if the node type is not able to hold a brCode, _tr must be used.
 
-  RegularPartitioning2dim lRegP16x16(tr(), 16, 16, aData);
-  _tr_regp16x16.initFromData2dim(tr(), 16, 16, aData);
+  RegularPartitioning2dim lRegP16x16(tr(), 16, 16, data(), begin(), end());
+  _tr_regp16x16.initFromData2dim(tr(), 16, 16, data(), begin(), end());
   _brCode = calcNeedsBr(_tr_regp16x16, &_tr, &_brd);
   _brdd = _brd;  // _brdd possibly changed later on, if br does not fit
 
@@ -139,13 +169,13 @@ GxTree::Node::init(const Data2dim& aData, const rectangle_t& aTr,
   // initialze _regp16x16 using the correct bounding rectangle
   
   if(needsBr()) {
-    _br_regp16x16.initFromData2dim(brd(), 16, 16, aData);
+    _br_regp16x16.initFromData2dim(brd(), 16, 16, data(), begin(), end());
     if(aGxTree.trace()) {
       std::cout << "brd 16x16:" << std::endl;
       br_regp16x16().print(std::cout);
     }
   } else {
-    _br_regp16x16.initFromData2dim(tr(), 16, 16, aData); 
+    _br_regp16x16.initFromData2dim(tr(), 16, 16, data(), begin(), end()); 
   }
 
 
@@ -173,10 +203,8 @@ GxTree::Node::init(const Data2dim& aData, const rectangle_t& aTr,
 
 
 
+  // reported by linkChild
   if((0 != aParent) && (aParent->nodeType() > anares().nodeType())) {
-    std::cout << "parent " << nodeName(aParent->nodeType()) 
-              << " and child " << nodeName(anares().nodeType())
-              << std::endl;
     if(GxTree::K_GLMS != aGxTree.kind()) {
       assert(aParent->nodeType() <= anares().nodeType());
     } else {
@@ -187,17 +215,13 @@ GxTree::Node::init(const Data2dim& aData, const rectangle_t& aTr,
 
   // initialize node depending on its type
   switch(anares().nodeType()) {
-    case N_G: initG(aData, anares(), aGxTree);
-              aGxTree.incNoG();
+    case N_G: initG(anares(), aGxTree);
               break;
-    case N_L: initL(aData, anares(), aGxTree);
-              aGxTree.incNoL();
+    case N_L: initL(anares(), aGxTree);
               break;
-    case N_M: initM(aData, anares(), aGxTree);
-              aGxTree.incNoM();
+    case N_M: initM(anares(), aGxTree);
               break;
-    case N_S: initS(aData, anares(), aGxTree);
-              aGxTree.incNoS();
+    case N_S: initS(anares(), aGxTree);
               break;
     default: std::cerr << "Fatal Error" << std::endl;
              assert(0 == 1);
@@ -234,12 +258,11 @@ GxTree::Node::fill_mm2(      mm2_t&                   aMM2,
 void
 GxTree::Node::fill_mm3(mm3_t&             aMM3,
                        const rectangle_t& aRectangle,
-                       const Data2dim&    aData, 
                        const GxTree&      aGxTree) {
   if(aMM3._filled) {
     return;
   }
-  RegularPartitioning2dim lRegP12x12(aRectangle, 12, 12, aData);
+  RegularPartitioning2dim lRegP12x12(aRectangle, 12, 12, data(), begin(), end());
   for(uint i = 0; i < 12; ++i) {
     for(uint j = 0; j < 12; ++j) {
       aMM3._12x12(i,j) = (uint) lRegP12x12(i,j);
@@ -248,7 +271,7 @@ GxTree::Node::fill_mm3(mm3_t&             aMM3,
   aMM3._6x6.setToShrink2Of(aMM3._12x12);
   aMM3._3x3.setToShrink2Of(aMM3._6x6);
 
-  RegularPartitioning2dim lRegP9x9(aRectangle, 9, 9, aData);
+  RegularPartitioning2dim lRegP9x9(aRectangle, 9, 9, data(), begin(), end());
   for(uint i = 0; i < 9; ++i) {
     for(uint j = 0; j < 9; ++j) {
       aMM3._9x9(i,j) = (uint) lRegP9x9(i,j);
@@ -269,13 +292,12 @@ GxTree::Node::fill_mm3(mm3_t&             aMM3,
 
 void
 GxTree::Node::fill_mm5(mm5_t&          aMM5,
-                       const Data2dim& aData, 
                        const GxTree&   aGxTree) {
   if(aMM5._filled) {
     return;
   }
 
-  RegularPartitioning2dim lRegP20x20(brdd(), 20, 20, aData);
+  RegularPartitioning2dim lRegP20x20(brdd(), 20, 20, data(), begin(), end());
   for(uint i = 0; i < 20; ++i) {
     for(uint j = 0; j < 20; ++j) {
       aMM5._20x20(i,j) = (uint) lRegP20x20(i,j);
@@ -295,9 +317,9 @@ GxTree::Node::fill_mm5(mm5_t&          aMM5,
 
 
 bool
-GxTree::Node::initG(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree) {
+GxTree::Node::initG(const anares_t& aAnaRes, const GxTree& aGxTree) {
   if(5 == aAnaRes.gridType()) {
-    prepare(aData, 5, 5);
+    prepare(5, 5);
   } else {
     assert(5 == aAnaRes.gridType());
   }
@@ -311,9 +333,9 @@ GxTree::Node::initG(const Data2dim& aData, const anares_t& aAnaRes, const GxTree
 }
 
 bool
-GxTree::Node::initL(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree) {
+GxTree::Node::initL(const anares_t& aAnaRes, const GxTree& aGxTree) {
   if(4 == aAnaRes.gridType()) {
-    prepare(aData, 4, 4);
+    prepare(4, 4);
   } else {
     assert(4 == aAnaRes.gridType());
   }
@@ -326,9 +348,9 @@ GxTree::Node::initL(const Data2dim& aData, const anares_t& aAnaRes, const GxTree
 }
 
 bool
-GxTree::Node::initM(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree) {
+GxTree::Node::initM(const anares_t& aAnaRes, const GxTree& aGxTree) {
   if(3 == aAnaRes.gridType()) {
-    prepare(aData, 3, 3);
+    prepare(3, 3);
   } else {
     assert(3 == aAnaRes.gridType());
   }
@@ -342,9 +364,9 @@ GxTree::Node::initM(const Data2dim& aData, const anares_t& aAnaRes, const GxTree
 
 
 bool
-GxTree::Node::initS(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree) {
+GxTree::Node::initS(const anares_t& aAnaRes, const GxTree& aGxTree) {
   if(2 == aAnaRes.gridType()) {
-    prepare(aData,2,2);
+    prepare(2,2);
   } else {
     assert(2 == aAnaRes.gridType());
   }
@@ -353,25 +375,18 @@ GxTree::Node::initS(const Data2dim& aData, const anares_t& aAnaRes, const GxTree
 
 
 void
-GxTree::Node::prepare(const Data2dim& aData, const uint aNx, const uint aNy) {
-  _regpPxO.initFromData2dim(brdd(), aNx, aNy, aData);
- distributeData(aData, aNx, aNy, _dataPxO);
+GxTree::Node::prepare(const uint aNx, const uint aNy) {
+  _regpPxO.initFromData2dim(brdd(), aNx, aNy, data(), begin(), end());
+ distributeData(aNx, aNy);
  _childrenPxO.resize(aNx, aNy);
  clearChildren();
 }
 
 void
-GxTree::Node::distributeData(const Data2dim& aData, const uint aNx, const uint aNy, data2dim_at& aDataArr) {
-  _dataPxO.resize(aNx, aNy);
+GxTree::Node::distributeData(const uint aNx, const uint aNy) {
+  _tileBegin.resize(aNx * aNy + 1);
   partitiondescxy_t  lPdXY(brdd(), aNx, aNy);
-  for(uint i = 0; i < aData.size(); ++i) {
-    const xyc_t& p = aData[i];
-    const uint lIdxX = lPdXY.idxXcorrected(p.x);
-    const uint lIdxY = lPdXY.idxYcorrected(p.y);
-    if(lIdxX < aNx && lIdxY < aNy) {
-      _dataPxO(lIdxX, lIdxY).push_back(p);
-    }
-  }
+  _points.partitionTiles(lPdXY, begin(), end(), _tileBegin.data());
 }
 
 
@@ -430,14 +445,11 @@ GxTree::Node::reconstructBr(      rectangle_t&       aBrOut,
 
 void
 GxTree::Node::insertChildrenIntoHeap(heap_t& aHeap, const GxTree& aGxTree) {
-  if(GxTree::K_GLMS == aGxTree.kind() && _anares._leafEnforced) {
-    return;
-  }
   heapentry_t lHeapEntry;
   lHeapEntry._node = this;
   for(uint i = 0; i < nx(); ++i) {
     for(uint j = 0; j < ny(); ++j) {
-      if(aGxTree.minimumNodeTotal() <= cumFreq(i,j)) {
+      if(isExpandable(i, j, aGxTree)) {
         lHeapEntry._i = i;
         lHeapEntry._j = j;
         aHeap.push(lHeapEntry);
@@ -446,6 +458,14 @@ GxTree::Node::insertChildrenIntoHeap(heap_t& aHeap, const GxTree& aGxTree) {
   }
 }
 
+bool
+GxTree::Node::isExpandable(const uint i, const uint j, const GxTree& aGxTree) const {
+  if(GxTree::K_GLMS == aGxTree.kind() && _anares._leafEnforced) {
+    return false;
+  }
+  return (aGxTree.minimumNodeTotal() <= cumFreq(i,j));
+}
+
 
 double
 GxTree::Node::estimate(const rectangle_t& aQueryRectangle, 
@@ -1032,7 +1052,7 @@ GxTree::Node::analyze(anares_t& aAnaRes, const Node* aParent, const GxTree& aGxT
 
   // if two pointers are a possibility, no BR can be stored
   if(needsBr() && (K_GLMx == aGxTree.gxKind())) {
-    fill_mm3(_mm3, brd(), data(), aGxTree);
+    fill_mm3(_mm3, brd(), aGxTree);
     const uint lNoGtLim2_3x3 = _mm3._3x3.noGt(Node_M_Generic::scaleGrid(0,
                                                    Node_M_Generic::Inner_A1)->limit());
     if((1 >= lNoGtLim2_3x3)) {
@@ -1044,7 +1064,7 @@ GxTree::Node::analyze(anares_t& aAnaRes, const Node* aParent, const GxTree& aGxT
       aAnaRes._brDoesFit = true;
     } else {
       _mm3._filled = false;
-      fill_mm3(_mm3, tr(), data(), aGxTree);
+      fill_mm3(_mm3, tr(), aGxTree);
       const uint lNoGtLim3_3x3 = _mm3._3x3.noGt(lLim3);
       const uint lNoGtLim3_9x9 = _mm3._9x9.noGt(lLim3); // see comment below
       if(1 >= lNoGtLim3_3x3 && (1 >= lNoGtLim3_9x9)) {
@@ -1057,7 +1077,7 @@ GxTree::Node::analyze(anares_t& aAnaRes, const Node* aParent, const GxTree& aGxT
       }
     }
   } else {
-    fill_mm3(_mm3, tr(), data(), aGxTree);
+    fill_mm3(_mm3, tr(), aGxTree);
     if(K_GLMx == aGxTree.gxKind()) {
       const uint lNoGtLim3_3x3   = _mm3._3x3.noGt(lLim3);   // for M without BR
       const uint lNoGtLim3_9x9   = _mm3._9x9.noGt(lLim3);   // for M without BR
@@ -1209,7 +1229,7 @@ GxTree::Node::print(std::ostream& os) const {
 
   const bool lWithPartitionings = false;
   if(lWithPartitionings) {
-    RegularPartitioning2dim lRegPXX(brd(), 60, 60, data());
+    RegularPartitioning2dim lRegPXX(brd(), 60, 60, data(), begin(), end());
 
     os << "2x2:" << std::endl;
     printPxO(os, 2, 2, &lRegPXX);
@@ -1260,7 +1280,7 @@ GxTree::Node::print(std::ostream& os) const {
 
 void
 GxTree::Node::printPxO(std::ostream& os, const uint aNx, const uint aNy, const RegularPartitioning2dim* aRegP) const {
-  RegularPartitioning2dim lRegP(brd(), aNx, aNy, data());
+  RegularPartitioning2dim lRegP(brd(), aNx, aNy, data(), begin(), end());
   lRegP.matrix().print(os, 4);
   if(0 != aRegP) {
     std::cout << "QERROR: " << maxQError(*aRegP, lRegP) << std::endl;
@@ -1393,10 +1413,179 @@ GxTree::node_encoding_t::noChildPtr() const {
 }
 
 
+/*
+ * nodebuilder_t
+ * builds the child nodes of the tiles pushed into the heap of GxTree::init
+ * ahead of time on aNoWorkers threads, largest cumFreq first, i.e. about in
+ * the order in which GxTree::init expands them. take returns the node of a
+ * tile, built by a worker or, if no worker has started on it, by the caller.
+ * building a node only reads its parent and permutes the points of its
+ * tile, the order in which the tiles are built does not matter.
+ * a worker starts a node only while less than k_max_ahead_per_worker nodes
+ * per worker have been started ahead of take. nodes never taken are deleted
+ * by the destructor.
+ */
+
+namespace {
+
+class nodebuilder_t {
+  public:
+    typedef GxTree::Node Node;
+    static constexpr uint k_max_ahead_per_worker = 4;
+  private:
+    nodebuilder_t(const nodebuilder_t&);
+    nodebuilder_t& operator=(const nodebuilder_t&);
+  public:
+    nodebuilder_t(const GxTree& aGxTree, const uint aNoWorkers);
+    ~nodebuilder_t();
+  public:
+    // queue the expandable tiles of aNode
+    void  schedule(Node* aNode);
+    Node* take(Node* aParent, const uint i, const uint j);
+  private:
+    enum state_t {
+      k_idle    = 0, // not expandable
+      k_queued  = 1,
+      k_running = 2,
+      k_done    = 3,
+      k_taken   = 4
+    };
+    struct task_t {
+      Node*   _parent;
+      Node*   _node;
+      uint    _i;
+      uint    _j;
+      state_t _state;
+    };
+    struct pending_t {
+      double _cumFreq;
+      size_t _task;
+    };
+    class CMPPending {
+      public:
+        bool operator()(const pending_t& x, const pending_t& y) const {
+               return ((x._cumFreq < y._cumFreq) ||
+                       ((x._cumFreq == y._cumFreq) && (x._task > y._task)));
+             }
+    };
+    typedef std::priority_queue<pending_t, std::vector<pending_t>, CMPPending> pending_pq_t;
+  private:
+    void work();
+  private:
+    const GxTree&                           _gxtree;
+    const uint                              _maxAhead;
+    std::mutex                              _mutex;
+    std::condition_variable                 _cvWork; // worker: task pending or stop
+    std::condition_variable                 _cvDone; // take: task done
+    std::deque<task_t>                      _task;
+    std::unordered_map<const Node*, size_t> _firstTask; // tile (i,j) of node: _task[_firstTask + i * cny + j]
+    pending_pq_t                            _pending;
+    uint                                    _noAhead; // started by a worker, not taken
+    bool                                    _stop;
+    std::vector<std::thread>                _worker;
+};
+
+nodebuilder_t::nodebuilder_t(const GxTree& aGxTree, const uint aNoWorkers)
+              : _gxtree(aGxTree),
+                _maxAhead(k_max_ahead_per_worker * aNoWorkers),
+                _mutex(), _cvWork(), _cvDone(),
+                _task(), _firstTask(), _pending(),
+                _noAhead(0),
+                _stop(false),
+                _worker() {
+  _worker.reserve(aNoWorkers);
+  for(uint k = 0; k < aNoWorkers; ++k) {
+    _worker.emplace_back([this] () { work(); });
+  }
+}
+
+nodebuilder_t::~nodebuilder_t() {
+  {
+    std::lock_guard<std::mutex> lLock(_mutex);
+    _stop = true;
+  }
+  _cvWork.notify_all();
+  for(auto& lWorker : _worker) {
+    lWorker.join();
+  }
+  for(const task_t& lTask : _task) {
+    if(k_done == lTask._state) {
+      delete lTask._node;
+    }
+  }
+}
+
+void
+nodebuilder_t::schedule(Node* aNode) {
+  {
+    std::lock_guard<std::mutex> lLock(_mutex);
+    _firstTask[aNode] = _task.size();
+    for(uint i = 0; i < aNode->cnx(); ++i) {
+      for(uint j = 0; j < aNode->cny(); ++j) {
+        const bool lExpandable = aNode->isExpandable(i, j, _gxtree);
+        _task.push_back(task_t{aNode, 0, i, j, (lExpandable ? k_queued : k_idle)});
+        if(lExpandable) {
+          _pending.push(pending_t{aNode->cumFreq(i, j), _task.size() - 1});
+        }
+      }
+    }
+  }
+  _cvWork.notify_all();
+}
+
+nodebuilder_t::Node*
+nodebuilder_t::take(Node* aParent, const uint i, const uint j) {
+  std::unique_lock<std::mutex> lLock(_mutex);
+  task_t& lTask = _task[_firstTask[aParent] + i * aParent->cny() + j];
+  assert(k_idle != lTask._state && k_taken != lTask._state);
+  if(k_queued == lTask._state) {
+    lTask._state = k_running;
+    lLock.unlock();
+    Node* lNode = aParent->newChild(i, j, 0, _gxtree);
+    lLock.lock();
+    lTask._node = lNode;
+  } else {
+    _cvDone.wait(lLock, [&lTask] () { return (k_done == lTask._state); });
+    --_noAhead;
+    _cvWork.notify_one();
+  }
+  lTask._state = k_taken;
+  return lTask._node;
+}
+
+void
+nodebuilder_t::work() {
+  std::unique_lock<std::mutex> lLock(_mutex);
+  while(true) {
+    _cvWork.wait(lLock, [this] () { return (_stop || (!_pending.empty() && _noAhead < _maxAhead)); });
+    if(_stop) {
+      return;
+    }
+    task_t& lTask = _task[_pending.top()._task];
+    _pending.pop();
+    if(k_queued != lTask._state) {
+      continue; // taken by take
+    }
+    lTask._state = k_running;
+    ++_noAhead;
+    lLock.unlock();
+    Node* lNode = lTask._parent->newChild(lTask._i, lTask._j, 0, _gxtree);
+    lLock.lock();
+    lTask._node  = lNode;
+    lTask._state = k_done;
+    _cvDone.notify_all();
+  }
+}
+
+} // end anonymous namespace
+
+
 /* 
  *   GxTree members 
  */
 
+uint GxTree::_noBuildThreads = 1;
+
 GxTree::GxTree(const Data2dim& aData,
                const gx_kind_t aGxKind,
                const uint      aBudget,
@@ -1408,6 +1597,8 @@ GxTree::GxTree(const Data2dim& aData,
                const double    aTheta,
                const bool      aTrace) : EstimatorBase2dim(aQ, aTheta),
                                          _outlier(),
+                                         _outlierIndex(),
+                                         _points(),
                                          _br(),
                                          _gxKind(aGxKind),
                                          _budget(aBudget),
@@ -1460,19 +1651,29 @@ GxTree::~GxTree() {
 
 void
 GxTree::init(const Data2dim& aData) {
-  Data2dim lRegular;
   if(8 < phi()) {
+    Data2dim lRegular;
     aData.split(lRegular, _outlier, phi());
+    _outlierIndex.init(_outlier);
+    lRegular.getBoundingRectangle(_br);
   } else {
-    lRegular = aData;
+    aData.getBoundingRectangle(_br);
   }
 
-  lRegular.getBoundingRectangle(_br);
+  _points = aData;
 
   heap_t lHeap;
-  _root = new Node(aData, br(), 0, 0, (*this));
+  _root = new Node(_points, 0, _points.size(), br(), 0, 0, getNodeId(), (*this));
+  incNo(_root->nodeType());
   _root->insertChildrenIntoHeap(lHeap, (*this));
 
+  // trace output needs the serial order of construction
+  std::unique_ptr<nodebuilder_t> lBuilder;
+  if(1 < noBuildThreads() && !trace()) {
+    lBuilder.reset(new nodebuilder_t((*this), noBuildThreads() - 1));
+    lBuilder->schedule(_root);
+  }
+
   uint lTotalSize = root()->size();
 
   if(trace()) {
@@ -1484,10 +1685,18 @@ GxTree::init(const Data2dim& aData) {
         (65500 > _nodeCountL)   && 
         (65500 > _nodeCountM)   &&
         (65500 > _nodeCountS) ) {
-    const heapentry_t& lTop = lHeap.top();
+    const heapentry_t lTop = lHeap.top();
     lHeap.pop();
     _minSplit = lTop._node->cumFreq(lTop._i, lTop._j);
-    Node* lChildNode = lTop._node->expandChild(lTop._i, lTop._j, (*this));
+    Node* lChildNode = 0;
+    if(lBuilder) {
+      lChildNode = lBuilder->take(lTop._node, lTop._i, lTop._j);
+      lChildNode->_nodeId = getNodeId();
+      lTop._node->linkChild(lTop._i, lTop._j, lChildNode, (*this));
+      lBuilder->schedule(lChildNode);
+    } else {
+      lChildNode = lTop._node->expandChild(lTop._i, lTop._j, (*this));
+    }
     lTotalSize += lChildNode->size();
     lChildNode->insertChildrenIntoHeap(lHeap, (*this));
     if(trace()) {
@@ -1538,16 +1747,20 @@ GxTree::estimate(const query_t& lQuery) const {
 
 
 
+void
+GxTree::incNo(const node_type_t aNodeType) const {
+  switch(aNodeType) {
+    case N_G: incNoG(); break;
+    case N_L: incNoL(); break;
+    case N_M: incNoM(); break;
+    case N_S: incNoS(); break;
+    default: assert(0 == 1);
+  }
+}
+
 uint
 GxTree::outlierCount(const rectangle_t& r) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithin(r);
 }
 
 
@@ -3735,7 +3948,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                   } else {
                     const uint lMaxTF5x5 = _regpPxO.max();
                     _mm3._filled = false;
-                    fill_mm3(_mm3, brdd(), data(), aGxTree);
+                    fill_mm3(_mm3, brdd(), aGxTree);
                     const uint lMaxTF6x6 = _mm3._6x6.max();
 
                     Node_G_Leaf_T lSubKind  = N_G_L_A;
@@ -3748,7 +3961,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                     }
 
                     if(2 <= aGxTree.leafRefinement()) {
-                       RegularPartitioning2dim lRegP7x7(brdd(), 7, 7, data());
+                       RegularPartitioning2dim lRegP7x7(brdd(), 7, 7, data(), begin(), end());
                        const uint lMaxTF7x7 = lRegP7x7.max();
                        if((lMaxTF7x7 <  (lLrf * lMinMaxTF)) && 
                           (lMaxTF7x7 <= Node_G_Generic::_scaleGrid[Node_G_Generic::Leaf_C]->limit())) {
@@ -3780,13 +3993,13 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                       case N_G_L_A:
                                     break;
                       case N_G_L_B:
-                                    _regpPxO.initFromData2dim(brdd(), 6, 6, data());
+                                    _regpPxO.initFromData2dim(brdd(), 6, 6, data(), begin(), end());
                                     break;
                       case N_G_L_C:
-                                    _regpPxO.initFromData2dim(brdd(), 7, 7, data());
+                                    _regpPxO.initFromData2dim(brdd(), 7, 7, data(), begin(), end());
                                     break;
                       case N_G_L_D:
-                                    _regpPxO.initFromData2dim(brdd(), 8, 8, data());
+                                    _regpPxO.initFromData2dim(brdd(), 8, 8, data(), begin(), end());
                                     break;
                       default: assert(0 == 1);
                                break;
@@ -3832,7 +4045,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                     Node_G_Leaf_T lSubKind  = N_G_L_A;
 
                     if(1 <= aGxTree.leafRefinement()) {
-                      RegularPartitioning2dim lRegP5x5(brdd(), 5, 5, data());
+                      RegularPartitioning2dim lRegP5x5(brdd(), 5, 5, data(), begin(), end());
                       uint lNkf = (hasBr() ? Gxt::Node_L_Generic::Leaf_B1
                                            : Gxt::Node_L_Generic::Leaf_B2);
                       uint lMaxTF5x5 = lRegP5x5.max();
@@ -3844,7 +4057,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                     }
 
                     if(2 <= aGxTree.leafRefinement()) {
-                      RegularPartitioning2dim lRegP6x6(brdd(), 6, 6, data());
+                      RegularPartitioning2dim lRegP6x6(brdd(), 6, 6, data(), begin(), end());
                       uint lNkf = (hasBr() ? Gxt::Node_L_Generic::Leaf_C1
                                            : Gxt::Node_L_Generic::Leaf_C2);
                       uint lMaxTF6x6 = lRegP6x6.max();
@@ -3863,10 +4076,10 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                       case N_L_L_A:
                                     break;
                       case N_L_L_B:
-                                    _regpPxO.initFromData2dim(brdd(), 5, 5, data());
+                                    _regpPxO.initFromData2dim(brdd(), 5, 5, data(), begin(), end());
                                     break;
                       case N_L_L_C:
-                                    _regpPxO.initFromData2dim(brdd(), 6, 6, data());
+                                    _regpPxO.initFromData2dim(brdd(), 6, 6, data(), begin(), end());
                                     break;
                      default: assert(0 == 1);
                               break;
@@ -3926,7 +4139,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                         _myEncoding._nodeType._subkind = N_M_L_B;
                         lMinMaxTF = lMaxTF4x4;
                         if(2 <= aGxTree.leafRefinement()) {
-                          RegularPartitioning2dim lRegP5x5(brdd(), 5, 5, data());
+                          RegularPartitioning2dim lRegP5x5(brdd(), 5, 5, data(), begin(), end());
                           const uint lMaxTF5x5 = lRegP5x5.max();
                           if((lMaxTF5x5 <= Node_M_Generic::_scaleGrid[0][Node_M_Generic::Leaf_C2]->limit())
                             && (lMaxTF5x5 < (lLrf * lMinMaxTF))) {
@@ -3946,10 +4159,10 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                     case N_M_L_A:
                                   break;
                     case N_M_L_B: 
-                                  _regpPxO.initFromData2dim(brdd(), 4, 4, data());
+                                  _regpPxO.initFromData2dim(brdd(), 4, 4, data(), begin(), end());
                                   break;
                     case N_M_L_C:
-                                  _regpPxO.initFromData2dim(brdd(), 5, 5, data());
+                                  _regpPxO.initFromData2dim(brdd(), 5, 5, data(), begin(), end());
                                   break;
                     default: assert(0 == 1);
                              break;
@@ -4007,7 +4220,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
 
                     if(1 <= aGxTree.leafRefinement()) {
                       _mm3._filled = false;
-                      fill_mm3(_mm3, tr(), data(), aGxTree);
+                      fill_mm3(_mm3, tr(), aGxTree);
                       const uint lMax3x3 = _mm3._3x3.max();
                       if( (lMax3x3 <= Node_S_Generic::scaleGrid(
                                       Node_S_Generic::Leaf_B2)->limit())
@@ -4029,7 +4242,7 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                     _brdd = tr();
                     if(1 <= aGxTree.leafRefinement()) {
                       _mm3._filled = false;
-                      fill_mm3(_mm3, tr(), data(), aGxTree);
+                      fill_mm3(_mm3, tr(), aGxTree);
                       const uint lMax3x3 = _mm3._3x3.max();
                       if( (lMax3x3 <= Node_S_Generic::scaleGrid(
                                       Node_S_Generic::Leaf_B2)->limit())
@@ -4042,10 +4255,10 @@ GxTree::Node::determineDetailedNodeType(const GxTree& aGxTree) {
                   // need to adjust _regpPxO
                   switch(_myEncoding._nodeType._subkind) {
                     case N_S_L_A:
-                             // _regpPxO.initFromData2dim(brdd(), 2, 2, data());
+                             // _regpPxO.initFromData2dim(brdd(), 2, 2, data(), begin(), end());
                              break;
                     case N_S_L_B: 
-                             _regpPxO.initFromData2dim(brdd(), 3, 3, data());
+                             _regpPxO.initFromData2dim(brdd(), 3, 3, data(), begin(), end());
                              break;
                     default: assert(0 == 1);
                              break;
@@ -4123,34 +4336,154 @@ GxTree::print_name_param(std::ostream& os) const {
   return os;
 } 
 
+/*
+ *   synopsis files
+ *   sections: 0 synopsis_info_t, 1..4 node arrays indexed by node_type_t + 1,
+ *             5..7 outliers
+ */
+
+bool
+GxTree::synopsis_info_t::sameParameters(const gx_kind_t aGxKind,
+                                        const uint      aBudget,
+                                        const int       aLeafRefinement,
+                                        const double    aLrf,
+                                        const uint      aPhi,
+                                        const double    aQ,
+                                        const double    aTheta) const {
+  return ((uint32_t) aGxKind == _gxKind) &&
+         (aBudget == _budget) &&
+         (aLeafRefinement == _leafRefinement) &&
+         (aLrf == _lrf) &&
+         (aPhi == _phi) &&
+         (aQ == _q) &&
+         (aTheta == _theta);
+}
+
+bool
+GxTree::synopsis_info_t::sameNodeSizes() const {
+  return (sizeof(Gxt::Node_G_Generic) == _nodeSize[N_G]) &&
+         (sizeof(Gxt::Node_L_Generic) == _nodeSize[N_L]) &&
+         (sizeof(Gxt::Node_M_Generic) == _nodeSize[N_M]) &&
+         (sizeof(Gxt::Node_S_Generic) == _nodeSize[N_S]);
+}
+
+GxTree::synopsis_info_t
+GxTree::synopsisInfo() const {
+  synopsis_info_t lInfo;
+  memset(&lInfo, 0, sizeof(lInfo));
+  lInfo._topBr[0] = _encoding._topBr.xlo();
+  lInfo._topBr[1] = _encoding._topBr.ylo();
+  lInfo._topBr[2] = _encoding._topBr.xhi();
+  lInfo._topBr[3] = _encoding._topBr.yhi();
+  lInfo._lrf      = lrf();
+  lInfo._q        = q();
+  lInfo._theta    = theta();
+  for(uint i = 0; i < 4; ++i) {
+    lInfo._no[i] = _encoding._no[i];
+  }
+  lInfo._rootType = _encoding._rootType;
+  lInfo._gxKind   = _encoding._gxKind;
+  lInfo._nodeSize[N_G] = sizeof(Gxt::Node_G_Generic);
+  lInfo._nodeSize[N_L] = sizeof(Gxt::Node_L_Generic);
+  lInfo._nodeSize[N_M] = sizeof(Gxt::Node_M_Generic);
+  lInfo._nodeSize[N_S] = sizeof(Gxt::Node_S_Generic);
+  lInfo._budget         = budget();
+  lInfo._leafRefinement = leafRefinement();
+  lInfo._phi            = phi();
+  lInfo._size           = size();
+  lInfo._depth          = depth();
+  lInfo._noNodes        = noNodes();
+  lInfo._noGNodes       = noGNodes();
+  lInfo._minSplit       = minSplit();
+  lInfo._maxUnsplit     = maxUnsplit();
+  lInfo._noOutlier      = noOutlier();
+  return lInfo;
+}
+
+bool
+GxTree::save(const std::string& aFilename, const double aConstructionTime) const {
+  assert(Gxt::N_NO_TYPE != _encoding._rootType); // encode first
+  synopsis_info_t lInfo = synopsisInfo();
+  lInfo._constructionTime = aConstructionTime;
+  SynopsisWriter lWriter(H2D_GXTREE);
+  lWriter.add(&lInfo, 1);
+  lWriter.add(_encoding._G, _encoding._no[N_G]);
+  lWriter.add(_encoding._L, _encoding._no[N_L]);
+  lWriter.add(_encoding._M, _encoding._no[N_M]);
+  lWriter.add(_encoding._S, _encoding._no[N_S]);
+  lWriter.add(outlier());
+  return lWriter.write(aFilename);
+}
+
 
 /*
  *   GxTreeItp
  */
 
-// aligned according to node_type_t
-GxTreeItp::estfun_t  GxTreeItp::_estfun[4] = { &GxTreeItp::estimateG,
-                                               &GxTreeItp::estimateL,
-                                               &GxTreeItp::estimateM,
-                                               &GxTreeItp::estimateS };
-
 GxTreeItp::GxTreeItp(const Data2dim&   aOutlier,
                      const encoding_t& aGxTreeEncoding,
                      const bool        aTrace)
-          : EstimatorBase2dim(), _outlier(aOutlier), _encoding(aGxTreeEncoding), _trace(aTrace) {
+          : EstimatorBase2dim(), _outlier(aOutlier), _outlierIndex(aOutlier), _encoding(aGxTreeEncoding), _trace(aTrace),
+            _synfile(0) {
 }
 
 GxTreeItp::~GxTreeItp() {
+  delete _synfile;
+}
+
+// the mapping is read only, the node arrays are never written through _encoding
+template<typename T>
+static T*
+synopsis_nodes(const SynopsisFile& aFile, const uint aSection, const size_t aNo, bool& aOk) {
+  size_t n = 0;
+  const T* lRes = aFile.array<T>(aSection, n);
+  aOk = aOk && (0 != lRes) && (aNo == n);
+  return const_cast<T*>(lRes);
+}
+
+GxTreeItp*
+GxTreeItp::load(const std::string& aFilename,
+                synopsis_info_t&   aInfoOut,
+                const bool         aTrace) {
+  SynopsisFile* lFile = new SynopsisFile();
+  size_t n = 0;
+  const synopsis_info_t* lInfo = 0;
+  bool lOk = lFile->open(aFilename, H2D_GXTREE) && (8 == lFile->noSection());
+  if(lOk) {
+    lInfo = lFile->array<synopsis_info_t>(0, n);
+    lOk = (0 != lInfo) && (1 == n) && lInfo->sameNodeSizes() && (Gxt::N_S >= lInfo->_rootType);
+  }
+  encoding_t lEncoding;
+  if(lOk) {
+    lEncoding._topBr = rectangle_t(lInfo->_topBr[0], lInfo->_topBr[1], lInfo->_topBr[2], lInfo->_topBr[3]);
+    for(uint i = 0; i < 4; ++i) {
+      lEncoding._no[i] = lInfo->_no[i];
+    }
+    lEncoding._G = synopsis_nodes<Gxt::Node_G_Generic>(*lFile, 1 + Gxt::N_G, lInfo->_no[Gxt::N_G], lOk);
+    lEncoding._L = synopsis_nodes<Gxt::Node_L_Generic>(*lFile, 1 + Gxt::N_L, lInfo->_no[Gxt::N_L], lOk);
+    lEncoding._M = synopsis_nodes<Gxt::Node_M_Generic>(*lFile, 1 + Gxt::N_M, lInfo->_no[Gxt::N_M], lOk);
+    lEncoding._S = synopsis_nodes<Gxt::Node_S_Generic>(*lFile, 1 + Gxt::N_S, lInfo->_no[Gxt::N_S], lOk);
+    lEncoding._rootType = (node_type_t) lInfo->_rootType;
+    lEncoding._gxKind   = (GxTree::gx_kind_t) lInfo->_gxKind;
+    lOk = lOk && (0 < lInfo->_no[lInfo->_rootType]);
+  }
+  Data2dim lOutlier;
+  lOk = lOk && lFile->get(5, lOutlier) && (lInfo->_noOutlier == lOutlier.size());
+  if(!lOk) {
+    delete lFile;
+    return 0;
+  }
+  aInfoOut = (*lInfo);
+  GxTreeItp* lRes = new GxTreeItp(lOutlier, lEncoding, aTrace);
+  lRes->_synfile = lFile;
+  return lRes;
 }
 
 double
 GxTreeItp::estimate(const rectangle_t& aQueryRectangle) const {
-  double lRes = 0;
-  lRes = estimate(aQueryRectangle,
-                  _encoding._topBr,
-                  0,
-                  _encoding._rootType,
-                  0);
+  itp_stack_t lStack;
+  lStack.push(_encoding._topBr, 0, _encoding._rootType, 0);
+  double lRes = estimate(aQueryRectangle, lStack);
   lRes += (double) outlierCount(aQueryRectangle);
   // const double lMinTheta = std::min<double>(theta(), 1000.0);
   // return ((lRes < lMinTheta) ? lMinTheta : lRes);
@@ -4164,123 +4497,100 @@ GxTreeItp::estimate(const query_t& lQuery) const {
   return estimate(aQueryRectangle);
 }
 
+void
+GxTreeItp::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  std::vector<uint> lOutlierCount(aN);
+  for(size_t i = 0; i < aN; ++i) {
+    lOutlierCount[i] = outlierCount(aBegin[i].rectangle());
+  }
+  itp_stack_t lStack; // empty again after every query
+  for(size_t i = 0; i < aN; ++i) {
+    lStack.push(_encoding._topBr, 0, _encoding._rootType, 0);
+    double lRes = estimate(aBegin[i].rectangle(), lStack);
+    lRes += (double) lOutlierCount[i];
+    aEstOut[i] = std::max<double>(1.0, lRes);
+  }
+}
+
 double
 GxTreeItp::estimate(const rectangle_t& aQueryRectangle,
                     const rectangle_t& aTileRectangle,
                     const uint         aIdx,
                     const node_type_t  aNodeType,
                     const uint         aLevel) const {
+  itp_stack_t lStack;
+  lStack.push(aTileRectangle, aIdx, aNodeType, aLevel);
+  return estimate(aQueryRectangle, lStack);
+}
+
+double
+GxTreeItp::estimate(const rectangle_t& aQueryRectangle,
+                    itp_stack_t&       aStack) const {
+  double lRes = 0;
+  while(!aStack.empty()) {
+    const itp_frame_t lFrame = aStack.pop();
+    lRes += estimateNode(aQueryRectangle, lFrame, aStack);
+  }
+  return lRes;
+}
+
+// estimate of the tiles of a single node, its children
+// are either settled by descend or pushed onto aStack
+double
+GxTreeItp::estimateNode(const rectangle_t& aQueryRectangle,
+                        const itp_frame_t& aFrame,
+                        itp_stack_t&       aStack) const {
+  const uint        lIdx      = aFrame._idx;
+  const node_type_t lNodeType = aFrame._type;
+  const uint        lLevel    = aFrame._level;
+  const rectangle_t lTile     = aFrame.tile();
   double lRes = 0;
   if(trace()) {
-    std::cout << std::string(2 * aLevel, ' ') 
+    std::cout << std::string(2 * lLevel, ' ') 
               << "GxTreeItp::estimate " 
-              << aIdx << '@' << aLevel 
-              << " of type " << aNodeType
+              << lIdx << '@' << lLevel 
+              << " of type " << lNodeType
               << std::endl;
   }
-  if(aIdx >= _encoding._no[aNodeType]) {
-    std::cout << "GxTreeItp: idx out of range: idx = " << aIdx << std::endl
-              << "                             _no = " <<  _encoding._no[aNodeType] << std::endl
-              << "                        nodetype = " << aNodeType << std::endl
+  if(lIdx >= _encoding._no[lNodeType]) {
+    std::cout << "GxTreeItp: idx out of range: idx = " << lIdx << std::endl
+              << "                             _no = " <<  _encoding._no[lNodeType] << std::endl
+              << "                        nodetype = " << lNodeType << std::endl
               << "                           query = " << aQueryRectangle
               << std::endl;
   }
 
-  assert(aIdx < _encoding._no[aNodeType]);   // XXX YYY
+  assert(lIdx < _encoding._no[lNodeType]);   // XXX YYY
 
-  lRes = (this->*_estfun[aNodeType])(aQueryRectangle,
-                                     aTileRectangle,
-                                     aIdx,
-                                     aLevel);
+  switch(lNodeType) {
+    case N_G: lRes = _encoding._G[lIdx].estimate(aQueryRectangle, lTile, (*this), aStack, trace(), lIdx, lLevel);
+              break;
+    case N_L: lRes = _encoding._L[lIdx].estimate(aQueryRectangle, lTile, (*this), aStack, trace(), lIdx, lLevel);
+              break;
+    case N_M: lRes = _encoding._M[lIdx].estimate(aQueryRectangle, lTile, (*this), aStack, trace(), lIdx, lLevel);
+              break;
+    case N_S: lRes = _encoding._S[lIdx].estimate(aQueryRectangle, lTile, (*this), aStack, trace(), lIdx, lLevel);
+              break;
+    default:  assert(0 == 1);
+              break;
+  }
 
   if(trace()) {
-    std::cout << std::string(2 * aLevel, ' ') << "GxTreeItp::estimate " 
-              << aIdx << '@' << aLevel 
-              << " of type " << aNodeType
+    std::cout << std::string(2 * lLevel, ' ') << "GxTreeItp::estimate " 
+              << lIdx << '@' << lLevel 
+              << " of type " << lNodeType
               << " returns " << lRes
+              << " (without the children left on the stack)"
               << std::endl;
   }
 
   return lRes;
 }
 
-double
-GxTreeItp::estimateG(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aIdx,
-                     const uint         aLevel) const {
-  double lRes = 0;
-  Node_G_Generic& lNodeGG = (_encoding._G[aIdx]);
-
-  lRes = lNodeGG.estimate(aQueryRectangle,
-                          aTileRectangle,
-                          (*this),
-                          trace(),
-                          aIdx,
-                          aLevel);
-
-  return lRes;
-}
-
-double
-GxTreeItp::estimateL(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aNodeIdx,
-                     const uint         aLevel) const {
-  double lRes = 0;
-  Node_L_Generic& lNode = (_encoding._L[aNodeIdx]);
-  lRes = lNode.estimate(aQueryRectangle,
-                        aTileRectangle,
-                        (*this),
-                        trace(),
-                        aNodeIdx,
-                        aLevel);
-  return lRes;
-}
-
-double
-GxTreeItp::estimateM(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aNodeIdx,
-                     const uint         aLevel) const {
-  double lRes = 0;
-  Node_M_Generic& lNode = (_encoding._M[aNodeIdx]);
-  lRes = lNode.estimate(aQueryRectangle,
-                        aTileRectangle,
-                        (*this),
-                        trace(),
-                        aNodeIdx,
-                        aLevel);
-  return lRes;
-}
-
-double
-GxTreeItp::estimateS(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aNodeIdx,
-                     const uint         aLevel) const {
-  double lRes = 0;
-  Node_S_Generic& lNode = (_encoding._S[aNodeIdx]);
-  lRes = lNode.estimate(aQueryRectangle,
-                        aTileRectangle,
-                        (*this),
-                        trace(),
-                        aNodeIdx,
-                        aLevel);
-  return lRes;
-}
-
 
 uint
 GxTreeItp::outlierCount(const rectangle_t& r) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithin(r);
 }
 
 
@@ -13,6 +13,7 @@
 #include "infra/types.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/RegularPartitioning2dim.hh"
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/summaryline.hh"
@@ -29,6 +30,17 @@
 /*
  * GxTree
  * new version of GxTree
+ * the Nodes reference ranges [begin, end) of _points, a copy of the data.
+ * prepare permutes the range of a node in place such that the points of
+ * tile (i,j) of its PxO grid form the range of child (i,j).
+ * with noBuildThreads() > 1 (and no trace), init expands the tiles in the
+ * same order as serially, but the child nodes are built ahead of time by
+ * worker threads (nodebuilder_t in GxTree.cc). node ids and node type
+ * counts are assigned when a child is linked into the tree, hence tree and
+ * encoding are those of the serial build.
+ * save writes the encoding and the outliers to a synopsis file
+ * (infra/binfile.hh), GxTreeItp::load maps such a file and estimates
+ * directly on the mapped node arrays.
  */
 
 // general abbreviations:
@@ -41,6 +53,7 @@
 
 namespace H2D {
 
+class SynopsisFile;
 
 class GxTree : public EstimatorBase2dim {
   public:
@@ -156,6 +169,40 @@ class GxTree : public EstimatorBase2dim {
                      _gxKind(K_NO_KIND) {}
     };
 
+    // section 0 of a synopsis file of a GxTree, followed by the
+    // G, L, M, S node arrays and the outliers (x, y, c)
+    // no padding: the bytes written are fully defined
+    struct synopsis_info_t {
+      double   _topBr[4];    // xlo, ylo, xhi, yhi
+      double   _lrf;
+      double   _q;
+      double   _theta;
+      double   _constructionTime; // in seconds, as given to save
+      uint32_t _no[4];
+      uint32_t _rootType;
+      uint32_t _gxKind;
+      uint32_t _nodeSize[4]; // sizeof Node_?_Generic at save time
+      uint32_t _budget;      // construction parameters
+       int32_t _leafRefinement;
+      uint32_t _phi;
+      uint32_t _size;        // statistics of the GxTree
+      uint32_t _depth;
+      uint32_t _noNodes;
+      uint32_t _noGNodes;
+      uint32_t _minSplit;
+      uint32_t _maxUnsplit;
+      uint32_t _noOutlier;
+      // the minimumNodeTotal argument is not compared, construction does not use it
+      bool sameParameters(const gx_kind_t aGxKind,
+                          const uint      aBudget,
+                          const int       aLeafRefinement,
+                          const double    aLrf,
+                          const uint      aPhi,
+                          const double    aQ,
+                          const double    aTheta) const;
+      bool sameNodeSizes() const;
+    };
+
     // struct used as argument to prepareEncoding
     struct encode_arg_t {
       uint _childCount[4];   // count number of children
@@ -197,7 +244,6 @@ class GxTree : public EstimatorBase2dim {
 
     class Node {
       public:
-        typedef array_tt<Data2dim> data2dim_at;
         typedef array_tt<Node*> node_at;
         typedef array_tt<RegularPartitioning2dim> regp_at;
       private:
@@ -205,14 +251,19 @@ class GxTree : public EstimatorBase2dim {
         Node(const Node&);
         Node& operator=(const Node&);
       public:
-        Node(const Data2dim&    aData, 
+        Node(      Data2dim&    aPoints,
+             const uint         aBegin,
+             const uint         aEnd,
              const rectangle_t& aTr, // bouding tile rectangle from parent
              const uint         aLevel,
              const Node*        aParent,
+             const uint         aNodeId,
              const GxTree&      aGxTree);
         ~Node();
       public:
-        inline const Data2dim&    data() const { return _data; } // input data
+        inline const Data2dim&    data() const { return _points; } // points of the GxTree
+        inline       uint         begin() const { return _begin; } // this node: data()[begin(), end())
+        inline       uint         end() const { return _end; }
         inline const rectangle_t& tr() const { return _tr; } // tile rectangle
         inline const rectangle_t& br() const { return _br; } // bounding rectangle, reconstructed
         inline const rectangle_t& brd() const { return _brd; }
@@ -252,8 +303,11 @@ class GxTree : public EstimatorBase2dim {
         inline       double       regpPxO(const uint i, const uint j) const {
                                     return _regpPxO(i,j);
                                   }
-        inline const Data2dim&    dataPxO(const uint i, const uint j) const {
-                                    return _dataPxO(i, j);
+        inline       uint         beginPxO(const uint i, const uint j) const {
+                                    return _tileBegin[i * cny() + j];
+                                  }
+        inline       uint         endPxO(const uint i, const uint j) const {
+                                    return _tileBegin[i * cny() + j + 1];
                                   }
 
       public:
@@ -276,20 +330,24 @@ class GxTree : public EstimatorBase2dim {
         double minLeafCumFreq() const;
         double maxLeafCumFreq() const;
       public:
-        void  init(const Data2dim& aData, const rectangle_t& aTr, const Node* aParent, const GxTree& aGxTree);
-        bool  initG(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree);
-        bool  initL(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree);
-        bool  initM(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree);
-        bool  initS(const Data2dim& aData, const anares_t& aAnaRes, const GxTree& aGxTree);
+        void  init(const rectangle_t& aTr, const Node* aParent, const GxTree& aGxTree);
+        bool  initG(const anares_t& aAnaRes, const GxTree& aGxTree);
+        bool  initL(const anares_t& aAnaRes, const GxTree& aGxTree);
+        bool  initM(const anares_t& aAnaRes, const GxTree& aGxTree);
+        bool  initS(const anares_t& aAnaRes, const GxTree& aGxTree);
         Node* expandChild(const uint i, const uint j, const GxTree& aGxTree);
+        // expandChild is linkChild(newChild), the latter can run concurrently
+        // for different tiles, it only reads (*this) and permutes the points of tile (i,j)
+        Node* newChild(const uint i, const uint j, const uint aNodeId, const GxTree& aGxTree) const;
+        void  linkChild(const uint i, const uint j, Node* aChild, const GxTree& aGxTree);
+        // tile (i,j) goes into the heap of GxTree::init
+        bool  isExpandable(const uint i, const uint j, const GxTree& aGxTree) const;
         void  insertChildrenIntoHeap(heap_t& aHeap, const GxTree& aGxTree);
         // prepare calls distribute data and clearChildren
-        void  prepare(const Data2dim& aData, const uint aNx, const uint aNy);
-        // distributeData distributes data in aData to aDataArr
-        void  distributeData(const Data2dim& aData, 
-                             const uint aNx,
-                             const uint aNy,
-                             data2dim_at& aDataArr);
+        void  prepare(const uint aNx, const uint aNy);
+        // distributeData permutes the points of this node such that
+        // those of tile (i,j) are in [beginPxO(i,j), endPxO(i,j))
+        void  distributeData(const uint aNx, const uint aNy);
         // clearChildren sets child pointers to zero
         void  clearChildren();
       public:
@@ -317,11 +375,9 @@ class GxTree : public EstimatorBase2dim {
                              const GxTree&); 
                void fill_mm3(      mm3_t&       aMM3,
                              const rectangle_t& aBrOrTr,
-                             const Data2dim&    aData,
                              const GxTree&      aGxTree); 
                // fill_mm5 always uses brd()
                void fill_mm5(      mm5_t&    aMM5,
-                             const Data2dim& aData,
                              const GxTree&   aGxTree); 
 
       private:
@@ -350,7 +406,9 @@ class GxTree : public EstimatorBase2dim {
         void          printThePxO(std::ostream& os) const;
         std::ostream& printDot(std::ostream& os, const int aParentId) const;
       private:
-        const Data2dim&  _data;       // data points
+        Data2dim&   _points; // data points of the GxTree
+        uint        _begin;  // those of this node: [_begin, _end)
+        uint        _end;
         rectangle_t _tr;   // tile rectangle, derived from parents grid 
         rectangle_t _br;   // bounding rectangle, only for testing
         rectangle_t _brd;  // bounding rectangle, 16x16 discretized
@@ -366,7 +424,7 @@ class GxTree : public EstimatorBase2dim {
 
 
         RegularPartitioning2dim _regpPxO; // final decision: PxO grid
-        data2dim_at             _dataPxO; // final decision: PxO grid
+        std::vector<uint>       _tileBegin; // PxO grid of the children: tile (i,j) at i*cny+j, outside at cnx*cny
         node_at                 _childrenPxO;  // pointers too child nodes (only used during construction), PxO
 
         uint        _level;      // level of node (only used for nicer output)
@@ -411,6 +469,9 @@ class GxTree : public EstimatorBase2dim {
   public:
     // get a new unique node ID
     inline uint               getNodeId() const { return (_nodeCount++); }
+    // number of threads building the tree (<= 1: serial)
+    static inline uint        noBuildThreads() { return _noBuildThreads; }
+    static inline void        noBuildThreads(const uint x) { _noBuildThreads = x; }
   public:
     virtual double estimate(const rectangle_t& r) const;
     virtual double estimate(const query_t& lQuery) const;
@@ -438,14 +499,21 @@ class GxTree : public EstimatorBase2dim {
     inline void incNoL() const { ++_nodeCountL; }
     inline void incNoM() const { ++_nodeCountM; }
     inline void incNoS() const { ++_nodeCountS; }
+           void incNo(const node_type_t aNodeType) const;
   public:
     virtual std::ostream& print_name_param(std::ostream& os) const;
             std::ostream& print(std::ostream& os) const;
             std::ostream& printDot(std::ostream& os) const;
             std::ostream& printParameters(std::ostream& os) const;
             std::ostream& printEncodingInfo(std::ostream& os) const;
+  public:
+    // after encode. save creates missing directories
+    synopsis_info_t synopsisInfo() const;
+    bool            save(const std::string& aFilename, const double aConstructionTime) const;
   private:
     Data2dim     _outlier;
+    OutlierIndex _outlierIndex;
+    Data2dim     _points; // copy of the data, permuted during construction
     rectangle_t  _br; // bounding rectangle
     gx_kind_t    _gxKind;
     uint         _budget; // in number of bytes
@@ -466,56 +534,75 @@ class GxTree : public EstimatorBase2dim {
     encoding_t   _encoding;
   public:
     const GxTreeItp*   _gxtitp; // for test purposes only
+  private:
+    static uint _noBuildThreads;
 };
 
 // GxTreeInterpreter
 // interpretes encoded GxTree
 // to provide an estimate
+// the traversal is iterative: estimate pops the nodes to visit from an
+// explicit Gxt::itp_stack_t, the estimate function of the node (G,L,M,S)
+// handles its own tiles and passes every child tile to descend.
+// descend settles a child whose tile is contained in or disjoint to the
+// query rectangle on the spot, without decoding its grid. any other child
+// is pushed after a prefetch of its header.
 
 class GxTreeItp : public EstimatorBase2dim {
   public:
     typedef GxTree::encoding_t encoding_t;
     typedef Gxt::node_type_t   node_type_t;
-    typedef double (GxTreeItp::*estfun_t)(const rectangle_t& aQueryRectangle,
-                                          const rectangle_t& aTileRectangle,
-                                          const uint         aIdx,
-                                          const uint         aLevel) const;
+    typedef Gxt::itp_frame_t   itp_frame_t;
+    typedef Gxt::itp_stack_t   itp_stack_t;
+    typedef GxTree::synopsis_info_t synopsis_info_t;
+  private:
+    GxTreeItp(const GxTreeItp&);
+    GxTreeItp& operator=(const GxTreeItp&);
   public:
     GxTreeItp(const Data2dim&   aOutlier,
               const encoding_t& aGxTreeEncoding, 
               const bool        aTrace);
     virtual ~GxTreeItp();
+  public:
+    // maps a file written by GxTree::save, the encoding refers to the mapped
+    // node arrays. returns 0 if the file is missing or does not fit.
+    static GxTreeItp* load(const std::string& aFilename,
+                           synopsis_info_t&   aInfoOut,
+                           const bool         aTrace);
   public:
     virtual double estimate(const rectangle_t& aQueryRectangle) const;
     virtual double estimate(const query_t& lQuery) const;
+    virtual void   estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
 
   public: 
-    // only used by estimate templates in estimate_t.hh
-    // and by GxTree::Node::estimate for testing purposes
+    // estimate of the subtree rooted at node aIdx of type aNodeType
+    // only used by GxTree::Node::estimate for testing purposes
     double estimate(const rectangle_t& aQueryRectangle,
                     const rectangle_t& aTileRectangle,
                     const uint         aIdx,
                     const node_type_t  aNodeType,
                     const uint         aLevel) const;
+    // estimates the nodes on aStack and their descendants, empties aStack
+    double estimate(const rectangle_t& aQueryRectangle,
+                    itp_stack_t&       aStack) const;
+    // only used by estimate templates in estimate_t.hh for the child
+    // aIdx of type aNodeType lying in tile aTileRectangle:
+    // returns its estimate if the tile is contained in or disjoint to the
+    // query rectangle, otherwise pushes the child and returns 0
+    inline double descend(const rectangle_t& aQueryRectangle,
+                          const rectangle_t& aTileRectangle,
+                          const uint         aIdx,
+                          const node_type_t  aNodeType,
+                          const uint         aLevel,
+                          itp_stack_t&       aStack) const;
   public:
     inline const encoding_t& encoding() const { return _encoding; }
   private:
-    double estimateG(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aIdx,
-                     const uint         aLevel) const;
-    double estimateL(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aIdx,
-                     const uint         aLevel) const;
-    double estimateM(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aIdx,
-                     const uint         aLevel) const;
-    double estimateS(const rectangle_t& aQueryRectangle,
-                     const rectangle_t& aTileRectangle,
-                     const uint         aIdx,
-                     const uint         aLevel) const;
+    double estimateNode(const rectangle_t& aQueryRectangle,
+                        const itp_frame_t& aFrame,
+                        itp_stack_t&       aStack) const;
+    inline const void* nodeAddr(const node_type_t aNodeType, const uint aIdx) const;
+    inline double      nodeTotal(const node_type_t aNodeType, const uint aIdx) const;
   public:
     inline const Data2dim& outlier() const { return _outlier; }
     inline uint            noOutlier() const { return _outlier.size(); }
@@ -544,12 +631,57 @@ class GxTreeItp : public EstimatorBase2dim {
             std::ostream& printNodeTypes(std::ostream& os) const;
   private:
     Data2dim          _outlier;
-    const encoding_t& _encoding;
+    OutlierIndex      _outlierIndex;
+    const encoding_t  _encoding; // by value, the GxTree it stems from may be deleted before
     bool              _trace;
-  private:
-    static estfun_t   _estfun[4];
+    SynopsisFile*     _synfile;  // owned, holds the node arrays if created by load
 };
 
+const void*
+GxTreeItp::nodeAddr(const node_type_t aNodeType, const uint aIdx) const {
+  switch(aNodeType) {
+    case Gxt::N_G: return &(_encoding._G[aIdx]);
+    case Gxt::N_L: return &(_encoding._L[aIdx]);
+    case Gxt::N_M: return &(_encoding._M[aIdx]);
+    default:       return &(_encoding._S[aIdx]);
+  }
+}
+
+// decompressed total, as returned by the estimate templates
+// for a query rectangle containing the node
+double
+GxTreeItp::nodeTotal(const node_type_t aNodeType, const uint aIdx) const {
+  switch(aNodeType) {
+    case Gxt::N_G: return Gxt::Node_G_Generic::_scaleTotal->decompressDouble(_encoding._G[aIdx].total());
+    case Gxt::N_L: return Gxt::Node_L_Generic::_scaleTotal->decompressDouble(_encoding._L[aIdx].total());
+    case Gxt::N_M: {
+                     const Gxt::Node_M_Generic& lNode = _encoding._M[aIdx];
+                     return (lNode.hasSmallHeader() ? Gxt::Node_M_Generic::_scaleTotalS->decompressDouble(lNode.totalS())
+                                                    : Gxt::Node_M_Generic::_scaleTotalX->decompressDouble(lNode.totalX()));
+                   }
+    default:       return _encoding._S[aIdx].totalDecompressed();
+  }
+}
+
+double
+GxTreeItp::descend(const rectangle_t& aQueryRectangle,
+                   const rectangle_t& aTileRectangle,
+                   const uint         aIdx,
+                   const node_type_t  aNodeType,
+                   const uint         aLevel,
+                   itp_stack_t&       aStack) const {
+  if(aQueryRectangle.contains(aTileRectangle)) {
+    return nodeTotal(aNodeType, aIdx);
+  }
+  rectangle_t lIsec;
+  if(lIsec.isec(aQueryRectangle, aTileRectangle).hasZeroArea()) {
+    return 0;
+  }
+  __builtin_prefetch(nodeAddr(aNodeType, aIdx));
+  aStack.push(aTileRectangle, aIdx, aNodeType, aLevel);
+  return 0;
+}
+
 
 } // end namspace
 
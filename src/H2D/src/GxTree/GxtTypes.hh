@@ -1,6 +1,8 @@
 #ifndef H2D_GXTREE_GXT_TYPES_HH
 #define H2D_GXTREE_GXT_TYPES_HH
 
+#include <vector>
+
 #include "infra/types.hh"
 #include "../scale/scale.hh"
 
@@ -156,6 +158,61 @@ namespace H2D {
       return x.print(os);
     }
 
+
+    // child node of some inner node still to be estimated by GxTreeItp:
+    // its tile in the parent's grid is cut by the query rectangle.
+    // plain doubles instead of a rectangle_t keep the frame trivially
+    // constructible, an itp_stack_t is not cleared on construction.
+    struct itp_frame_t {
+      double      _xlo, _ylo, _xhi, _yhi; // tile
+      uint32_t    _idx;   // index into the node array of _type
+      node_type_t _type;
+      uint32_t    _level; // for tracing
+
+      inline rectangle_t tile() const { return rectangle_t(_xlo, _ylo, _xhi, _yhi); }
+    };
+
+    // explicit stack of the iterative GxTreeItp traversal.
+    // the first k_local frames are part of the object (i.e. on the
+    // call stack of GxTreeItp::estimate), deeper frames spill into _spill.
+    class itp_stack_t {
+      public:
+        static constexpr uint k_local = 256;
+      public:
+        itp_stack_t() : _size(0), _spill() {}
+      public:
+        inline bool empty() const { return (0 == _size); }
+        inline uint size() const { return _size; }
+        inline void push(const rectangle_t& aTile,
+                         const uint32_t     aIdx,
+                         const node_type_t  aType,
+                         const uint32_t     aLevel) {
+                      itp_frame_t& lFrame = (_size < k_local) ? _local[_size]
+                                                              : _spill.emplace_back();
+                      lFrame._xlo   = aTile.xlo();
+                      lFrame._ylo   = aTile.ylo();
+                      lFrame._xhi   = aTile.xhi();
+                      lFrame._yhi   = aTile.yhi();
+                      lFrame._idx   = aIdx;
+                      lFrame._type  = aType;
+                      lFrame._level = aLevel;
+                      ++_size;
+                    }
+        inline itp_frame_t pop() {
+                             --_size;
+                             if(_size < k_local) {
+                               return _local[_size];
+                             }
+                             const itp_frame_t lFrame = _spill.back();
+                             _spill.pop_back();
+                             return lFrame;
+                           }
+      private:
+        uint                     _size;
+        itp_frame_t              _local[k_local];
+        std::vector<itp_frame_t> _spill;
+    };
+
   } // end namespace Gxt
 
 } // end namespace H2D
@@ -203,6 +203,7 @@ namespace H2D {
     Node_G_Generic::estimate(const rectangle_t& aQueryRectangle,
                              const rectangle_t& aTileRectangle,
                              const GxTreeItp&   aGxtItp,
+                             itp_stack_t&       aStack,
                              const bool         aTrace,
                              const uint         aNodeIdx,
                              const uint         aLevel) const {
@@ -233,6 +234,7 @@ namespace H2D {
                                                    (*this),
                                                    &lGrid,
                                                    aGxtItp,
+                                                   aStack,
                                                    _scaleTotal,
                                                    lScaleGrid,
                                                    lChildBaseIdx,
@@ -268,6 +270,7 @@ namespace H2D {
                                                       (*this),
                                                       &lGrid,
                                                       aGxtItp,
+                                                      aStack,
                                                       _scaleTotal,
                                                       _scaleGrid[lNkf],
                                                       lChildIdx,
@@ -288,6 +291,7 @@ namespace H2D {
                                                      (*this),
                                                      &lGrid,
                                                      aGxtItp,
+                                                     aStack,
                                                      _scaleTotal,
                                                      _scaleGrid[lNkf],
                                                      lChildIdx,
@@ -306,6 +310,7 @@ namespace H2D {
                                                      (*this),
                                                      &lGrid,
                                                      aGxtItp,
+                                                     aStack,
                                                      _scaleTotal,
                                                      _scaleGrid[lNkf],
                                                      lChildIdx,
@@ -454,11 +459,13 @@ namespace H2D {
     _content->getOnePointerAndKind(lChildBaseIdx, lKind);
 
     const q::Scale_L* lScaleTotal = q::ScaleMgr::instance()->scale_L_8_2();
+    itp_stack_t lStack; // children cut by the query rectangle
     lRes = estimateInnerDirect(aQueryRectangle,
                                _br,
                                (*this),
                                grid(),
                                aGxtItp,
+                               lStack,
                                lScaleTotal,
                                (0 == scaleBit()) ? q::ScaleMgr::instance()->scale_6_6_3()
                                                  : q::ScaleMgr::instance()->scale_6_6_1(),
@@ -467,6 +474,7 @@ namespace H2D {
                                aTrace,
                                aNodeIdx,
                                aLevel);
+    lRes += aGxtItp.estimate(aQueryRectangle, lStack);
     return lRes;
    }
 
@@ -527,11 +535,13 @@ namespace H2D {
 
        
      const q::Scale_L* lScaleTotal = q::ScaleMgr::instance()->scale_L_8_2();
+     itp_stack_t lStack; // children cut by the query rectangle
      lRes = estimateInnerSeparator(aQueryRectangle,
                                    _br,
                                    (*this),
                                    grid(),
                                    aGxtItp,
+                                   lStack,
                                    lScaleTotal,
                                    q::ScaleMgr::instance()->scale_S_5_2(),
                                    lChildIdx,
@@ -540,6 +550,7 @@ namespace H2D {
                                    aTrace,
                                    aNodeIdx,
                                    aLevel);
+     lRes += aGxtItp.estimate(aQueryRectangle, lStack);
 
      return lRes;
    }
@@ -580,17 +591,20 @@ namespace H2D {
      _content->getPointer(lChildIdx);
 
      const q::Scale_L* lScaleTotal = q::ScaleMgr::instance()->scale_L_8_2();
+     itp_stack_t lStack; // children cut by the query rectangle
      lRes = estimateInnerIndirect(aQueryRectangle,
                                   _br,
                                   (*this),
                                   grid(),
                                   aGxtItp,
+                                  lStack,
                                   lScaleTotal,
                                   q::ScaleMgr::instance()->scale_S_4_2(),
                                   lChildIdx,
                                   aTrace,
                                   aNodeIdx,
                                   aLevel);
+     lRes += aGxtItp.estimate(aQueryRectangle, lStack);
 
      return lRes;
    }
@@ -633,17 +647,20 @@ namespace H2D {
 
      const q::Scale_L* lScaleTotal = q::ScaleMgr::instance()->scale_L_8_2();
 
+     itp_stack_t lStack; // children cut by the query rectangle
      lRes = estimateInnerIndirect(aQueryRectangle,
                                   _br,
                                   (*this),
                                   grid(),
                                   aGxtItp,
+                                  lStack,
                                   lScaleTotal,
                                   q::ScaleMgr::instance()->scale_S_3_3(),
                                   lChildIdx,
                                   aTrace,
                                   aNodeIdx,
                                   aLevel);
+     lRes += aGxtItp.estimate(aQueryRectangle, lStack);
 
      return lRes;
    }
@@ -177,10 +177,12 @@ namespace H2D {
       // if there is only one ptr
       void getOnePointerAndKind(uint32_t& aPtrOut, node_type_t& aKindOut) const;
 
-      // the estimation function
+      // the estimation function, does not descend:
+      // children cut by the query rectangle are left on aStack
       double estimate(const rectangle_t& aQueryRectangle,
                       const rectangle_t& aTileRectangle,
                       const GxTreeItp&   aGxtItp,
+                      itp_stack_t&       aStack,
                       const bool         aTrace,
                       const uint         aNodeIdx,
                       const uint         aLevel) const;
@@ -156,6 +156,7 @@ namespace H2D {
     Node_L_Generic::estimate(const rectangle_t& aQueryRectangle,
                              const rectangle_t& aTileRectangle,
                              const GxTreeItp&   aGxtItp,
+                             itp_stack_t&       aStack,
                              const bool         aTrace,
                              const uint         aNodeIdx,
                              const uint         aLevel) const {
@@ -187,6 +188,7 @@ namespace H2D {
                                           (*this),
                                           &lGrid,
                                           aGxtItp,
+                                          aStack,
                                           _scaleTotal,
                                           _scaleGrid[lNkf],
                                           getPtr(lNkf, 0),
@@ -212,6 +214,7 @@ namespace H2D {
                                           (*this),
                                           &lGrid,
                                           aGxtItp,
+                                          aStack,
                                           _scaleTotal,
                                           _scaleGrid[lNkf],
                                           getPtr(lNkf, 0),
@@ -244,6 +247,7 @@ namespace H2D {
                                             (*this),
                                             &lGrid,
                                             aGxtItp,
+                                            aStack,
                                             _scaleTotal,
                                             _scaleGrid[lNkf],
                                             lChildIdx,
@@ -284,6 +288,7 @@ namespace H2D {
                                             (*this),
                                             &lGrid,
                                             aGxtItp,
+                                            aStack,
                                             _scaleTotal,
                                             _scaleGrid[lNkf],
                                             lChildIdx,
@@ -314,6 +319,7 @@ namespace H2D {
                                           (*this),
                                           &lGrid,
                                           aGxtItp,
+                                          aStack,
                                           _scaleTotal,
                                           _scaleGrid[lNkf],
                                           lChildIdx,
@@ -337,6 +343,7 @@ namespace H2D {
                                           (*this),
                                           &lGrid,
                                           aGxtItp,
+                                          aStack,
                                           _scaleTotal,
                                           _scaleGrid[lNkf],
                                           lChildIdx,
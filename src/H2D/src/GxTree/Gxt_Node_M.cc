@@ -124,6 +124,7 @@ namespace H2D {
     Node_M_Generic::estimate(const rectangle_t& aQueryRectangle,
                              const rectangle_t& aTileRectangle,
                              const GxTreeItp&   aGxtItp,
+                             itp_stack_t&       aStack,
                              const bool         aTrace,
                              const uint         aNodeIdx,
                              const uint         aLevel) const {
@@ -183,6 +184,7 @@ namespace H2D {
                                             (*this),
                                             &lGrid,
                                             aGxtItp,
+                                            aStack,
                                             _scaleTotalS,
                                             scaleGrid(0, lNkf),
                                             lChildIdx,
@@ -206,6 +208,7 @@ namespace H2D {
                                           (*this),
                                           &lGrid,
                                           aGxtItp,
+                                          aStack,
                                           _scaleTotalX,
                                           scaleGrid(scaleBitX(), lNkf),
                                           getPtr(lNkf),
@@ -233,6 +236,7 @@ namespace H2D {
                                             (*this),
                                             &lGrid,
                                             aGxtItp,
+                                            aStack,
                                             _scaleTotalS,
                                             scaleGrid(0, lNkf),
                                             lChildIdx,
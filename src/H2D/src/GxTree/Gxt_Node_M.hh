@@ -308,6 +308,7 @@ namespace H2D {
       double estimate(const rectangle_t& aQueryRectangle,
                       const rectangle_t& aTileRectangle,
                       const GxTreeItp&   aGxtItp,
+                      itp_stack_t&       aStack,
                       const bool         aTrace, // for tracing
                       const uint         aNodeIdx, // for tracing
                       const uint         aLevel) const; // for tracing
@@ -75,6 +75,7 @@ namespace H2D {
     Node_S_Generic::estimate(const rectangle_t& aQueryRectangle,
                              const rectangle_t& aTileRectangle,
                              const GxTreeItp&   aGxtItp,
+                             itp_stack_t&       aStack,
                              const bool         aTrace,
                              const uint         aNodeIdx,
                              const uint         aLevel) const {
@@ -105,6 +106,7 @@ namespace H2D {
                                                     (*this),
                                                     &lGrid,
                                                     aGxtItp,
+                                                    aStack,
                                                     _scaleTotal,
                                                     scaleGrid(lNkf),
                                                     getPtr(),
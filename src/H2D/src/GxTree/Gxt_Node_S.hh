@@ -141,6 +141,7 @@ namespace H2D {
       double estimate(const rectangle_t& aQueryRectangle,
                       const rectangle_t& aTileRectangle,
                       const GxTreeItp&   aGxtItp,
+                      itp_stack_t&       aStack,
                       const bool         aTrace,
                       const uint         aNodeIdx,
                       const uint         aLevel) const;
@@ -12,6 +12,11 @@
 //    Tchildaccessor::getChildPtr(fBits);
 //    Tchildaccessor::getChildKind(fBits);
 //
+// the inner templates do not recurse: each child tile goes to
+// GxTreeItp::descend, which settles it or leaves the child on aStack
+// for the traversal loop in GxTreeItp. their result is thus the estimate
+// of the node's own tiles and of the settled children only.
+//
 
 namespace H2D {
   namespace Gxt {
@@ -30,6 +35,7 @@ estimateInnerDirect(const rectangle_t&   aQueryRectangle,
                     const Tnode&         aNode,
                     const Tgrid*         aGrid,
                     const GxTreeItp&     aGxt,
+                    itp_stack_t&         aStack,
                     const Tscale1*       aScaleTotal,
                     const Tscale2*       aScale,
                     const uint32_t       aChildBaseIdx,
@@ -112,11 +118,12 @@ estimateInnerDirect(const rectangle_t&   aQueryRectangle,
                     << "     child call --> " << (aChildBaseIdx + lFBits) << ' '
                     << std::endl;
         }
-        lEstimate += aGxt.estimate(aQueryRectangle,
-                                   lTile,
-                                   aChildBaseIdx + lFBits,
-                                   aChildNodeType,
-                                   aLevel + 1);
+        lEstimate += aGxt.descend(aQueryRectangle,
+                                  lTile,
+                                  aChildBaseIdx + lFBits,
+                                  aChildNodeType,
+                                  aLevel + 1,
+                                  aStack);
       } else {
         if(lTrace) {
           std::cout << std::string(2*aLevel, ' ') << "      "
@@ -153,6 +160,7 @@ estimateInnerSeparator(const rectangle_t&   aQueryRectangle,
                        const Tnode&         aNode,
                        const Tgrid*         aGrid,
                        const GxTreeItp&     aGxt,
+                       itp_stack_t&         aStack,
                        const Tscale1*       aScaleTotal,
                        const Tscale2*       aScale,
                        const uint32_t*      aChildIdx, // [4]
@@ -341,11 +349,12 @@ estimateInnerSeparator(const rectangle_t&   aQueryRectangle,
                     << ", lKind = " << lKind 
                     << ", lOffset = " << lOffset << std::endl;
         }
-        lEstimate += aGxt.estimate(aQueryRectangle,
-                                   lTile,
-                                   aChildIdx[lKind] + lOffset,
-                                   (node_type_t) lKind,
-                                   aLevel + 1);
+        lEstimate += aGxt.descend(aQueryRectangle,
+                                  lTile,
+                                  aChildIdx[lKind] + lOffset,
+                                  (node_type_t) lKind,
+                                  aLevel + 1,
+                                  aStack);
       } else {
         lTileIsec.isec(lIsec, lTile);
         if(!lTileIsec.hasZeroArea()) {
@@ -383,6 +392,7 @@ estimateInnerIndirect(const rectangle_t&   aQueryRectangle,
                       const Tnode&         aNode,
                       const Tgrid*         aGrid,
                       const GxTreeItp&     aGxt,
+                      itp_stack_t&         aStack,
                       const Tscale1*       aScaleTotal,
                       const Tscale2*       aScale,
                       const uint32_t*      aChildIdx,
@@ -478,11 +488,12 @@ estimateInnerIndirect(const rectangle_t&   aQueryRectangle,
                       << ", lTile = " << lTile
                       << std::endl;
           }
-          const double lTileEst = aGxt.estimate(aQueryRectangle,
-                                                lTile,
-                                                aChildIdx[lKind] + lOffset,
-                                                (node_type_t) lKind,
-                                                aLevel + 1);
+          const double lTileEst = aGxt.descend(aQueryRectangle,
+                                               lTile,
+                                               aChildIdx[lKind] + lOffset,
+                                               (node_type_t) lKind,
+                                               aLevel + 1,
+                                               aStack);
           lEstimate += lTileEst;
         }
         ++lChildCount[lKind];
@@ -588,25 +599,43 @@ estimateLeaf(const rectangle_t&   aQueryRectangle,
     std::cout << std::string(2*aLevel, ' ')
               << "    i  j fBits   tf EstIJ"  << std::endl;
   }
+
+  // the tile frequencies are decoded a row at a time (Tgrid::getRowDecompressed).
+  // a tile contained in lIsec is its own intersection, the quotient of
+  // the areas is 1: its frequency is added without computing the tile.
+  // the order of the additions is that of the loop over all tiles.
+  double lTileFreq[nxy];
+  bool   lColContained[nxy];
+  for(uint j = lMinJ; j <= lMaxJ; ++j) {
+    lColContained[j] = (lIsec.ylo() <= lPd.boundaryY(j)) &&
+                       (lPd.boundaryY(j) < lPd.boundaryY(j + 1)) &&
+                       (lPd.boundaryY(j + 1) <= lIsec.yhi());
+  }
   for(uint i = lMinI; i <= lMaxI; ++i) {
+    aGrid->getRowDecompressed(i, lMinJ, lMaxJ + 1, aScale->decompressTable(), lTileFreq);
+    const bool lRowContained = (lIsec.xlo() <= lPd.boundaryX(i)) &&
+                               (lPd.boundaryX(i) < lPd.boundaryX(i + 1)) &&
+                               (lPd.boundaryX(i + 1) <= lIsec.xhi());
     for(uint j = lMinJ; j <= lMaxJ; ++j) {
-      lPd.getRectangle(i, j, lTile);
-      lTileIsec.isec(lIsec, lTile);
-      if(!lTileIsec.hasZeroArea()) {
-        const uint32_t lFBits   = aGrid->get(i,j);
-        const double lTileFreq = aScale->decompressDouble(lFBits);
-        const double lEstij = ((lTileIsec.area() / lTile.area()) * lTileFreq);
-        lEstimate += lEstij;
-        if(aTrace) {
-           std::cout << std::string(2*aLevel, ' ')
-                     << "   "
-                     << std::setw(2) << i << ' '
-                     << std::setw(2) << j << ' '
-                     << std::setw(5) << lFBits << ' '
-                     << std::setw(4) << lTileFreq << ' '
-                     << std::setw(5) << lEstij << ' '
-                     << std::endl;
+      double lEstij = lTileFreq[j - lMinJ];
+      if(!(lRowContained && lColContained[j])) {
+        lPd.getRectangle(i, j, lTile);
+        lTileIsec.isec(lIsec, lTile);
+        if(lTileIsec.hasZeroArea()) {
+          continue;
         }
+        lEstij = ((lTileIsec.area() / lTile.area()) * lEstij);
+      }
+      lEstimate += lEstij;
+      if(aTrace) {
+         std::cout << std::string(2*aLevel, ' ')
+                   << "   "
+                   << std::setw(2) << i << ' '
+                   << std::setw(2) << j << ' '
+                   << std::setw(5) << aGrid->get(i,j) << ' '
+                   << std::setw(4) << lTileFreq[j - lMinJ] << ' '
+                   << std::setw(5) << lEstij << ' '
+                   << std::endl;
       }
     }
   }
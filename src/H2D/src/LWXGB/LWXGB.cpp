@@ -14,6 +14,23 @@ LWXGB::LWXGB(const Data2dim &aData, const Cb &aCb,
       _oneEq(OneDEqDepHist(_data, _aCb.phi(), q(), theta(), _aCb.sampleSize(),
                            false)) {}
 
+// 4: min selectivity, 5: exponential backoff, 6: independence estimate
+// (as in the libsvm files: rounded up to whole tuples)
+void LWXGB::fill_features(const query_t &aQuery, float *aRowOut) const {
+  XGBEstimator::fill_features(aQuery, aRowOut);
+  const double total_data = _data.total();
+  const double xSel = 1.0 * _oneEq.estimateX(aQuery) / total_data;
+  const double ySel = 1.0 * _oneEq.estimateY(aQuery) / total_data;
+  const double minSel = std::min(xSel, ySel);
+  const double maxSel = std::max(xSel, ySel);
+  const uint minSelEst = std::ceil(minSel * total_data);
+  const uint eboSelEst = std::ceil(1.0 * total_data * minSel * std::sqrt(maxSel));
+  const uint indepEst = std::ceil(xSel * ySel * total_data);
+  aRowOut[4] = minSelEst;
+  aRowOut[5] = eboSelEst;
+  aRowOut[6] = indepEst;
+}
+
 void LWXGB::fill_libsvm_trainfiles() const {
   //  EstimatorArea* areaEst = new EstimatorArea(_data,theta());
   // H2D::QTS1D::kind_t lQTS1Kind = H2D::QTS1D::k_card;
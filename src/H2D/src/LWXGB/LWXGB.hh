@@ -31,6 +31,8 @@ public:
 public:
   virtual void fill_libsvm_trainfiles() const;
   virtual void fill_libsvm_testfiles() const;
+  virtual uint num_features() const { return 7; }
+  virtual void fill_features(const query_t &aQuery, float *aRowOut) const;
 
 private:
   Data2dim _data;
@@ -1,13 +1,21 @@
 #include "MHist2.hh"
 
+#include <cmath>
+#include <algorithm>
+
 
 namespace H2D {
 
 
-MHist2::MHist2() : _kind(k_invalid), _buckets() {
+MHist2::MHist2() : _kind(k_invalid), _buckets(),
+                   _nodeXlo(), _nodeYlo(), _nodeXhi(), _nodeYhi(),
+                   _nodeCount(), _nodeBegin(), _nodeEnd(), _noLeaves(0) {
 }
 
-MHist2::MHist2(const uint aNumBuckets, const kind_t aKind, const Data2dim& aData) : _kind(aKind), _buckets() {
+MHist2::MHist2(const uint aNumBuckets, const kind_t aKind, const Data2dim& aData)
+              : _kind(aKind), _buckets(),
+                _nodeXlo(), _nodeYlo(), _nodeXhi(), _nodeYhi(),
+                _nodeCount(), _nodeBegin(), _nodeEnd(), _noLeaves(0) {
  // std::cout << "kind: " << aKind << std::endl;
   init(aNumBuckets, aKind, aData);
 }
@@ -20,122 +28,305 @@ MHist2::size() const {
   return (_buckets.size() * MHist2Bucket::size());
 }
 
+/*
+ * init
+ * the buckets are ranges of two permutations of the points, sorted on
+ * x and on y (build_t). a bucket is split by partitioning its ranges
+ * in place, keeping them sorted, such that the split criteria only scan
+ * them. the splittable buckets are kept in a heap on their criterion;
+ * ties go to the later bucket, as the former search from the back did.
+ */
+
 void 
 MHist2::init(const uint aNumBuckets, const kind_t aKind, const Data2dim& aData) {
   _kind = aKind;
-
-  partialDistribution_vt lPvt;
-  partialDistribution_t lP = partialDistribution_t(aData);
+  _buckets.clear();
   switch (aKind) {
     case k_maxDiffSpread:
-      maxDiffSpread(lP);
-      break;
     case k_maxSpread:
-      maxSpread(lP);
-      break;
     case k_maxDiffCount:
-      maxDiffCount(lP);
-      break;
     case k_maxDiffArea:
-      maxDiffArea(lP);
-      break;
     case k_minVariance:
-      minVariance(lP);
       break;
     default:
       assert(0>1);
   }
-  lPvt.push_back(lP);
 
-  while ( aNumBuckets >= lPvt.size() ) {
-    partialDistribution_vt::iterator lExtreme = lPvt.end();
+  const uint n = aData.size();
+  if(0 == n) {
+    _buckets.push_back(MHist2Bucket(aData));
+    buildRTree();
+    return;
+  }
 
-    for ( partialDistribution_vt::iterator lIter = (lPvt.end() - 1); lIter >= lPvt.begin(); --lIter ) {
-      if ( lIter->dimension != ' ' ) {
-        lExtreme = lIter;
-        break;
-      }
+  build_t lB;
+  lB._x.resize(n);
+  lB._y.resize(n);
+  lB._c.resize(n);
+  for(uint i = 0; i < n; ++i) {
+    lB._x[i] = aData[i].x;
+    lB._y[i] = aData[i].y;
+    lB._c[i] = aData[i].c;
+  }
+  for(uint d = 0; d < 2; ++d) {
+    const std::vector<double>& lCoord = (0 == d) ? lB._x : lB._y;
+    lB._idx[d].resize(n);
+    for(uint i = 0; i < n; ++i) {
+      lB._idx[d][i] = i;
     }
+    std::sort(lB._idx[d].begin(), lB._idx[d].end(), [&lCoord] (const uint32_t a, const uint32_t b) {
+                return (lCoord[a] < lCoord[b]);
+              });
+  }
+  lB._tmp.resize(n);
 
-    if (lExtreme == lPvt.end()) { // There is no single bucket that can be split
-      break;
-    }
+  // heap of (criterion, bucket), maximal criterion first
+  typedef std::pair<double, uint> cand_t;
+  std::vector<cand_t> lHeap;
+  const double lSign = (aKind == k_minVariance) ? -1.0 : 1.0;
 
-    if (aKind == k_minVariance) {
-      // Search for bucket with smaller diff
-      for ( partialDistribution_vt::iterator lIter = (lExtreme - 1); lIter >= lPvt.begin(); --lIter ) {
-        if ( lExtreme->extremeDiff > lIter->extremeDiff && lIter->dimension != ' ' ) {
-          lExtreme = lIter;
-        }
-      }
-    } else {
-      // Search for bucket with greater diff
-      for ( partialDistribution_vt::iterator lIter = (lExtreme - 1); lIter >= lPvt.begin(); --lIter ) {
-        if ( lExtreme->extremeDiff < lIter->extremeDiff && lIter->dimension != ' ' ) {
-          lExtreme = lIter;
-        }
-      }
+  partialDistribution_vt lPvt;
+  lPvt.push_back(partialDistribution_t(0, n));
+  evaluate(lPvt[0], lB);
+  if(' ' != lPvt[0].dimension) {
+    lHeap.push_back(cand_t(lSign * lPvt[0].extremeDiff, 0));
+  }
+
+  while ( aNumBuckets >= lPvt.size() && !lHeap.empty() ) {
+    std::pop_heap(lHeap.begin(), lHeap.end());
+    const uint lExtreme = lHeap.back().second;
+    lHeap.pop_back();
+
+    const partialDistribution_t lPd = lPvt[lExtreme];
+    const uint lMid = split(lPd, lB);
+
+    lPvt[lExtreme] = partialDistribution_t(lPd.begin, lMid);
+    lPvt.push_back(partialDistribution_t(lMid, lPd.end));
+    const uint lUp = lPvt.size() - 1;
+    evaluate(lPvt[lExtreme], lB);
+    evaluate(lPvt[lUp], lB);
+    if(' ' != lPvt[lExtreme].dimension) {
+      lHeap.push_back(cand_t(lSign * lPvt[lExtreme].extremeDiff, lExtreme));
+      std::push_heap(lHeap.begin(), lHeap.end());
+    }
+    if(' ' != lPvt[lUp].dimension) {
+      lHeap.push_back(cand_t(lSign * lPvt[lUp].extremeDiff, lUp));
+      std::push_heap(lHeap.begin(), lHeap.end());
     }
+  }
 
-    Data2dim lLow;
-    Data2dim lUp;
-    if ( lExtreme->dimension == 'x' ) {
-      // Split along x
-      for ( xyc_vt::const_iterator lIter = lExtreme->data.beginIter(); lIter != lExtreme->data.endIter(); ++lIter ) {
-        if ( lIter->x <= lExtreme->value) {
-          lLow.step(lIter->x, lIter->y, lIter->c);
-        } else {
-          lUp.step(lIter->x, lIter->y, lIter->c);
-        }
-      }
-    } else {
-      // Split along y
-      for ( xyc_vt::const_iterator lIter = lExtreme->data.beginIter(); lIter < lExtreme->data.endIter(); ++lIter ) {
-        if ( lIter->y <= lExtreme->value) {
-          lLow.step(lIter->x, lIter->y, lIter->c);
-        } else {
-          lUp.step(lIter->x, lIter->y, lIter->c);
-        }
-      }
+  _buckets.reserve(lPvt.size());
+  for ( partialDistribution_vt::const_iterator lIter = lPvt.begin(); lIter != lPvt.end(); ++lIter ) {
+    const std::vector<uint32_t>& lIdxX = lB._idx[0];
+    const std::vector<uint32_t>& lIdxY = lB._idx[1];
+    const rectangle_t lRect(lB._x[lIdxX[lIter->begin]], lB._y[lIdxY[lIter->begin]],
+                            lB._x[lIdxX[lIter->end - 1]], lB._y[lIdxY[lIter->end - 1]]);
+    uint lTotal = 0;
+    for(uint i = lIter->begin; i < lIter->end; ++i) {
+      lTotal += lB._c[lIdxX[i]];
     }
+    _buckets.push_back(MHist2Bucket(lRect, lTotal));
+  }
 
-    *lExtreme = partialDistribution_t(lLow);
-    lP = partialDistribution_t(lUp);
+  // Allows faster estimate
+  buildRTree();
+}
 
-    switch (aKind) {
+// the criterion of aKind on x, then on y
+void
+MHist2::evaluate(partialDistribution_t& aPd, build_t& aB) const {
+  if (_kind == k_minVariance) {
+    aPd.extremeDiff = std::numeric_limits<double>::max();
+  }
+  for(uint d = 0; d < 2; ++d) {
+    // distinct values and their frequencies
+    const std::vector<double>&   lCoord = (0 == d) ? aB._x : aB._y;
+    const std::vector<uint32_t>& lIdx   = aB._idx[d];
+    aB._val.clear();
+    aB._cnt.clear();
+    for(uint i = aPd.begin; i < aPd.end; ++i) {
+      const uint32_t p = lIdx[i];
+      if(aB._val.empty() || aB._val.back() != lCoord[p]) {
+        aB._val.push_back(lCoord[p]);
+        aB._cnt.push_back(0);
+      }
+      aB._cnt.back() += aB._c[p];
+    }
+    const char lDim = (0 == d) ? 'x' : 'y';
+    switch (_kind) {
       case k_maxDiffSpread:
-        maxDiffSpread(*lExtreme);
-        maxDiffSpread(lP);
+        maxDiffSpread(aPd, lDim, aB);
         break;
       case k_maxSpread:
-        maxSpread(*lExtreme);
-        maxSpread(lP);
+        maxSpread(aPd, lDim, aB);
         break;
       case k_maxDiffCount:
-        maxDiffCount(*lExtreme);
-        maxDiffCount(lP);
+        maxDiffCount(aPd, lDim, aB);
         break;
       case k_maxDiffArea:
-        maxDiffArea(*lExtreme);
-        maxDiffArea(lP);
+        maxDiffArea(aPd, lDim, aB);
         break;
       case k_minVariance:
-        minVariance(*lExtreme);
-        minVariance(lP);
+        minVariance(aPd, lDim, aB);
         break;
       default:
         assert(0>1);
     }
+  }
+}
 
-    lPvt.push_back(lP);
+// stable in place partition of both ranges of aPd into the points with
+// coordinate <= value in the split dimension and the others.
+// returns the end of the lower part.
+uint
+MHist2::split(const partialDistribution_t& aPd, build_t& aB) const {
+  const std::vector<double>& lCoord = ('x' == aPd.dimension) ? aB._x : aB._y;
+  uint lMid = aPd.begin;
+  for(uint d = 0; d < 2; ++d) {
+    std::vector<uint32_t>& lIdx = aB._idx[d];
+    uint lLow = aPd.begin;
+    uint lUp  = 0;
+    for(uint i = aPd.begin; i < aPd.end; ++i) {
+      const uint32_t p = lIdx[i];
+      if(lCoord[p] <= aPd.value) {
+        lIdx[lLow++] = p;
+      } else {
+        aB._tmp[lUp++] = p;
+      }
+    }
+    std::copy(aB._tmp.begin(), aB._tmp.begin() + lUp, lIdx.begin() + lLow);
+    lMid = lLow;
   }
+  return lMid;
+}
+// sort-tile-recursive order of the rectangles aRect[aIdx[i]]:
+// sorted on x-center, cut into slices of k_fanout * ceil(sqrt(#groups))
+// rectangles, each slice sorted on y-center. consecutive groups of
+// k_fanout rectangles then become the nodes of the level above.
+void
+MHist2::strSort(std::vector<uint>& aIdx, const std::vector<rectangle_t>& aRect) const {
+  const uint n = aIdx.size();
+  const uint lNoGroups = (n + k_fanout - 1) / k_fanout;
+  const uint lNoSlices = (uint) std::ceil(std::sqrt((double) lNoGroups));
+  const uint lSliceSize = k_fanout * ((lNoGroups + lNoSlices - 1) / lNoSlices);
+  std::sort(aIdx.begin(), aIdx.end(), [&aRect] (const uint a, const uint b) {
+              const double lCa = aRect[a].xlo() + aRect[a].xhi();
+              const double lCb = aRect[b].xlo() + aRect[b].xhi();
+              return (lCa < lCb || (lCa == lCb && a < b));
+            });
+  for(uint lBegin = 0; lBegin < n; lBegin += lSliceSize) {
+    const uint lEnd = std::min<uint>(n, lBegin + lSliceSize);
+    std::sort(aIdx.begin() + lBegin, aIdx.begin() + lEnd, [&aRect] (const uint a, const uint b) {
+                const double lCa = aRect[a].ylo() + aRect[a].yhi();
+                const double lCb = aRect[b].ylo() + aRect[b].yhi();
+                return (lCa < lCb || (lCa == lCb && a < b));
+              });
+  }
+}
+
+// aRect := bounding rectangle of aRect and [aXlo, aXhi] x [aYlo, aYhi]
+static void
+extend(rectangle_t& aRect, const double aXlo, const double aYlo, const double aXhi, const double aYhi) {
+  aRect.xlo(std::min<double>(aRect.xlo(), aXlo));
+  aRect.ylo(std::min<double>(aRect.ylo(), aYlo));
+  aRect.xhi(std::max<double>(aRect.xhi(), aXhi));
+  aRect.yhi(std::max<double>(aRect.yhi(), aYhi));
+}
 
-  for ( partialDistribution_vt::iterator lIter = lPvt.begin(); lIter != lPvt.end(); ++lIter ) {
-    _buckets.push_back(MHist2Bucket(lIter->data));
+void
+MHist2::buildRTree() {
+  _nodeXlo.clear();
+  _nodeYlo.clear();
+  _nodeXhi.clear();
+  _nodeYhi.clear();
+  _nodeCount.clear();
+  _nodeBegin.clear();
+  _nodeEnd.clear();
+  _noLeaves = 0;
+
+  const uint lNoBuckets = _buckets.size();
+  if(0 == lNoBuckets) {
+    return;
   }
 
-  // Allows faster estimate
-  std::sort (_buckets.begin(), _buckets.end());
+  // buckets into STR order
+  std::vector<rectangle_t> lRect(lNoBuckets);
+  std::vector<uint>        lIdx(lNoBuckets);
+  for(uint i = 0; i < lNoBuckets; ++i) {
+    lRect[i] = _buckets[i].rect();
+    lIdx[i]  = i;
+  }
+  strSort(lIdx, lRect);
+  std::vector<MHist2Bucket> lBuckets;
+  lBuckets.reserve(lNoBuckets);
+  for(uint i = 0; i < lNoBuckets; ++i) {
+    lBuckets.push_back(_buckets[lIdx[i]]);
+  }
+  _buckets.swap(lBuckets);
+
+  // leaves: consecutive groups of k_fanout buckets
+  struct node_t {
+    rectangle_t _br;
+    double      _count;
+    uint32_t    _begin;
+    uint32_t    _end;
+    node_t() : _br(), _count(0), _begin(0), _end(0) {}
+  };
+  std::vector<node_t> lLevel;
+  for(uint lBegin = 0; lBegin < lNoBuckets; lBegin += k_fanout) {
+    node_t lNode;
+    lNode._begin = lBegin;
+    lNode._end   = std::min<uint>(lNoBuckets, lBegin + k_fanout);
+    lNode._br    = _buckets[lBegin].rect();
+    lNode._count = 0;
+    for(uint i = lNode._begin; i < lNode._end; ++i) {
+      extend(lNode._br, _buckets[i].xlo(), _buckets[i].ylo(), _buckets[i].xhi(), _buckets[i].yhi());
+      lNode._count += _buckets[i].c();
+    }
+    lLevel.push_back(lNode);
+  }
+  _noLeaves = lLevel.size();
+
+  // levels above, until the root is reached
+  while(true) {
+    const uint lNoNodes = lLevel.size();
+    std::vector<uint> lOrder(lNoNodes);
+    for(uint i = 0; i < lNoNodes; ++i) {
+      lRect[i]  = lLevel[i]._br;
+      lOrder[i] = i;
+    }
+    if(_noLeaves != lNoNodes) {
+      strSort(lOrder, lRect); // leaves are already in STR order
+    }
+    const uint lOffset = _nodeCount.size();
+    for(uint i = 0; i < lNoNodes; ++i) {
+      const node_t& lNode = lLevel[lOrder[i]];
+      _nodeXlo.push_back(lNode._br.xlo());
+      _nodeYlo.push_back(lNode._br.ylo());
+      _nodeXhi.push_back(lNode._br.xhi());
+      _nodeYhi.push_back(lNode._br.yhi());
+      _nodeCount.push_back(lNode._count);
+      _nodeBegin.push_back(lNode._begin);
+      _nodeEnd.push_back(lNode._end);
+    }
+    if(1 == lNoNodes) {
+      break;
+    }
+    std::vector<node_t> lParents;
+    for(uint lBegin = 0; lBegin < lNoNodes; lBegin += k_fanout) {
+      node_t lNode;
+      lNode._begin = lOffset + lBegin;
+      lNode._end   = lOffset + std::min<uint>(lNoNodes, lBegin + k_fanout);
+      lNode._br    = lLevel[lOrder[lBegin]]._br;
+      lNode._count = 0;
+      for(uint i = lNode._begin; i < lNode._end; ++i) {
+        extend(lNode._br, _nodeXlo[i], _nodeYlo[i], _nodeXhi[i], _nodeYhi[i]);
+        lNode._count += _nodeCount[i];
+      }
+      lParents.push_back(lNode);
+    }
+    lLevel.swap(lParents);
+  }
 }
 
 
@@ -147,20 +338,57 @@ MHist2::estimate(const query_t& lQuery) const {
 
 double 
 MHist2::estimate(const rectangle_t& aRect) const {
+  // closed rectangles: buckets touching the query are estimated
+  if(0 == _noLeaves) {
+    return 0.0;
+  }
 
   double lEstimate = 0.0;
-
-  for ( std::vector<MHist2Bucket>::const_iterator lIter = _buckets.begin(); lIter != _buckets.end(); ++lIter ) {
-    if (lIter->xlo() > aRect.xhi()) // _bucket is sorted for xlo so we can skip if xhi is higher
-      break;
-
-    if (lIter->xhi() >= aRect.xlo() && lIter->yhi() >= aRect.ylo() && lIter->ylo() <= aRect.yhi())
-      lIter->estimate(lEstimate, aRect);
+  uint lStack[16 * k_fanout];
+  uint lTop = 0;
+  lStack[lTop++] = noNodes() - 1; // root
+  while(0 < lTop) {
+    const uint n = lStack[--lTop];
+    if(_nodeXlo[n] > aRect.xhi() || _nodeXhi[n] < aRect.xlo() ||
+       _nodeYlo[n] > aRect.yhi() || _nodeYhi[n] < aRect.ylo()) {
+      continue;
+    }
+    if(aRect.xlo() <= _nodeXlo[n] && _nodeXhi[n] <= aRect.xhi() &&
+       aRect.ylo() <= _nodeYlo[n] && _nodeYhi[n] <= aRect.yhi()) {
+      lEstimate += _nodeCount[n];
+      continue;
+    }
+    if(n < _noLeaves) {
+      for(uint b = _nodeBegin[n]; b < _nodeEnd[n]; ++b) {
+        const MHist2Bucket& lBucket = _buckets[b];
+        if(lBucket.xlo() <= aRect.xhi() && lBucket.xhi() >= aRect.xlo() &&
+           lBucket.ylo() <= aRect.yhi() && lBucket.yhi() >= aRect.ylo()) {
+          lBucket.estimate(lEstimate, aRect);
+        }
+      }
+    } else {
+      for(uint c = _nodeBegin[n]; c < _nodeEnd[n]; ++c) {
+        lStack[lTop++] = c;
+      }
+    }
   }
 
   return lEstimate;
 }
 
+/*
+ * estimate_batch
+ * the R-tree is small and shared by all queries, which are answered
+ * one after the other.
+ */
+
+void
+MHist2::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  for(size_t q = 0; q < aN; ++q) {
+    aEstOut[q] = estimate(aBegin[q].rectangle());
+  }
+}
+
 std::ostream& 
 MHist2::printSvg(std::ostream& os, const Data2dim& aData, const bool printDot) const {
 
@@ -242,260 +470,106 @@ MHist2::printSvg(std::ostream& os, const Data2dim& aData, const bool printDot) c
 
 
 
-void 
-MHist2::maxDiffSpread(partialDistribution_t& aPd) const {
-  xyc_vt::iterator lIterFirst = aPd.data.beginIter();
-  xyc_vt::iterator lIterLast = aPd.data.endIter();
-  xyc_vt::iterator lA, lB, lC;
-
-  aPd.data.sortX(lIterFirst, lIterLast);
-  lA = lIterFirst;
-  lB = nextX(lA, lIterLast);
-  lC = nextX(lB, lIterLast);
-
-  while (lC < lIterLast) {
-    const double lSpreadDiff = std::fabs((lB->x - lA->x) - (lC->x - lB->x));
-
-    if (lSpreadDiff > aPd.extremeDiff) {
-      aPd.extremeDiff = lSpreadDiff;
-      aPd.value = lA->x;
-      aPd.dimension = 'x';
-    }
-
-    lA = lB;
-    lB = lC;
-    lC = nextX(lB, lIterLast);
-  }
-
-  aPd.data.sortY(lIterFirst, lIterLast);
-  lA = lIterFirst;
-  lB = nextY(lA, lIterLast);
-  lC = nextY(lB, lIterLast);
+/*
+ * split criteria of one dimension aDim of aPd, over its distinct values
+ * aB._val in ascending order and their frequencies aB._cnt.
+ * the proposed split is at the last value of the lower part.
+ */
 
-  while (lC < lIterLast) {
-    const double lSpreadDiff = std::fabs((lB->y - lA->y) - (lC->y - lB->y));
+void 
+MHist2::maxDiffSpread(partialDistribution_t& aPd, const char aDim, const build_t& aB) const {
+  const std::vector<double>& v = aB._val;
+  for(size_t k = 0; k + 2 < v.size(); ++k) {
+    const double lSpreadDiff = std::fabs((v[k + 1] - v[k]) - (v[k + 2] - v[k + 1]));
 
     if (lSpreadDiff > aPd.extremeDiff) {
       aPd.extremeDiff = lSpreadDiff;
-      aPd.value = lA->y;
-      aPd.dimension = 'y';
+      aPd.value = v[k];
+      aPd.dimension = aDim;
     }
-
-    lA = lB;
-    lB = lC;
-    lC = nextY(lB, lIterLast);
   }
 }
 
 void 
-MHist2::maxSpread(partialDistribution_t& aPd) const {
-
-  xyc_vt::iterator lIterFirst = aPd.data.beginIter();
-  xyc_vt::iterator lIterLast = aPd.data.endIter();
-  xyc_vt::iterator lA, lB;
-
-  aPd.data.sortX(lIterFirst, lIterLast);
-  lA = lIterFirst;
-  lB = nextX(lA, lIterLast);
-
-  while (lB < lIterLast) {
-    const double lSpread = lB->x - lA->x;
-
-    if (lSpread > aPd.extremeDiff) {
-      aPd.extremeDiff = lSpread;
-      aPd.value = lA->x;
-      aPd.dimension = 'x';
-    }
-
-    lA = lB;
-    lB = nextX(lA, lIterLast);
-  }
-
-  aPd.data.sortY(lIterFirst, lIterLast);
-  lA = lIterFirst;
-  lB = nextY(lA, lIterLast);
-
-  while (lB < lIterLast) {
-    const double lSpread = lB->y - lA->y;
+MHist2::maxSpread(partialDistribution_t& aPd, const char aDim, const build_t& aB) const {
+  const std::vector<double>& v = aB._val;
+  for(size_t k = 0; k + 1 < v.size(); ++k) {
+    const double lSpread = v[k + 1] - v[k];
 
     if (lSpread > aPd.extremeDiff) {
       aPd.extremeDiff = lSpread;
-      aPd.value = lA->y;
-      aPd.dimension = 'y';
+      aPd.value = v[k];
+      aPd.dimension = aDim;
     }
-
-    lA = lB;
-    lB = nextY(lA, lIterLast);
   }
 }
 
 void 
-MHist2::maxDiffCount(partialDistribution_t& aPd) const {
-
-  xyc_vt::iterator lIterFirst = aPd.data.beginIter();
-  xyc_vt::iterator lIterLast = aPd.data.endIter();
-
-  aPd.data.sortX(lIterFirst, lIterLast);
-  xyc_vt::iterator lIter = lIterFirst;
-  uint lC, lCLag = cntX(lIter, lIterLast);
-  lIter = nextX(lIter, lIterLast);
-
-  while ( lIter < lIterLast ) {
-    lC = cntX(lIter, lIterLast);
-    const double lDiff = std::fabs(lC - lCLag);
-
-    if ( aPd.extremeDiff < lDiff ) {
-      aPd.extremeDiff = lDiff;
-      aPd.value = (lIter - 1)->x;
-      aPd.dimension = 'x';
-    }
-
-    lCLag = lC;
-    lIter = nextX(lIter, lIterLast);
-  }
-
-
-  aPd.data.sortY(lIterFirst, lIterLast);
-  lIter = lIterFirst;
-  lCLag = cntY(lIter, lIterLast);
-  lIter = nextY(lIter, lIterLast);
-
-  while ( lIter < lIterLast ) {
-    lC = cntY(lIter, lIterLast);
-    const double lDiff = std::fabs(lC - lCLag);
+MHist2::maxDiffCount(partialDistribution_t& aPd, const char aDim, const build_t& aB) const {
+  const std::vector<double>& v   = aB._val;
+  const std::vector<uint>&   lCnt = aB._cnt;
+  for(size_t k = 1; k < v.size(); ++k) {
+    const uint   lC    = lCnt[k];
+    const uint   lCLag = lCnt[k - 1];
+    const double lDiff = std::fabs(lC - lCLag); // sic: unsigned difference
 
     if ( aPd.extremeDiff < lDiff ) {
       aPd.extremeDiff = lDiff;
-      aPd.value = (lIter - 1)->y;
-      aPd.dimension = 'y';
+      aPd.value = v[k - 1];
+      aPd.dimension = aDim;
     }
-
-    lCLag = lC;
-    lIter = nextY(lIter, lIterLast);
   }
-
 }
 
 void 
-MHist2::maxDiffArea(partialDistribution_t& aPd) const {
-  xyc_vt::iterator lIterFirst = aPd.data.beginIter();
-  xyc_vt::iterator lIterLast = aPd.data.endIter();
-  xyc_vt::iterator lIter, lIterNext;
-  double lAreaLag;
-
-  aPd.data.sortX(lIterFirst, lIterLast);
-  lIter = nextX(lIterFirst, lIterLast);
-  lIterNext = nextX(lIter, lIterLast);
-  lAreaLag = ((lIter->x - lIterFirst->x) * cntX(lIterFirst, lIterLast));
-
-
-  while (lIterNext < lIterLast) {
-    const double lArea = ((lIterNext->x - lIter->x) * cntX(lIter, lIterLast));
-    const double lDiffSpread = std::fabs(lAreaLag - lArea);
-
-    if (lDiffSpread > aPd.extremeDiff) {
-      aPd.extremeDiff = lDiffSpread;
-      aPd.value = (lIter - 1)->x;
-      aPd.dimension = 'x';
-    }
-
-    lAreaLag = lArea;
-    lIter = lIterNext;
-    lIterNext = nextX(lIter, lIterLast);
+MHist2::maxDiffArea(partialDistribution_t& aPd, const char aDim, const build_t& aB) const {
+  const std::vector<double>& v   = aB._val;
+  const std::vector<uint>&   lCnt = aB._cnt;
+  if(3 > v.size()) {
+    return;
   }
-
-
-  aPd.data.sortY(lIterFirst, lIterLast);
-  lIter = nextY(lIterFirst, lIterLast);
-  lIterNext = nextY(lIter, lIterLast);
-  lAreaLag = ((lIter->y - lIterFirst->y) * cntY(lIterFirst, lIterLast));
-
-  while (lIterNext < lIterLast) {
-    const double lArea = ((lIterNext->y - lIter->y) * cntY(lIter, lIterLast));
+  double lAreaLag = ((v[1] - v[0]) * lCnt[0]);
+  for(size_t k = 1; k + 1 < v.size(); ++k) {
+    const double lArea = ((v[k + 1] - v[k]) * lCnt[k]);
     const double lDiffSpread = std::fabs(lAreaLag - lArea);
 
     if (lDiffSpread > aPd.extremeDiff) {
       aPd.extremeDiff = lDiffSpread;
-      aPd.value = (lIter - 1)->y;
-      aPd.dimension = 'y';
+      aPd.value = v[k - 1];
+      aPd.dimension = aDim;
     }
 
     lAreaLag = lArea;
-    lIter = lIterNext;
-    lIterNext = nextY(lIter, lIterLast);
   }
-
 }
 
 void 
-MHist2::minVariance(partialDistribution_t& aPd) const {
-  xyc_vt::iterator lIterFirst = aPd.data.beginIter();
-  xyc_vt::iterator lIterLast = aPd.data.endIter();
+MHist2::minVariance(partialDistribution_t& aPd, const char aDim, const build_t& aB) const {
+  const std::vector<double>& v   = aB._val;
+  const std::vector<uint>&   lCnt = aB._cnt;
 
   Variance<double> lVarLow;
   Variance<double> lVarUp;
-  xyc_vt::iterator lIterA, lIterB;
-
-  aPd.extremeDiff = std::numeric_limits<double>::max();
-
-  aPd.data.sortX(lIterFirst, lIterLast);
-  lVarLow.init();
-  lVarUp.init();
-  for ( xyc_vt::const_iterator lIter = lIterFirst; lIter < lIterLast; ++lIter ) {
-    for(uint c = 0; c < lIter->c; ++c) {
-      lVarUp.step(lIter->x);
-    }
-  }
-
-  lIterA = lIterFirst;
-  lIterB = nextX(lIterA, lIterLast);
-  while(lIterB < lIterLast) {
-    const uint lCnt = cntX(lIterA, lIterLast);
-    for(uint c = 0; c < lCnt; ++c) {
-      lVarLow.step(lIterA->x);
-      lVarUp.reverseStep(lIterA->x);
-    }
-
-    const double lVariance = lVarLow.variance() + lVarUp.variance();
-    if ( lVariance < aPd.extremeDiff ) {
-      aPd.extremeDiff = lVariance;
-      aPd.value = lIterA->x;
-      aPd.dimension = 'x';
-    }
-
-    lIterA = lIterB;
-    lIterB = nextX(lIterA, lIterLast);
-  }
-
-
-
-  aPd.data.sortY(lIterFirst, lIterLast);
   lVarLow.init();
   lVarUp.init();
-  for ( xyc_vt::const_iterator lIter = lIterFirst; lIter < lIterLast; ++lIter ) {
-    for(uint c = 0; c < lIter->c; ++c) {
-      lVarUp.step(lIter->y);
+  for(size_t k = 0; k < v.size(); ++k) {
+    for(uint c = 0; c < lCnt[k]; ++c) {
+      lVarUp.step(v[k]);
     }
   }
 
-  lIterA = lIterFirst;
-  lIterB = nextY(lIterA, lIterLast);
-  while(lIterB < lIterLast) {
-    const uint lCnt = cntY(lIterA, lIterLast);
-    for(uint c = 0; c < lCnt; ++c) {
-      lVarLow.step(lIterA->y);
-      lVarUp.reverseStep(lIterA->y);
+  for(size_t k = 0; k + 1 < v.size(); ++k) {
+    for(uint c = 0; c < lCnt[k]; ++c) {
+      lVarLow.step(v[k]);
+      lVarUp.reverseStep(v[k]);
     }
 
     const double lVariance = lVarLow.variance() + lVarUp.variance();
     if ( lVariance < aPd.extremeDiff ) {
       aPd.extremeDiff = lVariance;
-      aPd.value = lIterA->y;
-      aPd.dimension = 'y';
+      aPd.value = v[k];
+      aPd.dimension = aDim;
     }
-
-    lIterA = lIterB;
-    lIterB = nextY(lIterA, lIterLast);
   }
 }
 
@@ -11,8 +11,22 @@
 
 namespace H2D {
 
+/*
+ * class MHist2
+ * MHist-2 (Poosala, Ioannidis) with various split criteria.
+ * for estimation, the buckets are bulk loaded into a static R-tree
+ * packed by sort-tile-recursive (STR, Leutenegger et al.) with fanout
+ * k_fanout. the nodes are stored level by level, leaves first, root
+ * last, as parallel arrays of their bounding rectangles, the sum of the
+ * frequencies of the buckets below and their children [begin, end)
+ * (buckets for leaves, nodes of the level below otherwise).
+ * a node contained in the query contributes its count, only buckets of
+ * leaves intersecting the query are estimated one by one.
+ */
 
 class MHist2 : public EstimatorBase2dim {
+public:
+  static constexpr uint k_fanout = 8;
 public:
   enum kind_t {
     k_invalid = 0,
@@ -23,21 +37,38 @@ public:
     k_minVariance = 5,
   };
 private:
+  // bucket under construction: points [begin, end) of the permutations
+  // of build_t, split criterion and proposed split
   struct partialDistribution_t {
     double extremeDiff; // min or max diff depending on kind
     double value;
     char dimension;
+    uint begin;
+    uint end;
 
-    Data2dim data;
-
-
-    partialDistribution_t(const Data2dim& aData) :
-      extremeDiff(0.0), value(), dimension(' '), data(aData) {
+    partialDistribution_t(const uint aBegin, const uint aEnd) :
+      extremeDiff(0.0), value(), dimension(' '), begin(aBegin), end(aEnd) {
 
     }
   };
   typedef std::vector<partialDistribution_t> partialDistribution_vt;
 
+  // the points (SoA) and two permutations of them, _idx[0] sorted on x,
+  // _idx[1] sorted on y. every bucket under construction owns the same
+  // range [begin, end) in both, splits partition both ranges in place.
+  // _val, _cnt: distinct values of one dimension of a range and their
+  // frequencies, input to the split criteria.
+  struct build_t {
+    std::vector<double>   _x;
+    std::vector<double>   _y;
+    std::vector<uint>     _c;
+    std::vector<uint32_t> _idx[2];
+    std::vector<uint32_t> _tmp;
+    std::vector<double>   _val;
+    std::vector<uint>     _cnt;
+    build_t() : _x(), _y(), _c(), _idx(), _tmp(), _val(), _cnt() {}
+  };
+
 public:
   MHist2();
   MHist2(const uint      aNumBuckets, 
@@ -51,24 +82,35 @@ public:
 public:
   double estimate(const rectangle_t& aRect) const;
   double estimate(const query_t& lQuery) const;
+  void   estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
 
   uint size() const; //  { return _buckets.size() * (4 * sizeof(double) + sizeof(uint)); };
   virtual std::ostream& print_name_param(std::ostream& os) const;
   std::ostream& printSvg(std::ostream&, const Data2dim& aData, const bool printDot) const;
+  inline uint noBuckets() const { return _buckets.size(); }
+  inline uint noNodes() const { return _nodeCount.size(); }
 private:
-  void maxDiffSpread(partialDistribution_t& aPd) const;
-  void maxSpread(partialDistribution_t& aPd) const;
-  void maxDiffCount(partialDistribution_t& aPd) const;
-  void maxDiffArea(partialDistribution_t& aPd) const;
-  void minVariance(partialDistribution_t& aPd) const;
-
-  inline xyc_vt::iterator nextX(xyc_vt::iterator aIter, const xyc_vt::iterator& aIterEnd) const { while (++aIter < aIterEnd && (aIter - 1)->x == aIter->x){}; return aIter; };
-  inline xyc_vt::iterator nextY(xyc_vt::iterator aIter, const xyc_vt::iterator& aIterEnd) const { while (++aIter < aIterEnd && (aIter - 1)->y == aIter->y){}; return aIter; };
-  inline uint cntX(xyc_vt::iterator aIter, const xyc_vt::iterator& aIterEnd) const { uint lRes = aIter->c; while (++aIter < aIterEnd && (aIter - 1)->x == aIter->x){lRes += aIter->c;}; return lRes; };
-  inline uint cntY(xyc_vt::iterator aIter, const xyc_vt::iterator& aIterEnd) const { uint lRes = aIter->c; while (++aIter < aIterEnd && (aIter - 1)->y == aIter->y){lRes += aIter->c;}; return lRes; };
+  void buildRTree();
+  void strSort(std::vector<uint>& aIdx, const std::vector<rectangle_t>& aRect) const;
+private:
+  void evaluate(partialDistribution_t& aPd, build_t& aB) const;
+  uint split(const partialDistribution_t& aPd, build_t& aB) const;
+  void maxDiffSpread(partialDistribution_t& aPd, const char aDim, const build_t& aB) const;
+  void maxSpread(partialDistribution_t& aPd, const char aDim, const build_t& aB) const;
+  void maxDiffCount(partialDistribution_t& aPd, const char aDim, const build_t& aB) const;
+  void maxDiffArea(partialDistribution_t& aPd, const char aDim, const build_t& aB) const;
+  void minVariance(partialDistribution_t& aPd, const char aDim, const build_t& aB) const;
 private:
   kind_t                    _kind;
-  std::vector<MHist2Bucket> _buckets;
+  std::vector<MHist2Bucket> _buckets;    // in STR order
+  std::vector<double>       _nodeXlo;    // R-tree nodes, leaves first, root last
+  std::vector<double>       _nodeYlo;
+  std::vector<double>       _nodeXhi;
+  std::vector<double>       _nodeYhi;
+  std::vector<double>       _nodeCount;  // sum of the frequencies of the buckets below
+  std::vector<uint32_t>     _nodeBegin;  // children [begin, end)
+  std::vector<uint32_t>     _nodeEnd;
+  uint                      _noLeaves;   // nodes [0, _noLeaves) are leaves
 };
 
 
@@ -9,6 +9,9 @@ MHist2Bucket::MHist2Bucket(const Data2dim& aData) : _rect(), _c(aData.total()) {
 
 }
 
+MHist2Bucket::MHist2Bucket(const rectangle_t& aRect, const uint aC) : _rect(aRect), _c(aC) {
+}
+
 MHist2Bucket::~MHist2Bucket() {
 
 }
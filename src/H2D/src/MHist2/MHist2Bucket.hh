@@ -10,6 +10,7 @@ namespace H2D {
 class MHist2Bucket {
   public:
     MHist2Bucket(const Data2dim& aData);
+    MHist2Bucket(const rectangle_t& aRect, const uint aC);
     virtual ~MHist2Bucket();
   public:
     inline bool operator==(const MHist2Bucket& x) const { return (xlo() == x.xlo() && ylo() == x.ylo() && xhi() == x.xhi() && yhi() == x.yhi()); }
@@ -26,6 +27,8 @@ class MHist2Bucket {
     inline double ylo() const { return _rect.ylo(); }
     inline double xhi() const { return _rect.xhi(); }
     inline double yhi() const { return _rect.yhi(); }
+    inline const rectangle_t& rect() const { return _rect; }
+    inline uint   c() const { return _c; }
   private:
     rectangle_t _rect;
     uint _c;
@@ -1,4 +1,5 @@
 #include "OneDEqDepHist.hh"
+#include "../../../infra/binary_search.hh"
 
 namespace H2D {
 
@@ -11,12 +12,14 @@ OneDEqDepHist::OneDEqDepHist(const Data2dim& aData,
                      const bool      aTrace)
               : EstimatorBase2dim(aQ, aTheta),
                 _outlier(), 
+                _outlierIndex(),
                 _nx(aN), 
                 _phi(aPhi),
                 _vx(),
 		_vy(),
                 _trace(aTrace),
-                _totalCard(aData.total()){
+                _totalCard(aData.total()),
+                _xlo(), _xhi(), _ylo(), _yhi() {
   if(trace()) {
     std::cout << "1D Equi-Depth-Histogram: param: " << nx() << ", " << aPhi << std::endl;
   }
@@ -41,11 +44,13 @@ OneDEqDepHist::OneDEqDepHist(const Data2dim& aData,
   Data2dim lRegular;
   if(8 < aPhi) {
     aData.split(lRegular, _outlier, aPhi);
+    _outlierIndex.init(_outlier);
   } else {
     lRegular = aData;
   }
 
   initV(lRegular);
+  initSoA();
 
 }
 
@@ -132,6 +137,23 @@ OneDEqDepHist::initV(Data2dim& aData) {
 
 
 
+// the buckets in use are followed by default entries (cf 0)
+void
+OneDEqDepHist::initSoA() {
+  _xlo.clear();
+  _xhi.clear();
+  for(uint i = 0; i < vx().size() && 0 < vx()[i].cf(); ++i) {
+    _xlo.push_back(vx()[i].lo());
+    _xhi.push_back(vx()[i].hi());
+  }
+  _ylo.clear();
+  _yhi.clear();
+  for(uint i = 0; i < vy().size() && 0 < vy()[i].cf(); ++i) {
+    _ylo.push_back(vy()[i].lo());
+    _yhi.push_back(vy()[i].hi());
+  }
+}
+
 uint
 OneDEqDepHist::findEnd(const Data2dim& aData,
                    const uint aBegin, // beginning of new bucket
@@ -229,83 +251,57 @@ OneDEqDepHist::estimateY(const query_t& lQuery) const {
 
 
 
-double
-OneDEqDepHist::estimateIntervalsX(const rectangle_t& r) const {
-  double lRes = 0.0;
-  uint lower = 0;
-  uint upper = vx().size();
-  
-  for(uint i = 0; i < vx().size(); ++i) {
-    if(vx()[i].hi() <= r.xlo()) {
-     lower = i;	    
-     continue;
-    }
-  //  lower = i;
-    if(r.xhi() <= vx()[i].lo()) {
-      upper = i; //actually next bucket after r	    
-      break;
+/*
+ * estimateIntervalsX/Y
+ * formerly a scan over the buckets: lower is the last bucket with
+ * hi <= lo(query), upper the first following one with lo >= hi(query).
+ * bounds are non-decreasing over the non-empty buckets, so both are found
+ * by binary search; the default entries (lo = hi = 0) behind them are
+ * treated as the scan did.
+ */
+
+uint
+OneDEqDepHist::noBucketsTouched(const std::vector<double>& aLo, const std::vector<double>& aHi,
+                                const uint aSize, const double aQlo, const double aQhi) {
+  const uint n = aLo.size();
+  const uint lNoBefore = upper_bound_branchless(aQlo, aHi.data(), n); // hi <= aQlo
+  const uint lAfter    = std::max<uint>(lNoBefore, lower_bound_branchless(aQhi, aLo.data(), n));
+  uint lower = (0 < lNoBefore) ? (lNoBefore - 1) : 0;
+  uint upper = aSize;
+  if(lAfter < n) {
+    upper = lAfter;
+  } else
+  if(n < aSize) {
+    if(0 <= aQlo) {
+      lower = aSize - 1;
+    } else
+    if(aQhi <= 0) {
+      upper = n;
     }
   }
- /* 
-   for (uint i = 0; i < vy().size(); ++i) {
-        if (vx()[i].lo() > r.xhi()) {
-            upper = i;
-            break;
-        }
-        if (vx()[i].hi() >= r.xlo()) {
-            lower = i;
-        }
-    }*/
-  //std::cout<<"lower:"<<vx()[lower].lo()<<" upper:"<<vx()[upper].hi()<<std::endl;
-  //std::cout<<"xlo:"<<r.xlo()<<" xhi:"<<r.xhi()<<std::endl;
-  lRes = (upper - lower) * (_totalCard / nx()); 
-  return lRes;
+  return (upper - lower);
 }
 
-
+double
+OneDEqDepHist::estimateIntervalsX(const rectangle_t& r) const {
+  const uint lNoBuckets = noBucketsTouched(_xlo, _xhi, vx().size(), r.xlo(), r.xhi());
+  return lNoBuckets * (_totalCard / nx());
+}
 
 double
 OneDEqDepHist::estimateIntervalsY(const rectangle_t& r) const {
-  double lRes = 0.0;
-  uint lower = 0;
-  uint upper = vx().size();
-  for(uint i = 0; i < vy().size(); ++i) {
-    if(vy()[i].hi() <= r.ylo()) {
-      lower = i;	    
-      continue;
-    }
-    //lower = i;
-    if(r.yhi() <= vy()[i].lo()) {
-      upper = i;
-      break;
-    }
-  }
-  lRes = (upper - lower ) * (_totalCard/nx());
-  return lRes;
+  const uint lNoBuckets = noBucketsTouched(_ylo, _yhi, vx().size(), r.ylo(), r.yhi());
+  return lNoBuckets * (_totalCard / nx());
 }
 
 uint
 OneDEqDepHist::outlierCountX(const rectangle_t& r) const { //TODO:add dim for x or y
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r._pll.x <= p.x && r._pur.x > p.x) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithinX(r._pll.x, r._pur.x);
 }
 
 uint
 OneDEqDepHist::outlierCountY(const rectangle_t& r) const { //TODO:add dim for x or y
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r._pll.y <= p.y && r._pur.y > p.y) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithinY(r._pll.y, r._pur.y);
 }
 
 
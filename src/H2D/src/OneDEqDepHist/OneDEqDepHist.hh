@@ -7,6 +7,7 @@
 #include "infra/types.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/summaryline.hh"
 
@@ -75,8 +76,13 @@ uint   size() const;
     inline void trace(const bool x) { _trace = x; }
   private:
     void initV(Data2dim& aData);
+    void initSoA();
+    // (upper - lower) of the former bucket scan over a, see estimateIntervalsX
+    static uint noBucketsTouched(const std::vector<double>& aLo, const std::vector<double>& aHi,
+                                 const uint aSize, const double aQlo, const double aQhi);
   private:
     Data2dim   _outlier;
+    OutlierIndex _outlierIndex;
     uint       _nx;
     const uint _phi;
     entry_vt   _vx;
@@ -84,6 +90,10 @@ uint   size() const;
     //regp_at    _regp; // array
     bool       _trace;
     uint       _totalCard;
+    std::vector<double> _xlo; // bounds of the non-empty buckets of _vx
+    std::vector<double> _xhi;
+    std::vector<double> _ylo; // bounds of the non-empty buckets of _vy
+    std::vector<double> _yhi;
 };
 
 
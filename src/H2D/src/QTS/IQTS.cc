@@ -9,14 +9,17 @@ namespace H2D {
  */
 
 
-IQTS::Node::Node(const Data2dim&     aData,
+IQTS::Node::Node(const Data2dim&     aPoints,
+                const uint           aBegin,
+                const uint           aEnd,
                 const rectangle_t&   aBr,
                 const uint           aLevel,
                 const IQTS&          aIQTS,
                 const bool           a11) // for this one, no cum freq stored
-            : _data(aData),
+            : _begin(aBegin),
+              _end(aEnd),
               _br(aBr),
-              _cumFreq(aData.total()),
+              _cumFreq(aPoints.total(aBegin, aEnd)),
               _sse(0),
               _child(),
               _level(aLevel),
@@ -31,19 +34,19 @@ IQTS::Node::Node(const Data2dim&     aData,
     }
   }
 
-  prepareEncoding(aData, aBr, aIQTS);
+  prepareEncoding(aPoints, aBr, aIQTS);
   if(hasRefinement()) {
     _sizeInBits += 64;
   }
 
   if(k_l2_sse == aIQTS.kind() || k_lq_sse == aIQTS.kind()) {
-    _sse = aData.sse(0, aData.size()); // in paper: sse! 
+    _sse = aPoints.sse(aBegin, aEnd); // in paper: sse! 
   } else
   if(k_l2_var == aIQTS.kind() || k_lq_var == aIQTS.kind()) {
-    _sse = aData.variance(0, aData.size()); 
+    _sse = aPoints.variance(aBegin, aEnd); 
   } else
   if(k_l2_card == aIQTS.kind() || k_lq_card == aIQTS.kind()) {
-    _sse = aData.total();
+    _sse = cumFreq();
   } else {
     assert(0 > 1);
   }
@@ -61,42 +64,37 @@ IQTS::Node::~Node() {
 
 
 void
-IQTS::Node::performSplit(const IQTS& aIQTS) {
+IQTS::Node::performSplit(Data2dim& aPoints, const IQTS& aIQTS) {
   if(aIQTS.trace()) {
     std::cout << "split Node" << nodeId() << '@' << level() << ": "
               << "   w = " << sse()
               << std::endl;
   }
 
-  data2dim_at        lPartition(2,2);
+  // child (i,j) gets [lTileBegin[2i+j], lTileBegin[2i+j+1])
+  uint               lTileBegin[2*2 + 1];
   partitiondescxy_t  lPdXY(br(), 2, 2);
-  for(uint i = 0; i < data().size(); ++i) {
-    const xyc_t& e = data()[i];
-    const uint lIdxX = lPdXY.idxXcorrected(e.x);
-    const uint lIdxY = lPdXY.idxYcorrected(e.y);
-    if(lIdxX < 2 && lIdxY < 2) {
-      lPartition(lIdxX, lIdxY).push_back(e);
-    }
-  }
-
+  aPoints.partitionTiles(lPdXY, begin(), end(), lTileBegin);
 
   rectangle_t lChildBr;
   for(uint i = 0; i < 2; ++i) {
     for(uint j = 0; j < 2; ++j) {
-      if(0 < lPartition(i,j).size()) {
+      const uint lBegin = lTileBegin[2*i + j];
+      const uint lEnd   = lTileBegin[2*i + j + 1];
+      if(lBegin < lEnd) {
         lPdXY.getRectangle(i, j, lChildBr);
-        _child[i][j]  = new Node(lPartition(i,j), lChildBr, level() + 1, aIQTS, 2 == (i+j));
+        _child[i][j]  = new Node(aPoints, lBegin, lEnd, lChildBr, level() + 1, aIQTS, 2 == (i+j));
       }
       if(aIQTS.trace()) {
-        std::cout << "   size(" << i << ',' << j << ") = " << lPartition(i,j).size() << std::endl;
+        std::cout << "   size(" << i << ',' << j << ") = " << (lEnd - lBegin) << std::endl;
       }
     }
   }
 }
 
 void
-IQTS::Node::prepareEncoding(const Data2dim& aData, const rectangle_t aBr, const IQTS& aIQTS) {
-  const double lTotal = aData.total();
+IQTS::Node::prepareEncoding(const Data2dim& aPoints, const rectangle_t aBr, const IQTS& aIQTS) {
+  const double lTotal = cumFreq();
 
   if(0 >= lTotal) {
     _hasRefinement = false;
@@ -104,8 +102,8 @@ IQTS::Node::prepareEncoding(const Data2dim& aData, const rectangle_t aBr, const
     return;
   }
 
-  RegularPartitioning2dim lRegP4x4(aBr, 4, 4, aData);
-  RegularPartitioning2dim lRegP8x8(aBr, 8, 8, aData);
+  RegularPartitioning2dim lRegP4x4(aBr, 4, 4, aPoints, begin(), end());
+  RegularPartitioning2dim lRegP8x8(aBr, 8, 8, aPoints, begin(), end());
 
   Matrix M4x4(4,4);
   Matrix M8x8(8,8);
@@ -280,92 +278,14 @@ IQTS::Node::errorLQ_8x8(const Matrix& M8x8Tru, const Matrix& M8x8Est, const doub
 
 
 double
-IQTS::Node::estimate(const rectangle_t& aQueryRectangle, const rectangle_t& aBr, const IQTS& aIQTS) const {
-  if(aIQTS.trace()) {
-    std::cout << std::string(2*level(), ' ')
-              << "Node[" << nodeId() << "]::estimate: " << aQueryRectangle << "  " << aBr << std::endl;
-  }
-
-  // if the query rectangle contains the bounding rectangle, we are done
-  if(aQueryRectangle.contains(aBr)) {
-    if(aIQTS.trace()) {
-      std::cout << std::string(2*level(), ' ')
-                << "note: fully contained." << std::endl;
-    }
-    return cumFreq();
-  }
-
-  rectangle_t lIsec;
-  lIsec.isec(aQueryRectangle, aBr);
-
-  // if the intersection between query rectangle and bounding rectangle is empty, we are done
-  if(lIsec.hasZeroArea()) {
-    if(aIQTS.trace()) {
-      std::cout << std::string(2*level(), ' ')
-                << "note empty intersection." << std::endl;
-    }
-    return 0;
-  }
-
-
-  if(isLeaf()) {
-    double lEstimate = 0;
-    if(hasRefinement()) {
-      switch(getKindLT()) {
-        case k_lt_23:
-           lEstimate = estimateLT23(aQueryRectangle, aBr, aIQTS);
-           break;
-        case k_lt_24:
-           lEstimate = estimateLT24(aQueryRectangle, aBr, aIQTS);
-           break;
-        case k_lt_2p:
-           std::cout << "IQTS::Node::estimate: k_lt_2p: NYI." << std::endl;
-           std::cerr << "IQTS::Node::estimate: k_lt_2p: NYI." << std::endl;
-           assert(0 > 1);
-           break;
-        default:
-           std::cout << "IQTS::Node::estimate: OOPS." << std::endl;
-           std::cerr << "IQTS::Node::estimate: OOPS." << std::endl;
-           assert(0 > 1);
-           break;
-      }
-    } else {
-      lEstimate =  ((lIsec.area() / aBr.area()) * cumFreq());
-      if(aIQTS.trace()) {
-        std::cout << std::string(2*level(), ' ')
-                  << "note: non-refined leaf with cumfreq: " << cumFreq() 
-                  << " results in estimate " << lEstimate
-                  << std::endl;
-      }
-    }
-    return lEstimate;
-  }
-
-  double lEstimate = 0;
-
-  partitiondescxy_t lPd(aBr, 2, 2);
-  rectangle_t       lTile;
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lPd.getRectangle(i, j, lTile);
-        lEstimate += child(i, j)->estimate(lIsec, lTile, aIQTS);
-      }
-    }
-  }
-
-  return lEstimate;
-}
-
-
-double
-IQTS::Node::estimateLT23(const rectangle_t& aQueryRectangle,
-                         const rectangle_t& aBoundingRectangle,
-                         const IQTS&         aIQTS) const {
+IQTS::Node::estimateLT23(const uint64_t     aCode,
+                         const double       aCumFreq,
+                         const rectangle_t& aQueryRectangle,
+                         const rectangle_t& aBoundingRectangle) {
   double lEstimate = 0;
 
   Matrix M4x4(4,4);
-  decode23LT(code(), cumFreq(), M4x4, 0, 0);
+  decode23LT(aCode, aCumFreq, M4x4, 0, 0);
 
   partitiondescxy_t lPd(aBoundingRectangle, 4, 4);
 
@@ -381,23 +301,17 @@ IQTS::Node::estimateLT23(const rectangle_t& aQueryRectangle,
     }
   }
 
-  if(aIQTS.trace()) {
-    std::cout << std::string(2*level(), ' ')
-              << "note: 2/3-LT leaf: " << cumFreq() 
-              << " results in estimate " << lEstimate
-              << std::endl;
-  }
-
   return lEstimate;
 }
 
 double
-IQTS::Node::estimateLT24(const rectangle_t& aQueryRectangle,
-                         const rectangle_t& aBoundingRectangle,
-                         const IQTS&         aIQTS) const {
+IQTS::Node::estimateLT24(const uint64_t     aCode,
+                         const double       aCumFreq,
+                         const rectangle_t& aQueryRectangle,
+                         const rectangle_t& aBoundingRectangle) {
   double lEstimate = 0;
   Matrix M8x8(8,8);
-  decode24LT(code(), cumFreq(), M8x8);
+  decode24LT(aCode, aCumFreq, M8x8);
 
   partitiondescxy_t lPd(aBoundingRectangle, 4, 4);
 
@@ -413,13 +327,6 @@ IQTS::Node::estimateLT24(const rectangle_t& aQueryRectangle,
     }
   }
 
-  if(aIQTS.trace()) {
-    std::cout << std::string(2*level(), ' ')
-              << "note: 2/4-LT leaf: " << cumFreq() 
-              << " results in estimate " << lEstimate
-              << std::endl;
-  }
-
   return lEstimate;
 }
 
@@ -439,104 +346,6 @@ IQTS::Node::depth() const {
   return 1 + lChildDepth;
 }
 
-uint
-IQTS::Node::noNodes() const {
-  uint lRes = 1; // this
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lRes += child(i, j)->noNodes();
-      }
-    }
-  } 
-  return lRes;
-}
-
-
-uint
-IQTS::Node::noNotRefined() const {
-  uint lRes = hasRefinement() ? 0 : 1; // this
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lRes += child(i, j)->noNotRefined();
-      }
-    }
-  }
-  return lRes;
-}
-
-uint
-IQTS::Node::noLT23() const {
-  uint lRes = 0;
-  if(hasRefinement() && k_lt_23 == getKindLT()) {
-    lRes = 1;
-  }
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lRes += child(i, j)->noLT23();
-      }
-    }
-  }
-  return lRes;
-}
-
-uint
-IQTS::Node::noLT24() const {
-  uint lRes = 0;
-  if(hasRefinement() && k_lt_24 == getKindLT()) {
-    lRes = 1;
-  }
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lRes += child(i, j)->noLT24();
-      }
-    }
-  }
-  return lRes;
-}
-
-
-uint
-IQTS::Node::noLT2p() const {
-  uint lRes = 0;
-  if(hasRefinement() && k_lt_2p == getKindLT()) {
-    lRes = 1;
-  }
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lRes += child(i, j)->noLT2p();
-      }
-    }
-  }
-  return lRes;
-}
-
-
-std::ostream&
-IQTS::Node::print(std::ostream& os) const {
-  std::cout << std::string(2 * level(), ' ') 
-            << "node[" << nodeId() << "] "
-            << " br " << br() 
-            << " cf " << cumFreq() 
-            << " ref " << hasRefinement() 
-            << " LTk " << getKindLT() 
-            << " bv  " << Bitvector64(code())
-            << std::endl;
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        child(i, j)->print(os);
-      }
-    }
-  }
-  return os;
-}
-
-
 uint64_t
 IQTS::Node::encode2x2(const double f00, const double f01, const double f10, const double f11,
                       const double aTotal, const uint aNoBits1, const uint aNoBits2) {
@@ -905,12 +714,16 @@ IQTS::IQTS(const Data2dim& aData,
          const double    aTheta,
          const bool      aTrace) : EstimatorBase2dim(aQ, aTheta),
                                    _outlier(),
+                                   _outlierIndex(),
                                    _br(),
                                    _kind(aKind),
                                    _budget(aBudget * 8),
                                    _size(0),
                                    _phi(aPhi),
                                    _root(0),
+                                   _nodes(),
+                                   _depth(0),
+                                   _height(0),
                                    _nodeCount(0),
                                    _trace(aTrace) {
   init(aData);
@@ -943,20 +756,23 @@ IQTS::~IQTS() {
 
 void
 IQTS::init(const Data2dim& aData) {
-  Data2dim lRegular;
   if(8 < phi()) {
+    Data2dim lRegular;
     aData.split(lRegular, _outlier, phi());
+    _outlierIndex.init(_outlier);
+    lRegular.getBoundingRectangle(_br);
   } else {
-    lRegular = aData;
+    aData.getBoundingRectangle(_br);
   }
 
-  lRegular.getBoundingRectangle(_br);
+  // the only copy of the data points, permuted by performSplit
+  Data2dim lPoints(aData);
 
   heap_t lHeap;
-  _root = new Node(aData, br(), 0, (*this), false);
+  _root = new Node(lPoints, 0, lPoints.size(), br(), 0, (*this), false);
   lHeap.push(_root);
 
-  uint lTotalSize = root()->sizeInBits();
+  uint lTotalSize = _root->sizeInBits();
 
   if(trace()) {
     std::cout << "before main loop: " << budget() << " <?= " << lTotalSize << std::endl;
@@ -964,8 +780,8 @@ IQTS::init(const Data2dim& aData) {
   while(budget() > lTotalSize) {
     Node* lTop = lHeap.top();
     lHeap.pop();
-    if(7 > lTop->data().size()) { continue; }
-    lTop->performSplit(*this);
+    if(7 > lTop->size()) { continue; }
+    lTop->performSplit(lPoints, *this);
     for(uint i = 0; i < 2; ++i) {
       for(uint j = 0; j < 2; ++j) {
         Node* lChild = lTop->child(i,j);
@@ -982,6 +798,48 @@ IQTS::init(const Data2dim& aData) {
 
   _size = lTotalSize;
 
+  freeze();
+}
+
+void
+IQTS::freeze() {
+  _nodes.clear();
+  _depth  = 0;
+  _height = 0;
+  if(0 == _root) {
+    return;
+  }
+  _depth = _root->depth();
+
+  // breadth first, the children of lOrder[k] are appended when k is visited
+  std::vector<const Node*> lOrder(1, _root);
+  std::vector<uint>        lLevel(1, 1);
+  for(uint k = 0; k < lOrder.size(); ++k) {
+    const Node* lNode = lOrder[k];
+    flatnode_t lFlat;
+    lFlat._cumFreq       = lNode->cumFreq();
+    lFlat._code          = lNode->code();
+    lFlat._child         = lOrder.size();
+    lFlat._childMask     = 0;
+    lFlat._hasRefinement = lNode->hasRefinement();
+    for(uint i = 0; i < 2; ++i) {
+      for(uint j = 0; j < 2; ++j) {
+        if(0 != lNode->child(i, j)) {
+          lFlat._childMask |= (1 << (2 * i + j));
+          lOrder.push_back(lNode->child(i, j));
+          lLevel.push_back(lLevel[k] + 1);
+        }
+      }
+    }
+    if(0 == lFlat._childMask) {
+      lFlat._child = 0;
+    }
+    _nodes.push_back(lFlat);
+  }
+  _height = lLevel.back();
+
+  delete _root;
+  _root = 0;
 }
 
 
@@ -997,28 +855,116 @@ IQTS::estimate(const query_t& lQuery) const {
 double
 IQTS::estimate(const rectangle_t& r) const {
   double lEstimate = 0;
-  if(0 != root()) {
-    lEstimate = root()->estimate(r, br(), (*this));
+  if(!_nodes.empty()) {
+    lEstimate = estimateTree(r);
   }
   lEstimate += (double) outlierCount(r);
   return std::max<double>(1.0, lEstimate);
 }
 
+// estimate of node aNode with bounding rectangle aBr for aQuery.
+// returns true if the node must be refined by its children for the
+// query aIsecOut (aQuery clipped to aBr), false if aEstimateOut is final.
+bool
+IQTS::estimateNode(const uint aNode, const rectangle_t& aQuery, const rectangle_t& aBr,
+                   rectangle_t& aIsecOut, double& aEstimateOut) const {
+  const flatnode_t& lNode = _nodes[aNode];
 
+  // if the query rectangle contains the bounding rectangle, we are done
+  if(aQuery.contains(aBr)) {
+    aEstimateOut = lNode._cumFreq;
+    return false;
+  }
 
-uint
-IQTS::outlierCount(const rectangle_t& r) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
+  // if the intersection between query rectangle and bounding rectangle is empty, we are done
+  aIsecOut.isec(aQuery, aBr);
+  if(aIsecOut.hasZeroArea()) {
+    aEstimateOut = 0;
+    return false;
+  }
+
+  if(0 != lNode._childMask) {
+    return true;
+  }
+
+  if(lNode._hasRefinement) {
+    switch(Node::getKindLT(lNode._code)) {
+      case Node::k_lt_23:
+         aEstimateOut = Node::estimateLT23(lNode._code, lNode._cumFreq, aQuery, aBr);
+         break;
+      case Node::k_lt_24:
+         aEstimateOut = Node::estimateLT24(lNode._code, lNode._cumFreq, aQuery, aBr);
+         break;
+      case Node::k_lt_2p:
+         std::cout << "IQTS::estimateNode: k_lt_2p: NYI." << std::endl;
+         std::cerr << "IQTS::estimateNode: k_lt_2p: NYI." << std::endl;
+         assert(0 > 1);
+         break;
+      default:
+         std::cout << "IQTS::estimateNode: OOPS." << std::endl;
+         std::cerr << "IQTS::estimateNode: OOPS." << std::endl;
+         assert(0 > 1);
+         break;
+    }
+  } else {
+    aEstimateOut = ((aIsecOut.area() / aBr.area()) * lNode._cumFreq);
+  }
+  return false;
+}
+
+// depth first over _nodes with an explicit stack of the nodes to be
+// refined. a popped node settles its children or pushes them in turn,
+// at most three more nodes per level are pending.
+double
+IQTS::estimateTree(const rectangle_t& aQuery) const {
+  double      lEstimate = 0;
+  rectangle_t lIsec;
+  if(!estimateNode(0, aQuery, br(), lIsec, lEstimate)) {
+    return lEstimate;
+  }
+
+  pending_t              lLocal[k_max_local_stack];
+  std::vector<pending_t> lNonLocal;
+  pending_t*             lStack = lLocal;
+  if(k_max_local_stack < 3 * _height + 1) {
+    lNonLocal.resize(3 * _height + 1);
+    lStack = lNonLocal.data();
+  }
+
+  double lRes = 0;
+  uint   lTop = 0;
+  lStack[lTop++].init(0, br(), lIsec);
+  rectangle_t lTile;
+  rectangle_t lQuery;
+  while(0 < lTop) {
+    const pending_t   lPending = lStack[--lTop];
+    const flatnode_t& lNode    = _nodes[lPending._node];
+    lPending.query(lQuery);
+    uint lChild = lNode._child;
+    for(uint k = 0; k < 4; ++k) {
+      if(0 == (lNode._childMask & (1 << k))) {
+        continue;
+      }
+      lPending.tile(k >> 1, k & 1, lTile);
+      if(estimateNode(lChild, lQuery, lTile, lIsec, lEstimate)) {
+        lStack[lTop++].init(lChild, lTile, lIsec);
+      } else {
+        lRes += lEstimate;
+      }
+      ++lChild;
     }
   }
   return lRes;
 }
 
 
+
+uint
+IQTS::outlierCount(const rectangle_t& r) const {
+  return _outlierIndex.countWithin(r);
+}
+
+
 uint
 IQTS::size() const {
   return (_size / 8);
@@ -1026,61 +972,79 @@ IQTS::size() const {
 
 uint
 IQTS::depth() const {
-  if(0 == root()) {
-    return 0;
-  }
-  return root()->depth();
+  return _depth;
 }
 
 uint
 IQTS::noNodes() const {
-  if(0 == root()) {
-    return 0;
+  return _nodes.size();
+}
+
+// number of nodes with refinement of kind aKindLT, or without refinement if !aRefined
+uint
+IQTS::noNodesWith(const bool aRefined, const Node::kind_LT_t aKindLT) const {
+  uint lRes = 0;
+  for(const flatnode_t& lNode : _nodes) {
+    if(aRefined) {
+      lRes += (lNode._hasRefinement && aKindLT == Node::getKindLT(lNode._code));
+    } else {
+      lRes += !lNode._hasRefinement;
+    }
   }
-  return root()->noNodes();
+  return lRes;
 }
 
 uint
 IQTS::noNotRefined() const {
-  if(0 == root()) {
-    return 0;
-  }
-  return root()->noNotRefined();
+  return noNodesWith(false, Node::k_lt_no_lt);
 }
 
 uint
 IQTS::noLT23() const {
-  if(0 == root()) {
-    return 0;
-  }
-  return root()->noLT23();
+  return noNodesWith(true, Node::k_lt_23);
 }
 
 uint
 IQTS::noLT24() const {
-  if(0 == root()) {
-    return 0;
-  }
-  return root()->noLT24();
+  return noNodesWith(true, Node::k_lt_24);
 }
 
-
 uint
 IQTS::noLT2p() const {
-  if(0 == root()) {
-    return 0;
-  }
-  return root()->noLT2p();
+  return noNodesWith(true, Node::k_lt_2p);
 }
 
 
-
+std::ostream&
+IQTS::printNode(std::ostream& os, const uint aNode, const rectangle_t& aBr, const uint aLevel) const {
+  const flatnode_t& lNode = _nodes[aNode];
+  std::cout << std::string(2 * aLevel, ' ') 
+            << "node[" << aNode << "] "
+            << " br " << aBr 
+            << " cf " << lNode._cumFreq 
+            << " ref " << lNode._hasRefinement 
+            << " LTk " << Node::getKindLT(lNode._code) 
+            << " bv  " << Bitvector64(lNode._code)
+            << std::endl;
+  partitiondescxy_t lPd(aBr, 2, 2);
+  rectangle_t       lTile;
+  uint lChild = lNode._child;
+  for(uint k = 0; k < 4; ++k) {
+    if(0 != (lNode._childMask & (1 << k))) {
+      lPd.getRectangle(k >> 1, k & 1, lTile);
+      printNode(os, lChild++, lTile, aLevel + 1);
+    }
+  }
+  return os;
+}
 
 std::ostream&
 IQTS::print(std::ostream& os) const {
   std::cout << "IQTS: " << std::endl;
   std::cout << "  tree:" << std::endl;
-  _root->print(os);
+  if(!_nodes.empty()) {
+    printNode(os, 0, br(), 0);
+  }
   return os;
 }
 
@@ -12,6 +12,7 @@
 #include "infra/types.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/RegularPartitioning2dim.hh"
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/summaryline.hh"
@@ -20,6 +21,9 @@
 /*
  * IQTS/IIQTS
  * Buccafurri, Furfaro, Sacca, Sirangelo 2003
+ * built as QTS over ranges of one copy of the data points.
+ * after construction, the tree is frozen into _nodes as in QTS:
+ * breadth first, children in Morton order, bounding rectangles implicit.
  */
 
 namespace H2D {
@@ -44,7 +48,6 @@ class IQTS : public EstimatorBase2dim {
         friend class IQTS;
         Node(const Node&);
         Node& operator=(const Node&);
-        typedef array_tt<Data2dim> data2dim_at;
       public:
         enum kind_LT_t {
                k_lt_23 = 0,
@@ -66,14 +69,18 @@ class IQTS : public EstimatorBase2dim {
                            return getKindLT(code());
                          }
       public:
-        Node(const Data2dim&    aData, 
+        Node(const Data2dim&    aPoints,
+             const uint         aBegin,
+             const uint         aEnd,
              const rectangle_t& aBr,
              const uint         aLevel,
              const IQTS&        aIQTS,
              const bool         a11);
         ~Node();
       public:
-        inline const Data2dim&    data() const { return _data; }
+        inline       uint         begin() const { return _begin; }
+        inline       uint         end() const { return _end; }
+        inline       uint         size() const { return (_end - _begin); }
         inline const rectangle_t& br() const { return _br; }
         inline       double       cumFreq() const { return _cumFreq; }
         inline       double       sse() const { return _sse; }
@@ -90,14 +97,9 @@ class IQTS : public EstimatorBase2dim {
         inline       uint64_t     code() const { return _code; }
       public:
         uint depth() const;
-        uint noNodes() const;
-        uint noNotRefined() const;
-        uint noLT23() const;
-        uint noLT24() const;
-        uint noLT2p() const;
       public:
-        void performSplit(const IQTS& aIQTS);
-        void prepareEncoding(const Data2dim& aData, const rectangle_t aBr, const IQTS& aIQTS);
+        void performSplit(Data2dim& aPoints, const IQTS& aIQTS);
+        void prepareEncoding(const Data2dim& aPoints, const rectangle_t aBr, const IQTS& aIQTS);
       public:
         static double errorL2(const Matrix& M8x8Tru, const double aAvg);
         static double errorLQ(const Matrix& M8x8Tru, const double aAvg, const double aTheta);
@@ -106,15 +108,14 @@ class IQTS : public EstimatorBase2dim {
         static double errorL2_8x8(const Matrix& M8x8Tru, const Matrix& M8x8Est);
         static double errorLQ_8x8(const Matrix& M8x8Tru, const Matrix& M8x8Est, const double aTheta);
       public:
-        double estimate(const rectangle_t& aQueryRectangle, 
-                        const rectangle_t& aBoundingRectangle,
-                        const IQTS&         aIQTS) const;
-        double estimateLT23(const rectangle_t& aQueryRectangle, 
-                            const rectangle_t& aBoundingRectangle,
-                            const IQTS&         aIQTS) const;
-        double estimateLT24(const rectangle_t& aQueryRectangle, 
-                            const rectangle_t& aBoundingRectangle,
-                            const IQTS&         aIQTS) const;
+        static double estimateLT23(const uint64_t     aCode,
+                                   const double       aCumFreq,
+                                   const rectangle_t& aQueryRectangle, 
+                                   const rectangle_t& aBoundingRectangle);
+        static double estimateLT24(const uint64_t     aCode,
+                                   const double       aCumFreq,
+                                   const rectangle_t& aQueryRectangle, 
+                                   const rectangle_t& aBoundingRectangle);
       public:
         // for 2/3-LT: matrix must be 4x4 matrix
         static uint64_t encode23LT(const Matrix& M, const uint aStartRowId, const uint aStartColId);
@@ -159,10 +160,9 @@ class IQTS : public EstimatorBase2dim {
                                   Matrix& M, const uint aStartRowId, const uint aStartColId,
                                   const uint aNoBits01, const uint aNoBits02,
                                   const uint aNoBits11, const uint aNoBits12);
-      public:
-        std::ostream& print(std::ostream& os) const;
       private:
-        Data2dim    _data;    // data points
+        uint        _begin;   // data points [_begin, _end) of the points of the IQTS under construction
+        uint        _end;
         rectangle_t _br;      // bounding rectangle
         double      _cumFreq; // number of points contained in _br
         double      _sse;     // sse 
@@ -179,6 +179,14 @@ class IQTS : public EstimatorBase2dim {
         bool operator()(const Node* x, const Node* y) const { return (x->sse() < y->sse()); }
     };
 
+    struct flatnode_t {
+      double   _cumFreq;
+      uint64_t _code;
+      uint32_t _child;         // index of the first child in _nodes
+      uint16_t _childMask;     // bit 2i+j set iff child (i,j) exists
+      bool     _hasRefinement;
+    };
+
     typedef PairingHeap<Node*, CMPNode> heap_t;
   private:
     IQTS(const IQTS&);
@@ -201,7 +209,6 @@ class IQTS : public EstimatorBase2dim {
     inline uint               noOutlier() const { return _outlier.size(); }
     inline uint               budget()  const { return _budget; } // in number of bits
     inline uint               phi() const { return _phi; }
-    inline const Node*        root() const { return _root; }
     inline bool               trace() const { return _trace; }
     inline void               trace(const bool x) { _trace = x; }
     inline uint               getNodeId() const { return (_nodeCount++); }
@@ -209,6 +216,7 @@ class IQTS : public EstimatorBase2dim {
     virtual double estimate(const rectangle_t& r) const;
     virtual double estimate(const query_t& lQuery) const;
   public:
+    double estimateTree(const rectangle_t& aQuery) const;
     uint   outlierCount(const rectangle_t& r) const;
     uint   size() const; // in number of bytes
     uint   depth() const;
@@ -221,14 +229,58 @@ class IQTS : public EstimatorBase2dim {
   public:
     virtual std::ostream& print_name_param(std::ostream& os) const;
             std::ostream& print(std::ostream& os) const;
+  private:
+    // a node in estimateTree whose children remain to be visited.
+    // plain data, such that the stack needs no initialization.
+    struct pending_t {
+      double   _min[2];   // lower left corner of its bounding rectangle
+      double   _width[2]; // tile width/height of its 2x2 partitioning
+      double   _query[4]; // query rectangle clipped to it
+      uint32_t _node;
+      inline void init(const uint32_t aNode, const rectangle_t& aBr, const rectangle_t& aQuery) {
+                    _min[0]   = aBr.xlo();
+                    _min[1]   = aBr.ylo();
+                    _width[0] = (aBr.xhi() - aBr.xlo()) / ((double) 2); // as partitiondesc_t
+                    _width[1] = (aBr.yhi() - aBr.ylo()) / ((double) 2);
+                    _query[0] = aQuery.xlo();
+                    _query[1] = aQuery.ylo();
+                    _query[2] = aQuery.xhi();
+                    _query[3] = aQuery.yhi();
+                    _node = aNode;
+                  }
+      // tile (i,j), as partitiondescxy_t::getRectangle
+      inline void tile(const uint i, const uint j, rectangle_t& aTile) const {
+                    aTile._pll.x = _min[0] + ((double) i * _width[0]);
+                    aTile._pur.x = _min[0] + ((double) (i + 1) * _width[0]);
+                    aTile._pll.y = _min[1] + ((double) j * _width[1]);
+                    aTile._pur.y = _min[1] + ((double) (j + 1) * _width[1]);
+                  }
+      inline void query(rectangle_t& aQuery) const {
+                    aQuery._pll.x = _query[0];
+                    aQuery._pll.y = _query[1];
+                    aQuery._pur.x = _query[2];
+                    aQuery._pur.y = _query[3];
+                  }
+    };
+    static constexpr uint k_max_local_stack = 256; // pending nodes
+  private:
+    void freeze();
+    bool estimateNode(const uint aNode, const rectangle_t& aQuery, const rectangle_t& aBr,
+                      rectangle_t& aIsecOut, double& aEstimateOut) const;
+    uint noNodesWith(const bool aRefined, const Node::kind_LT_t aKindLT) const;
+    std::ostream& printNode(std::ostream& os, const uint aNode, const rectangle_t& aBr, const uint aLevel) const;
   private:
     Data2dim     _outlier;
+    OutlierIndex _outlierIndex;
     rectangle_t  _br; // bounding rectangle
     kind_t       _kind;
     uint         _budget; // in number of bits 
     uint         _size;   // in number of bits
     const uint   _phi;
-    Node*        _root;
+    Node*        _root;   // only during construction
+    std::vector<flatnode_t> _nodes;
+    uint         _depth;
+    uint         _height; // number of levels of _nodes
     mutable uint _nodeCount;
     bool         _trace;
 };
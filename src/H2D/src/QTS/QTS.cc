@@ -1,5 +1,8 @@
 #include "QTS.hh"
 
+#include <string.h>
+
+#include "infra/binfile.hh"
 
 
 namespace H2D {
@@ -10,14 +13,17 @@ namespace H2D {
  */
 
 
-QTS::Node::Node(const Data2dim&     aData,
+QTS::Node::Node(const Data2dim&     aPoints,
+                const uint          aBegin,
+                const uint          aEnd,
                 const rectangle_t&  aBr,
                 const uint          aLevel,
                 const QTS&          aQTS,
                 const bool          a11) // for this one, no cum freq stored
-            : _data(aData),
+            : _begin(aBegin),
+              _end(aEnd),
               _br(aBr),
-              _cumFreq(aData.total()),
+              _cumFreq(aPoints.total(aBegin, aEnd)),
               _sse(0),
               _child(),
               _level(aLevel),
@@ -29,13 +35,13 @@ QTS::Node::Node(const Data2dim&     aData,
     }
   }
   if(k_sse == aQTS.kind()) {
-    _sse = aData.sse(0, aData.size()); // in paper: sse! 
+    _sse = aPoints.sse(aBegin, aEnd); // in paper: sse! 
   } else
   if(k_var == aQTS.kind()) {
-    _sse = aData.variance(0, aData.size()); 
+    _sse = aPoints.variance(aBegin, aEnd); 
   } else
   if(k_card == aQTS.kind()) {
-    _sse = aData.total();
+    _sse = cumFreq();
   } else {
     assert(0 > 1);
   }
@@ -53,102 +59,35 @@ QTS::Node::~Node() {
 
 
 void
-QTS::Node::performSplit(const QTS& aQTS) {
+QTS::Node::performSplit(Data2dim& aPoints, const QTS& aQTS) {
   if(aQTS.trace()) {
     std::cout << "split Node" << nodeId() << '@' << level() << ": "
               << "   w = " << sse()
               << std::endl;
   }
 
-  data2dim_at        lPartition(2,2);
+  // child (i,j) gets [lTileBegin[2i+j], lTileBegin[2i+j+1])
+  uint               lTileBegin[2*2 + 1];
   partitiondescxy_t  lPdXY(br(), 2, 2);
-  for(uint i = 0; i < data().size(); ++i) {
-    const xyc_t& e = data()[i];
-    const uint lIdxX = lPdXY.idxXcorrected(e.x);
-    const uint lIdxY = lPdXY.idxYcorrected(e.y);
-    if(lIdxX < 2 && lIdxY < 2) {
-      lPartition(lIdxX, lIdxY).push_back(e);
-    }
-  }
-
+  aPoints.partitionTiles(lPdXY, begin(), end(), lTileBegin);
 
   rectangle_t lChildBr;
   for(uint i = 0; i < 2; ++i) {
     for(uint j = 0; j < 2; ++j) {
-      if(0 < lPartition(i,j).size()) {
+      const uint lBegin = lTileBegin[2*i + j];
+      const uint lEnd   = lTileBegin[2*i + j + 1];
+      if(lBegin < lEnd) {
         lPdXY.getRectangle(i, j, lChildBr);
-        _child[i][j]  = new Node(lPartition(i,j), lChildBr, level() + 1, aQTS, 2 == (i+j));
+        _child[i][j]  = new Node(aPoints, lBegin, lEnd, lChildBr, level() + 1, aQTS, 2 == (i+j));
       }
       if(aQTS.trace()) {
-        std::cout << "   size(" << i << ',' << j << ") = " << lPartition(i,j).size() << std::endl;
+        std::cout << "   size(" << i << ',' << j << ") = " << (lEnd - lBegin) << std::endl;
       }
     }
   }
 }
 
 
-double
-QTS::Node::estimate(const rectangle_t& aQueryRectangle, const rectangle_t& aBr, const QTS& aQTS) const {
-  if(aQTS.trace()) {
-    std::cout << std::string(2*level(), ' ')
-              << "Node::estimate: " << aQueryRectangle << "  " << aBr << std::endl;
-  }
-
-  if(aQueryRectangle.contains(aBr)) {
-    if(aQTS.trace()) {
-      std::cout << std::string(2*level(), ' ')
-                << "note: fully contained." << std::endl;
-    }
-    return cumFreq();
-  }
-
-  rectangle_t lIsec;
-  lIsec.isec(aQueryRectangle, aBr);
-  if(lIsec.hasZeroArea()) {
-    if(aQTS.trace()) {
-      std::cout << std::string(2*level(), ' ')
-                << "note empty intersection." << std::endl;
-    }
-    return 0;
-  }
-
-  if(aQueryRectangle.contains(aBr)) {
-    if(aQTS.trace()) {
-      std::cout << std::string(2*level(), ' ')
-                << "note: fully contained." << std::endl;
-    }
-    return cumFreq();
-  }
-
-  if(isLeaf()) {
-    const double lEstimate =  ((lIsec.area() / aBr.area()) * cumFreq());
-    if(aQTS.trace()) {
-      std::cout << std::string(2*level(), ' ')
-                << "note: leaf with cumfreq: " << cumFreq() 
-                << " results in estimate " << lEstimate
-                << std::endl;
-    }
-    return lEstimate;
-  }
-
-  double lEstimate = 0;
-
-  partitiondescxy_t lPd(aBr, 2, 2);
-  rectangle_t       lTile;
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lPd.getRectangle(i, j, lTile);
-//	std::cout<<"child: "<<i<<std::endl;
-        lEstimate += child(i, j)->estimate(lIsec, lTile, aQTS);
-      }
-    }
-  }
-
-  return lEstimate;
-}
-
-
 uint
 QTS::Node::depth() const {
   uint lChildDepth = 0;
@@ -165,36 +104,6 @@ QTS::Node::depth() const {
   return 1 + lChildDepth;
 }
 
-uint
-QTS::Node::noNodes() const {
-  uint lRes = 1; // this
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        lRes += child(i, j)->noNodes();
-      }
-    }
-  } 
-  return lRes;
-}
-
-
-
-std::ostream&
-QTS::Node::print(std::ostream& os) const {
-  std::cout << std::string(2 * level(), ' ') 
-            << "node br " << br() << " cf " << cumFreq() << std::endl;
-  for(uint i = 0; i < 2; ++i) {
-    for(uint j = 0; j < 2; ++j) {
-      if(0 != child(i, j)) {
-        child(i, j)->print(os);
-      }
-    }
-  }
-  return os;
-}
-
-
 /* 
  *   QTS members 
  */
@@ -207,12 +116,19 @@ QTS::QTS(const Data2dim& aData,
          const double    aTheta,
          const bool      aTrace) : EstimatorBase2dim(aQ, aTheta),
                                    _outlier(),
+                                   _outlierIndex(),
                                    _br(),
                                    _kind(aKind),
                                    _budget(aBudget * 8),
                                    _size(0),
                                    _phi(aPhi),
                                    _root(0),
+                                   _nodes(),
+                                   _node(0),
+                                   _noNodes(0),
+                                   _synfile(0),
+                                   _depth(0),
+                                   _height(0),
                                    _nodeCount(0),
                                    _trace(aTrace) {
   init(aData);
@@ -233,30 +149,58 @@ QTS::QTS(const Data2dim& aData,
 
 }
 
+QTS::QTS(const kind_t aKind,
+         const uint   aBudget,
+         const uint   aPhi,
+         const double aQ,
+         const double aTheta,
+         const bool   aTrace) : EstimatorBase2dim(aQ, aTheta),
+                                _outlier(),
+                                _outlierIndex(),
+                                _br(),
+                                _kind(aKind),
+                                _budget(aBudget * 8),
+                                _size(0),
+                                _phi(aPhi),
+                                _root(0),
+                                _nodes(),
+                                _node(0),
+                                _noNodes(0),
+                                _synfile(0),
+                                _depth(0),
+                                _height(0),
+                                _nodeCount(0),
+                                _trace(aTrace) {
+}
+
 QTS::~QTS() {
   if(0 != _root) {
     delete _root;
   }
+  delete _synfile;
 }
 
 
 
 void
 QTS::init(const Data2dim& aData) {
-  Data2dim lRegular;
   if(8 < phi()) {
+    Data2dim lRegular;
     aData.split(lRegular, _outlier, phi());
+    _outlierIndex.init(_outlier);
+    lRegular.getBoundingRectangle(_br);
   } else {
-    lRegular = aData;
+    aData.getBoundingRectangle(_br);
   }
 
-  lRegular.getBoundingRectangle(_br);
+  // the only copy of the data points, permuted by performSplit
+  Data2dim lPoints(aData);
 
   heap_t lHeap;
-  _root = new Node(aData, br(), 0, (*this), false);
+  _root = new Node(lPoints, 0, lPoints.size(), br(), 0, (*this), false);
   lHeap.push(_root);
 
-  uint lTotalSize = root()->sizeInBits();
+  uint lTotalSize = _root->sizeInBits();
 
   if(trace()) {
     std::cout << "before main loop: " << budget() << " <?= " << lTotalSize << std::endl;
@@ -264,8 +208,8 @@ QTS::init(const Data2dim& aData) {
   while(budget() > lTotalSize) {
     Node* lTop = lHeap.top();
     lHeap.pop();
-    if(7 > lTop->data().size()) { continue; }
-    lTop->performSplit(*this);
+    if(7 > lTop->size()) { continue; }
+    lTop->performSplit(lPoints, *this);
     for(uint i = 0; i < 2; ++i) {
       for(uint j = 0; j < 2; ++j) {
         Node* lChild = lTop->child(i,j);
@@ -282,6 +226,50 @@ QTS::init(const Data2dim& aData) {
 
   _size = lTotalSize;
 
+  freeze();
+}
+
+void
+QTS::freeze() {
+  _nodes.clear();
+  _node    = 0;
+  _noNodes = 0;
+  _depth  = 0;
+  _height = 0;
+  if(0 == _root) {
+    return;
+  }
+  _depth = _root->depth();
+
+  // breadth first, the children of lOrder[k] are appended when k is visited
+  std::vector<const Node*> lOrder(1, _root);
+  std::vector<uint>        lLevel(1, 1);
+  for(uint k = 0; k < lOrder.size(); ++k) {
+    const Node* lNode = lOrder[k];
+    flatnode_t lFlat;
+    lFlat._cumFreq   = lNode->cumFreq();
+    lFlat._child     = lOrder.size();
+    lFlat._childMask = 0;
+    for(uint i = 0; i < 2; ++i) {
+      for(uint j = 0; j < 2; ++j) {
+        if(0 != lNode->child(i, j)) {
+          lFlat._childMask |= (1 << (2 * i + j));
+          lOrder.push_back(lNode->child(i, j));
+          lLevel.push_back(lLevel[k] + 1);
+        }
+      }
+    }
+    if(0 == lFlat._childMask) {
+      lFlat._child = 0;
+    }
+    _nodes.push_back(lFlat);
+  }
+  _height  = lLevel.back();
+  _node    = _nodes.data();
+  _noNodes = _nodes.size();
+
+  delete _root;
+  _root = 0;
 }
 
 
@@ -296,28 +284,89 @@ QTS::estimate(const query_t& lQuery) const {
 double
 QTS::estimate(const rectangle_t& r) const {
   double lEstimate = 0;
-  if(0 != root()) {
-    lEstimate = root()->estimate(r, br(), (*this));
+  if(0 < _noNodes) {
+    lEstimate = estimateTree(r);
   }
   lEstimate += (double) outlierCount(r);
   return std::max<double>(1.0, lEstimate);
 }
 
+// estimate of node aNode with bounding rectangle aBr for aQuery.
+// returns true if the node must be refined by its children for the
+// query aIsecOut (aQuery clipped to aBr), false if aEstimateOut is final.
+bool
+QTS::estimateNode(const uint aNode, const rectangle_t& aQuery, const rectangle_t& aBr,
+                  rectangle_t& aIsecOut, double& aEstimateOut) const {
+  const flatnode_t& lNode = _node[aNode];
+  if(aQuery.contains(aBr)) {
+    aEstimateOut = lNode._cumFreq;
+    return false;
+  }
+  aIsecOut.isec(aQuery, aBr);
+  if(aIsecOut.hasZeroArea()) {
+    aEstimateOut = 0;
+    return false;
+  }
+  if(0 == lNode._childMask) {
+    aEstimateOut = ((aIsecOut.area() / aBr.area()) * lNode._cumFreq);
+    return false;
+  }
+  return true;
+}
+
+// depth first over _nodes with an explicit stack of the nodes to be
+// refined. a popped node settles its children or pushes them in turn,
+// at most three more nodes per level are pending.
+double
+QTS::estimateTree(const rectangle_t& aQuery) const {
+  double      lEstimate = 0;
+  rectangle_t lIsec;
+  if(!estimateNode(0, aQuery, br(), lIsec, lEstimate)) {
+    return lEstimate;
+  }
 
+  pending_t              lLocal[k_max_local_stack];
+  std::vector<pending_t> lNonLocal;
+  pending_t*             lStack = lLocal;
+  if(k_max_local_stack < 3 * _height + 1) {
+    lNonLocal.resize(3 * _height + 1);
+    lStack = lNonLocal.data();
+  }
 
-uint
-QTS::outlierCount(const rectangle_t& r) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
+  double lRes = 0;
+  uint   lTop = 0;
+  lStack[lTop++].init(0, br(), lIsec);
+  rectangle_t lTile;
+  rectangle_t lQuery;
+  while(0 < lTop) {
+    const pending_t   lPending = lStack[--lTop];
+    const flatnode_t& lNode    = _node[lPending._node];
+    lPending.query(lQuery);
+    uint lChild = lNode._child;
+    for(uint k = 0; k < 4; ++k) {
+      if(0 == (lNode._childMask & (1 << k))) {
+        continue;
+      }
+      lPending.tile(k >> 1, k & 1, lTile);
+      if(estimateNode(lChild, lQuery, lTile, lIsec, lEstimate)) {
+        lStack[lTop++].init(lChild, lTile, lIsec);
+      } else {
+        lRes += lEstimate;
+      }
+      ++lChild;
     }
   }
   return lRes;
 }
 
 
+
+uint
+QTS::outlierCount(const rectangle_t& r) const {
+  return _outlierIndex.countWithin(r);
+}
+
+
 uint
 QTS::size() const {
   return (_size / 8);
@@ -325,25 +374,123 @@ QTS::size() const {
 
 uint
 QTS::depth() const {
-  if(0 == root()) {
-    return 0;
-  }
-  return root()->depth();
+  return _depth;
 }
 
 uint
 QTS::noNodes() const {
-  if(0 == root()) {
+  return _noNodes;
+}
+
+/*
+ *   synopsis files
+ *   sections: 0 synopsis_info_t, 1 flat nodes, 2..4 outliers
+ */
+
+bool
+QTS::save(const std::string& aFilename) const {
+  synopsis_info_t lInfo;
+  memset(&lInfo, 0, sizeof(lInfo));
+  lInfo._br[0]     = br().xlo();
+  lInfo._br[1]     = br().ylo();
+  lInfo._br[2]     = br().xhi();
+  lInfo._br[3]     = br().yhi();
+  lInfo._q         = q();
+  lInfo._theta     = theta();
+  lInfo._kind      = kind();
+  lInfo._budget    = budget();
+  lInfo._phi       = phi();
+  lInfo._size      = _size;
+  lInfo._depth     = _depth;
+  lInfo._height    = _height;
+  lInfo._noNodes   = _noNodes;
+  lInfo._noOutlier = noOutlier();
+  SynopsisWriter lWriter(H2D_QTS);
+  lWriter.add(&lInfo, 1);
+  lWriter.add(_node, _noNodes);
+  lWriter.add(outlier());
+  return lWriter.write(aFilename);
+}
+
+QTS*
+QTS::load(const std::string& aFilename,
+          const kind_t       aKind,
+          const uint         aBudget,
+          const uint         aPhi,
+          const double       aQ,
+          const double       aTheta,
+          const bool         aTrace) {
+  QTS* lRes = new QTS(aKind, aBudget, aPhi, aQ, aTheta, aTrace);
+  lRes->_synfile = new SynopsisFile();
+  const SynopsisFile& lFile = *(lRes->_synfile);
+  size_t n = 0;
+  const synopsis_info_t* lInfo = 0;
+  bool lOk = lRes->_synfile->open(aFilename, H2D_QTS) && (5 == lFile.noSection());
+  if(lOk) {
+    lInfo = lFile.array<synopsis_info_t>(0, n);
+    lOk = (0 != lInfo) && (1 == n) &&
+          ((uint32_t) aKind == lInfo->_kind) && (lRes->budget() == lInfo->_budget) &&
+          (aPhi == lInfo->_phi) && (aQ == lInfo->_q) && (aTheta == lInfo->_theta);
+  }
+  if(lOk) {
+    lRes->_node    = lFile.array<flatnode_t>(1, n);
+    lRes->_noNodes = n;
+    lOk = (lInfo->_noNodes == n) && (0 < n);
+    // children lie behind their parent, estimateTree terminates and
+    // its stack is bounded by the height
+    std::vector<uint> lLevel(n, 1);
+    for(uint k = 0; lOk && k < n; ++k) {
+      const flatnode_t& lNode = lRes->_node[k];
+      if(0 == lNode._childMask) {
+        continue;
+      }
+      const uint lNoChildren = __builtin_popcount(lNode._childMask);
+      lOk = (16 > lNode._childMask) && (k < lNode._child) && (lNode._child + lNoChildren <= n);
+      for(uint c = 0; lOk && c < lNoChildren; ++c) {
+        lLevel[lNode._child + c] = lLevel[k] + 1;
+      }
+    }
+    lOk = lOk && (lInfo->_height == lLevel.back());
+  }
+  lOk = lOk && lFile.get(2, lRes->_outlier) && (lInfo->_noOutlier == lRes->_outlier.size());
+  if(!lOk) {
+    delete lRes;
     return 0;
   }
-  return root()->noNodes();
+  lRes->_br      = rectangle_t(lInfo->_br[0], lInfo->_br[1], lInfo->_br[2], lInfo->_br[3]);
+  lRes->_size    = lInfo->_size;
+  lRes->_depth   = lInfo->_depth;
+  lRes->_height  = lInfo->_height;
+  if(0 < lRes->noOutlier()) {
+    lRes->_outlierIndex.init(lRes->_outlier);
+  }
+  return lRes;
+}
+
+std::ostream&
+QTS::printNode(std::ostream& os, const uint aNode, const rectangle_t& aBr, const uint aLevel) const {
+  const flatnode_t& lNode = _node[aNode];
+  std::cout << std::string(2 * aLevel, ' ') 
+            << "node br " << aBr << " cf " << lNode._cumFreq << std::endl;
+  partitiondescxy_t lPd(aBr, 2, 2);
+  rectangle_t       lTile;
+  uint lChild = lNode._child;
+  for(uint k = 0; k < 4; ++k) {
+    if(0 != (lNode._childMask & (1 << k))) {
+      lPd.getRectangle(k >> 1, k & 1, lTile);
+      printNode(os, lChild++, lTile, aLevel + 1);
+    }
+  }
+  return os;
 }
 
 std::ostream&
 QTS::print(std::ostream& os) const {
   std::cout << "QTS: " << std::endl;
   std::cout << "  tree:" << std::endl;
-  _root->print(os);
+  if(0 < _noNodes) {
+    printNode(os, 0, br(), 0);
+  }
   return os;
 }
 
@@ -11,6 +11,7 @@
 #include "infra/types.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/RegularPartitioning2dim.hh"
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/summaryline.hh"
@@ -19,10 +20,21 @@
 /*
  * QTS/IQTS
  * Buccafurri, Furfaro, Sacca, Sirangelo 2003
+ * the tree is built from Nodes over one copy of the data points, a Node
+ * references the range [begin, end) of it. performSplit permutes the range
+ * of a node in place such that those of its children follow in Morton order.
+ * freeze then lays it out in _nodes in breadth first order, the
+ * children of a node stored consecutively in Morton order (0,0), (0,1),
+ * (1,0), (1,1), only those existing. the bounding rectangle of a child
+ * is the tile (i,j) of the 2x2 partitioning of the bounding rectangle of
+ * its parent, hence not stored. the Nodes are deleted afterwards.
+ * save writes the flat nodes and the outliers to a synopsis file
+ * (infra/binfile.hh), load estimates directly on its mapped node array.
  */
 
 namespace H2D {
 
+class SynopsisFile;
 
 class QTS : public EstimatorBase2dim {
   public:
@@ -37,16 +49,19 @@ class QTS : public EstimatorBase2dim {
         friend class QTS;
         Node(const Node&);
         Node& operator=(const Node&);
-        typedef array_tt<Data2dim> data2dim_at;
       public:
-        Node(const Data2dim&    aData, 
+        Node(const Data2dim&    aPoints,
+             const uint         aBegin,
+             const uint         aEnd,
              const rectangle_t& aBr,
              const uint         aLevel,
              const QTS&         aQTS,
              const bool         a11);
         ~Node();
       public:
-        inline const Data2dim&    data() const { return _data; }
+        inline       uint         begin() const { return _begin; }
+        inline       uint         end() const { return _end; }
+        inline       uint         size() const { return (_end - _begin); }
         inline const rectangle_t& br() const { return _br; }
         inline       double       cumFreq() const { return _cumFreq; }
         inline       double       sse() const { return _sse; }
@@ -61,17 +76,11 @@ class QTS : public EstimatorBase2dim {
                                                            0 == _child[1][1]); }
       public:
         uint depth() const;
-        uint noNodes() const;
       public:
-        void performSplit(const QTS& aQTS);
-      public:
-        double estimate(const rectangle_t& aQueryRectangle, 
-                        const rectangle_t& aBoundingRectangle,
-                        const QTS&         aQTS) const;
-      public:
-        std::ostream& print(std::ostream& os) const;
+        void performSplit(Data2dim& aPoints, const QTS& aQTS);
       private:
-        Data2dim    _data;    // data points
+        uint        _begin;   // data points [_begin, _end) of the points of the QTS under construction
+        uint        _end;
         rectangle_t _br;      // bounding rectangle
         double      _cumFreq; // number of points contained in _br
         double      _sse;     // sse 
@@ -86,6 +95,28 @@ class QTS : public EstimatorBase2dim {
         bool operator()(const Node* x, const Node* y) const { return (x->sse() < y->sse()); }
     };
 
+    struct flatnode_t {
+      double   _cumFreq;
+      uint32_t _child;     // index of the first child in _nodes
+      uint32_t _childMask; // bit 2i+j set iff child (i,j) exists
+    };
+
+    // section 0 of a synopsis file of a QTS, followed by the flat
+    // nodes and the outliers (x, y, c). no padding.
+    struct synopsis_info_t {
+      double   _br[4]; // xlo, ylo, xhi, yhi
+      double   _q;
+      double   _theta;
+      uint32_t _kind;
+      uint32_t _budget; // in number of bits
+      uint32_t _phi;
+      uint32_t _size;   // in number of bits
+      uint32_t _depth;
+      uint32_t _height;
+      uint32_t _noNodes;
+      uint32_t _noOutlier;
+    };
+
     typedef PairingHeap<Node*, CMPNode> heap_t;
   private:
     QTS(const QTS&);
@@ -99,8 +130,24 @@ class QTS : public EstimatorBase2dim {
         const double    aTheta,
         const bool      aTrace);
     virtual ~QTS();
+  private:
+    // empty QTS, filled by load
+    QTS(const kind_t aKind, const uint aBudget, const uint aPhi,
+        const double aQ, const double aTheta, const bool aTrace);
   public:
     void init(const Data2dim& aData);
+  public:
+    // creates missing directories
+    bool save(const std::string& aFilename) const;
+    // maps a file written by save if it was built with the given
+    // parameters, returns 0 otherwise
+    static QTS* load(const std::string& aFilename,
+                     const kind_t       aKind,
+                     const uint         aBudget, // in number of bytes
+                     const uint         aPhi,
+                     const double       aQ,
+                     const double       aTheta,
+                     const bool         aTrace);
   public:
     inline const rectangle_t& br() const { return _br; }
     inline kind_t             kind() const { return _kind; }
@@ -108,7 +155,6 @@ class QTS : public EstimatorBase2dim {
     inline uint               noOutlier() const { return _outlier.size(); }
     inline uint               budget()  const { return _budget; } // in number of bits
     inline uint               phi() const { return _phi; }
-    inline const Node*        root() const { return _root; }
     inline bool               trace() const { return _trace; }
     inline void               trace(const bool x) { _trace = x; }
     inline uint               getNodeId() const { return (_nodeCount++); }
@@ -116,6 +162,7 @@ class QTS : public EstimatorBase2dim {
     virtual double estimate(const rectangle_t& r) const;
     virtual double estimate(const query_t& lQuery) const;
   public:
+    double estimateTree(const rectangle_t& aQuery) const;
     uint   outlierCount(const rectangle_t& r) const;
     uint   depth() const;
     uint   noNodes() const;
@@ -124,14 +171,60 @@ class QTS : public EstimatorBase2dim {
   public:
     virtual std::ostream& print_name_param(std::ostream& os) const;
             std::ostream& print(std::ostream& os) const;
+  private:
+    // a node in estimateTree whose children remain to be visited.
+    // plain data, such that the stack needs no initialization.
+    struct pending_t {
+      double   _min[2];   // lower left corner of its bounding rectangle
+      double   _width[2]; // tile width/height of its 2x2 partitioning
+      double   _query[4]; // query rectangle clipped to it
+      uint32_t _node;
+      inline void init(const uint32_t aNode, const rectangle_t& aBr, const rectangle_t& aQuery) {
+                    _min[0]   = aBr.xlo();
+                    _min[1]   = aBr.ylo();
+                    _width[0] = (aBr.xhi() - aBr.xlo()) / ((double) 2); // as partitiondesc_t
+                    _width[1] = (aBr.yhi() - aBr.ylo()) / ((double) 2);
+                    _query[0] = aQuery.xlo();
+                    _query[1] = aQuery.ylo();
+                    _query[2] = aQuery.xhi();
+                    _query[3] = aQuery.yhi();
+                    _node = aNode;
+                  }
+      // tile (i,j), as partitiondescxy_t::getRectangle
+      inline void tile(const uint i, const uint j, rectangle_t& aTile) const {
+                    aTile._pll.x = _min[0] + ((double) i * _width[0]);
+                    aTile._pur.x = _min[0] + ((double) (i + 1) * _width[0]);
+                    aTile._pll.y = _min[1] + ((double) j * _width[1]);
+                    aTile._pur.y = _min[1] + ((double) (j + 1) * _width[1]);
+                  }
+      inline void query(rectangle_t& aQuery) const {
+                    aQuery._pll.x = _query[0];
+                    aQuery._pll.y = _query[1];
+                    aQuery._pur.x = _query[2];
+                    aQuery._pur.y = _query[3];
+                  }
+    };
+    static constexpr uint k_max_local_stack = 256; // pending nodes
+  private:
+    void freeze();
+    bool estimateNode(const uint aNode, const rectangle_t& aQuery, const rectangle_t& aBr,
+                      rectangle_t& aIsecOut, double& aEstimateOut) const;
+    std::ostream& printNode(std::ostream& os, const uint aNode, const rectangle_t& aBr, const uint aLevel) const;
   private:
     Data2dim     _outlier;
+    OutlierIndex _outlierIndex;
     rectangle_t  _br; // bounding rectangle
     kind_t       _kind;
     uint         _budget; // in number of bits 
     uint         _size;   // in number of bits
     const uint   _phi;
-    Node*        _root;
+    Node*        _root;   // only during construction
+    std::vector<flatnode_t> _nodes; // built by freeze, empty if loaded
+    const flatnode_t* _node;        // _nodes or the mapped array
+    uint         _noNodes;
+    SynopsisFile* _synfile;         // owned, if loaded
+    uint         _depth;
+    uint         _height; // number of levels of _nodes
     mutable uint _nodeCount;
     bool         _trace;
 };
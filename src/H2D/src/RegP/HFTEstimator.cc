@@ -12,6 +12,7 @@ HFTEstimator::HFTEstimator(const int       aLogHi,
                            const bool      aTrace) : EstimatorBase2dim(aQ, aTheta),
                                                      _br(),
                                                      _outlier(),
+                                                     _outlierIndex(),
                                                      _logHi(aLogHi),
                                                      _logLo(aLogLo),
                                                      _kappa(aKappa),
@@ -31,6 +32,7 @@ HFTEstimator::HFTEstimator(const Data2dim& aData,
                            const bool      aTrace) : EstimatorBase2dim(aQ, aTheta),
                                                      _br(),
                                                      _outlier(),
+                                                     _outlierIndex(),
                                                      _logHi(aLogHi),
                                                      _logLo(aLogLo),
                                                      _kappa(aKappa),
@@ -65,6 +67,7 @@ HFTEstimator::init(const Data2dim& aData) {
 
   if(10 < phi()) {
     aData.split(lRegular, _outlier, phi());
+    _outlierIndex.init(_outlier);
   } else {
     lRegular = aData;
   }
@@ -206,14 +209,7 @@ HFTEstimator::estimate(const query_t& lQuery) const {
 
 uint
 HFTEstimator::outlierCount(const rectangle_t& aQueryRectangle) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(aQueryRectangle.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithin(aQueryRectangle);
 }
 
 uint
@@ -5,6 +5,7 @@
 #include <iomanip>
 #include <vector>
 #include "infra/types.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/cb.hh"
 
 #include "infra/RegularPartitioning2dim.hh"
@@ -61,6 +62,7 @@ class HFTEstimator : public EstimatorBase2dim {
   public:
     rectangle_t _br;
     Data2dim    _outlier;
+    OutlierIndex _outlierIndex;
     int         _logHi;
     int         _logLo;
     uint        _kappa;
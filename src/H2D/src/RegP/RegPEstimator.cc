@@ -9,10 +9,11 @@ RegPEstimator::RegPEstimator(const Data2dim& aData,
                              const uint      aPhi,
                              const double    aQ,
                              const double    aTheta)
-              : EstimatorBase2dim(aQ,aTheta), _regp(), _outlier(), _nx(aNx), _ny(aNy), _epsilon(aEpsilon), _phi(aPhi) {
+              : EstimatorBase2dim(aQ,aTheta), _regp(), _outlier(), _outlierIndex(), _nx(aNx), _ny(aNy), _epsilon(aEpsilon), _phi(aPhi) {
   if(0 < aPhi) {
     Data2dim lRegular;
     aData.split(lRegular, _outlier, aPhi);
+    _outlierIndex.init(_outlier);
     _regp.initFromData2dim(aNx, aNy, lRegular);
   } else {
     _regp.initFromData2dim(aNx, aNy, aData);
@@ -45,17 +46,26 @@ RegPEstimator::estimate(const query_t& lQuery) const {
   return estimate(r);
 }
 
+void
+RegPEstimator::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  if(0.0 < epsilon()) {
+    EstimatorBase2dim::estimate_batch(aBegin, aN, aEstOut);
+    return;
+  }
+  regp().estimate_batch(aBegin, aN, aEstOut);
+  std::vector<uint> lOutlierCount(aN);
+  for(size_t i = 0; i < aN; ++i) {
+    lOutlierCount[i] = outlierCount(aBegin[i].rectangle());
+  }
+  for(size_t i = 0; i < aN; ++i) {
+    aEstOut[i] += (double) lOutlierCount[i];
+    aEstOut[i] = std::max<double>(minEstimate(), aEstOut[i]);
+  }
+}
 
 uint
 RegPEstimator::outlierCount(const rectangle_t& r) const {
-  uint lRes = 0;
-  for(uint i = 0; i < outlier().size(); ++i) {
-    const xyc_t& p = outlier()[i];
-    if(r.containsHalfOpen(p.x, p.y)) {
-      lRes += p.c;
-    }
-  }
-  return lRes;
+  return _outlierIndex.countWithin(r);
 }
 
 uint
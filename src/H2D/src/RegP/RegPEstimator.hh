@@ -4,6 +4,7 @@
 #include "infra/types.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/OutlierIndex.hh"
 #include "infra/RegularPartitioning2dim.hh"
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/summaryline.hh"
@@ -35,6 +36,7 @@ class RegPEstimator : public EstimatorBase2dim {
   public:
     virtual double estimate(const query_t& lQuery) const;
     virtual double estimate(const rectangle_t& r) const;
+    virtual void   estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
   public:
     uint size() const;
   public:
@@ -46,6 +48,7 @@ class RegPEstimator : public EstimatorBase2dim {
   private:
     RegularPartitioning2dim _regp;
     Data2dim                _outlier;
+    OutlierIndex            _outlierIndex;
     const uint              _nx;
     const uint              _ny;
     const double            _epsilon; // ignore
@@ -10,49 +10,52 @@ Sample2dim::Sample2dim(const Data2dim& aData,
                        const bool      aTrace) 
            : EstimatorBase2dim(aQ, aTheta), 
             _data(), 
+            _grid(),
             _dataSize(aData.size()),
             _trace(aTrace) {
   // assert(aData.size() / 2 > aSampleSize);  // XXX
 
-  std::set<uint> lIdxSet;
-  std::mt19937 lRng;
-
-  // expand aData
-  Data2dim lData;
-  for(uint i = 0; i < aData.size(); ++i) {
-    const xyc_t& lXyc = aData[i];
-    for(uint j = 0; j < lXyc.c; ++j) {
-      lData.push_back(xyc_t(lXyc.x, lXyc.y, 1));
-    }
-  }
+  // the histogram is not expanded into unit tuples:
+  // tuple j (0 <= j < total) belongs to the point i with
+  // cum(i) <= j < cum(i) + aData[i].c, cum being the prefix sum of the counts.
+  // the sample positions arrive in increasing order, so a single sweep
+  // over aData maps them to points. memory is O(sample size).
+  const uint64_t lTotal = aData.total();
 
   if(trace()) {
     std::cout << "Sampling:" << std::endl
               << "   #DV  = " << aData.size() << std::endl
-              << "   CARD = " << aData.total() << std::endl
-              << "  lData.size() = " << lData.size() << std::endl
+              << "   CARD = " << lTotal << std::endl
               << std::endl;
   }
 
   if((aData.size() / 2) > aSampleSize) {
     // good case, sufficiently many data points
-    while(lIdxSet.size() < aSampleSize) {
-      lIdxSet.insert(lRng() % lData.size());
-    }
-
-    for(std::set<uint>::const_iterator lIter = lIdxSet.begin();
-        lIter != lIdxSet.end();
-        ++lIter) {
-      _data.push_back(lData[*lIter]);
-    }
+    std::mt19937 lRng;
+    uint     lPoint  = 0;
+    uint64_t lCumEnd = aData[0].c; // cum(lPoint + 1)
+    auto lEmit = [&] (const int64_t aTupleNo) {
+                   while((uint64_t) aTupleNo >= lCumEnd) {
+                     ++lPoint;
+                     lCumEnd += aData[lPoint].c;
+                   }
+                   const xyc_t& lXyc = aData[lPoint];
+                   _data.push_back(xyc_t(lXyc.x, lXyc.y, 1));
+                 };
+    _data.reserve(aSampleSize);
+    vitter_d_tt(lTotal, aSampleSize, lRng, lEmit);
   } else {
     // very little data points
-    for(uint i = 0; (i < lData.size()) && (_data.size() < aSampleSize); ++i) {
-      _data.push_back(lData[i]);
+    for(uint i = 0; (i < aData.size()) && (_data.size() < aSampleSize); ++i) {
+      const xyc_t& lXyc = aData[i];
+      for(uint j = 0; (j < lXyc.c) && (_data.size() < aSampleSize); ++j) {
+        _data.push_back(xyc_t(lXyc.x, lXyc.y, 1));
+      }
     }
   }
 
  // std::cout<<"*****"<<_data.size()<<std::endl;
+  _grid.init(_data);
   
 }
 
@@ -68,7 +71,7 @@ Sample2dim::size() const {
 double 
 Sample2dim::estimate(const query_t& lQuery) const {
   double lRes = 0;
-  lRes = _data.countWithin(lQuery.rectangle());
+  lRes = _grid.countWithin(lQuery.rectangle());
   lRes = round((double) lRes * ((double) dataSize() / (double) sampleSize()));
   return std::max<double>(minEstimate(), lRes);
 }
@@ -77,11 +80,21 @@ Sample2dim::estimate(const query_t& lQuery) const {
 double
 Sample2dim::estimate(const rectangle_t& r) const {
   double lRes = 0;
-  lRes = _data.countWithin(r);
+  lRes = _grid.countWithin(r);
   lRes = round((double) lRes * ((double) dataSize() / (double) sampleSize()));
   return std::max<double>(minEstimate(), lRes);
 }
 
+void
+Sample2dim::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  for(size_t i = 0; i < aN; ++i) {
+    double lRes = _grid.countWithin(aBegin[i].rectangle());
+    lRes = round((double) lRes * ((double) dataSize() / (double) sampleSize()));
+    aEstOut[i] = std::max<double>(minEstimate(), lRes);
+  }
+}
+
+
 
 std::ostream&
 Sample2dim::print_name_param(std::ostream& os) const {
@@ -4,13 +4,14 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
-#include <set>
 #include <random>
 #include <assert.h>
 
 #include "../infra/types.hh"
 #include "../infra/data2dim.hh"
+#include "../infra/vitter_d_tt.hh"
 #include "../infra/EstimatorBase2dim.hh"
+#include "SampleGrid2dim.hh"
 
 namespace H2D {
 
@@ -33,12 +34,14 @@ class Sample2dim : public EstimatorBase2dim {
   public:
     virtual double estimate(const rectangle_t& r) const;
     virtual  double estimate(const query_t& lQuery) const;
+    virtual  void   estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
   public:
     virtual std::ostream& print_name_param(std::ostream& os) const;
   private:
-    Data2dim _data;
-    double   _dataSize;
-    bool     _trace;
+    Data2dim       _data;
+    SampleGrid2dim _grid; // index on _data for countWithin
+    double         _dataSize;
+    bool           _trace;
 };
 
 
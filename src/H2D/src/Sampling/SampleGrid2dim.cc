@@ -0,0 +1,127 @@
+#include "SampleGrid2dim.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace H2D {
+
+SampleGrid2dim::SampleGrid2dim()
+               : _x(), _y(), _c(), _cellBegin(), _cum(),
+                 _noCells(0), _xlo(0), _ylo(0), _xinv(0), _yinv(0) {
+}
+
+SampleGrid2dim::SampleGrid2dim(const Data2dim& aData)
+               : _x(), _y(), _c(), _cellBegin(), _cum(),
+                 _noCells(0), _xlo(0), _ylo(0), _xinv(0), _yinv(0) {
+  init(aData);
+}
+
+void
+SampleGrid2dim::init(const Data2dim& aData) {
+  const uint n = aData.size();
+  _noCells = (uint) std::sqrt((double) n / (double) k_points_per_cell);
+  _noCells = std::max<uint>(1, std::min<uint>(k_max_grid, _noCells));
+  const uint lNoCells = _noCells * _noCells;
+
+  rectangle_t lBr;
+  if(0 < n) {
+    aData.getBoundingRectangle(lBr);
+  }
+  _xlo  = (0 < n) ? lBr.xlo() : 0;
+  _ylo  = (0 < n) ? lBr.ylo() : 0;
+  _xinv = (0 < n && lBr.xlo() < lBr.xhi()) ? (_noCells / (lBr.xhi() - lBr.xlo())) : 0;
+  _yinv = (0 < n && lBr.ylo() < lBr.yhi()) ? (_noCells / (lBr.yhi() - lBr.ylo())) : 0;
+
+  // counting sort on cell number
+  std::vector<uint32_t> lCellNo(n);
+  _cellBegin.assign(lNoCells + 1, 0);
+  for(uint i = 0; i < n; ++i) {
+    lCellNo[i] = cellNo(cellX(aData[i].x), cellY(aData[i].y));
+    ++_cellBegin[lCellNo[i] + 1];
+  }
+  for(uint i = 0; i < lNoCells; ++i) {
+    _cellBegin[i + 1] += _cellBegin[i];
+  }
+  std::vector<uint32_t> lPos(_cellBegin.begin(), _cellBegin.end() - 1);
+  _x.resize(n);
+  _y.resize(n);
+  _c.resize(n);
+  for(uint i = 0; i < n; ++i) {
+    const uint j = lPos[lCellNo[i]]++;
+    _x[j] = aData[i].x;
+    _y[j] = aData[i].y;
+    _c[j] = aData[i].c;
+  }
+
+  // prefix sums of the cell totals
+  const uint lRowSize = _noCells + 1;
+  _cum.assign(lRowSize * lRowSize, 0);
+  for(uint cy = 0; cy < _noCells; ++cy) {
+    uint lRowSum = 0;
+    for(uint cx = 0; cx < _noCells; ++cx) {
+      const uint lCell = cellNo(cx, cy);
+      for(uint j = _cellBegin[lCell]; j < _cellBegin[lCell + 1]; ++j) {
+        lRowSum += _c[j];
+      }
+      _cum[(cy + 1) * lRowSize + (cx + 1)] = _cum[cy * lRowSize + (cx + 1)] + lRowSum;
+    }
+  }
+}
+
+size_t
+SampleGrid2dim::size() const {
+  return (  _x.size() * sizeof(double) + _y.size() * sizeof(double) + _c.size() * sizeof(uint32_t)
+          + _cellBegin.size() * sizeof(uint32_t) + _cum.size() * sizeof(uint32_t));
+}
+
+// no branch in the loop body, vectorizes
+uint
+SampleGrid2dim::scan(const uint aBegin, const uint aEnd, const rectangle_t& aRectangle) const {
+  const double lXlo = aRectangle.xlo();
+  const double lXhi = aRectangle.xhi();
+  const double lYlo = aRectangle.ylo();
+  const double lYhi = aRectangle.yhi();
+  const double*   lX = _x.data();
+  const double*   lY = _y.data();
+  const uint32_t* lC = _c.data();
+  uint32_t lRes = 0;
+  for(uint i = aBegin; i < aEnd; ++i) {
+    const uint32_t lIn = (lXlo <= lX[i]) & (lX[i] < lXhi) & (lYlo <= lY[i]) & (lY[i] < lYhi);
+    lRes += lC[i] & (0 - lIn);
+  }
+  return lRes;
+}
+
+uint
+SampleGrid2dim::countWithin(const rectangle_t& aRectangle) const {
+  if(0 == n() || !(aRectangle.xlo() < aRectangle.xhi() && aRectangle.ylo() < aRectangle.yhi())) {
+    return 0;
+  }
+  const uint lCx0 = cellX(aRectangle.xlo());
+  const uint lCx1 = cellX(aRectangle.xhi());
+  const uint lCy0 = cellY(aRectangle.ylo());
+  const uint lCy1 = cellY(aRectangle.yhi());
+
+  uint lRes = 0;
+  // inner cells
+  if((lCx0 + 1) < lCx1 && (lCy0 + 1) < lCy1) {
+    lRes += cum(lCx0 + 1, lCx1, lCy0 + 1, lCy1);
+  }
+  // bottom and top row of cells, contiguous in memory
+  lRes += scan(_cellBegin[cellNo(lCx0, lCy0)], _cellBegin[cellNo(lCx1, lCy0) + 1], aRectangle);
+  if(lCy0 < lCy1) {
+    lRes += scan(_cellBegin[cellNo(lCx0, lCy1)], _cellBegin[cellNo(lCx1, lCy1) + 1], aRectangle);
+  }
+  // left and right column of cells in between
+  for(uint cy = lCy0 + 1; cy < lCy1; ++cy) {
+    const uint lLeft = cellNo(lCx0, cy);
+    lRes += scan(_cellBegin[lLeft], _cellBegin[lLeft + 1], aRectangle);
+    if(lCx0 < lCx1) {
+      const uint lRight = cellNo(lCx1, cy);
+      lRes += scan(_cellBegin[lRight], _cellBegin[lRight + 1], aRectangle);
+    }
+  }
+  return lRes;
+}
+
+} // end namespace
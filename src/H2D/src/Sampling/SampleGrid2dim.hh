@@ -0,0 +1,78 @@
+#ifndef SAMPLE_GRID_2DIM_HH
+#define SAMPLE_GRID_2DIM_HH
+
+#include <iostream>
+#include <vector>
+#include <inttypes.h>
+
+#include "../infra/types.hh"
+#include "../infra/data2dim.hh"
+
+namespace H2D {
+
+/*
+ * class SampleGrid2dim
+ * static store for exact counts of weighted points (a sample) within
+ * half-open rectangles [xlo,xhi) x [ylo,yhi).
+ * the bounding rectangle of the points is divided into a regular
+ * _noCells x _noCells grid with about k_points_per_cell points per cell
+ * (at most k_max_grid cells per dimension).
+ * the points are kept column-wise (x, y, c), sorted on their cell
+ * (row-major, y major), and _cum holds the 2-dim prefix sums of the
+ * cell totals.
+ * query: cells strictly between the cells of the query corners are
+ * fully contained (cell() is monotone) and counted from _cum in O(1),
+ * only the points of the boundary cells are scanned, branch free.
+ */
+
+class SampleGrid2dim {
+  public:
+    static constexpr uint k_points_per_cell = 8;
+    static constexpr uint k_max_grid        = 1024;
+  public:
+    SampleGrid2dim();
+    SampleGrid2dim(const Data2dim& aData);
+  public:
+    void init(const Data2dim& aData);
+    uint countWithin(const rectangle_t& aRectangle) const;
+  public:
+    inline uint   n() const { return _x.size(); }
+    inline uint   noCellsPerDim() const { return _noCells; }
+           size_t size() const; // in bytes
+  private:
+    inline uint cellX(const double x) const { return cell(x, _xlo, _xinv); }
+    inline uint cellY(const double y) const { return cell(y, _ylo, _yinv); }
+    inline uint cell(const double v, const double aLo, const double aInv) const {
+                  const double t = (v - aLo) * aInv;
+                  if(!(0 < t)) {
+                    return 0;
+                  }
+                  if(t >= _noCells) {
+                    return (_noCells - 1);
+                  }
+                  return (uint) t;
+                }
+    inline uint cellNo(const uint aCx, const uint aCy) const { return (aCy * _noCells + aCx); }
+    // sum of the cell totals of cells [aCx0,aCx1) x [aCy0,aCy1)
+    inline uint cum(const uint aCx0, const uint aCx1, const uint aCy0, const uint aCy1) const {
+                  const uint lRowSize = _noCells + 1;
+                  return (  _cum[aCy1 * lRowSize + aCx1] - _cum[aCy0 * lRowSize + aCx1]
+                          - _cum[aCy1 * lRowSize + aCx0] + _cum[aCy0 * lRowSize + aCx0]);
+                }
+    uint scan(const uint aBegin, const uint aEnd, const rectangle_t& aRectangle) const;
+  private:
+    std::vector<double>   _x;         // points, sorted on cell number
+    std::vector<double>   _y;
+    std::vector<uint32_t> _c;
+    std::vector<uint32_t> _cellBegin; // points of cell i: [_cellBegin[i], _cellBegin[i+1])
+    std::vector<uint32_t> _cum;       // (_noCells + 1)^2 prefix sums of cell totals
+    uint   _noCells;
+    double _xlo;
+    double _ylo;
+    double _xinv;                     // cells per unit in x
+    double _yinv;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,324 @@
+#include "TreeEnsemble.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+namespace H2D {
+
+namespace {
+
+/*
+ * json_t, JsonParser
+ * just enough JSON to read an XGBoost model file:
+ * no unicode escapes beyond copying them verbatim
+ */
+
+struct json_t {
+  enum kind_t { k_null, k_bool, k_number, k_string, k_array, k_object };
+  kind_t _kind;
+  double _num;
+  std::string _str;
+  std::vector<json_t> _arr;
+  std::vector<std::pair<std::string, json_t>> _obj;
+  json_t() : _kind(k_null), _num(0), _str(), _arr(), _obj() {}
+  const json_t *get(const char *aKey) const {
+    for (const auto &lMember : _obj) {
+      if (lMember.first == aKey) {
+        return &lMember.second;
+      }
+    }
+    return 0;
+  }
+  // numbers are stored as strings in learner_model_param, sometimes as "[5E-1]"
+  double number() const {
+    if (k_string == _kind) {
+      const char *s = _str.c_str();
+      while ('[' == *s || ' ' == *s) {
+        ++s;
+      }
+      return strtod(s, 0);
+    }
+    return _num;
+  }
+};
+
+class JsonParser {
+public:
+  JsonParser(const char *aBegin, const char *aEnd) : _p(aBegin), _end(aEnd) {}
+
+public:
+  bool parse(json_t &aOut) {
+    skip();
+    if (_p >= _end) {
+      return false;
+    }
+    switch (*_p) {
+    case '{':
+      return parseObject(aOut);
+    case '[':
+      return parseArray(aOut);
+    case '"':
+      aOut._kind = json_t::k_string;
+      return parseString(aOut._str);
+    case 't':
+    case 'f':
+    case 'n':
+      return parseLiteral(aOut);
+    default:
+      return parseNumber(aOut);
+    }
+  }
+
+private:
+  void skip() {
+    while (_p < _end && (' ' == *_p || '\n' == *_p || '\r' == *_p || '\t' == *_p)) {
+      ++_p;
+    }
+  }
+  bool expect(const char c) {
+    skip();
+    if (_p < _end && c == *_p) {
+      ++_p;
+      return true;
+    }
+    return false;
+  }
+  bool parseObject(json_t &aOut) {
+    aOut._kind = json_t::k_object;
+    ++_p;
+    if (expect('}')) {
+      return true;
+    }
+    do {
+      std::string lKey;
+      skip();
+      if (!parseString(lKey) || !expect(':')) {
+        return false;
+      }
+      aOut._obj.push_back(std::make_pair(lKey, json_t()));
+      if (!parse(aOut._obj.back().second)) {
+        return false;
+      }
+    } while (expect(','));
+    return expect('}');
+  }
+  bool parseArray(json_t &aOut) {
+    aOut._kind = json_t::k_array;
+    ++_p;
+    if (expect(']')) {
+      return true;
+    }
+    do {
+      aOut._arr.push_back(json_t());
+      if (!parse(aOut._arr.back())) {
+        return false;
+      }
+    } while (expect(','));
+    return expect(']');
+  }
+  bool parseString(std::string &aOut) {
+    if (_p >= _end || '"' != *_p) {
+      return false;
+    }
+    ++_p;
+    while (_p < _end && '"' != *_p) {
+      if ('\\' == *_p && (_p + 1) < _end) {
+        ++_p;
+      }
+      aOut.push_back(*_p++);
+    }
+    return (_p < _end && '"' == *_p++);
+  }
+  bool parseLiteral(json_t &aOut) {
+    static const char *lLit[3] = {"true", "false", "null"};
+    for (uint i = 0; i < 3; ++i) {
+      const size_t lLen = strlen(lLit[i]);
+      if ((size_t)(_end - _p) >= lLen && 0 == strncmp(_p, lLit[i], lLen)) {
+        _p += lLen;
+        aOut._kind = (2 == i) ? json_t::k_null : json_t::k_bool;
+        aOut._num = (0 == i) ? 1 : 0;
+        return true;
+      }
+    }
+    return false;
+  }
+  bool parseNumber(json_t &aOut) {
+    char *lEnd = 0;
+    aOut._kind = json_t::k_number;
+    aOut._num = strtod(_p, &lEnd);
+    if (lEnd == _p) {
+      return false;
+    }
+    _p = lEnd;
+    return true;
+  }
+
+private:
+  const char *_p;
+  const char *_end;
+};
+
+const json_t *getPath(const json_t &aRoot,
+                      std::initializer_list<const char *> aPath) {
+  const json_t *lRes = &aRoot;
+  for (const char *lKey : aPath) {
+    lRes = lRes->get(lKey);
+    if (0 == lRes) {
+      return 0;
+    }
+  }
+  return lRes;
+}
+
+} // end anonymous namespace
+
+TreeEnsemble::TreeEnsemble()
+    : _node(), _tree(), _baseScore(0), _noFeatures(0), _maxDepth(0) {}
+
+void TreeEnsemble::clear() {
+  _node.clear();
+  _tree.clear();
+  _baseScore = 0;
+  _noFeatures = 0;
+  _maxDepth = 0;
+}
+
+bool TreeEnsemble::read(const std::string &aFilename) {
+  clear();
+  std::ifstream lIs(aFilename);
+  if (!lIs) {
+    std::cout << "Can't open file '" << aFilename << "'." << std::endl;
+    return false;
+  }
+  std::stringstream lSs;
+  lSs << lIs.rdbuf();
+  const std::string lText = lSs.str();
+
+  json_t lRoot;
+  JsonParser lParser(lText.data(), lText.data() + lText.size());
+  if (!lParser.parse(lRoot)) {
+    std::cout << "TreeEnsemble: can't parse '" << aFilename << "'." << std::endl;
+    return false;
+  }
+  const json_t *lParam = getPath(lRoot, {"learner", "learner_model_param"});
+  const json_t *lTrees =
+      getPath(lRoot, {"learner", "gradient_booster", "model", "trees"});
+  if (0 == lParam || 0 == lTrees || json_t::k_array != lTrees->_kind) {
+    std::cout << "TreeEnsemble: '" << aFilename << "' is no gbtree model." << std::endl;
+    return false;
+  }
+  if (0 != lParam->get("base_score")) {
+    _baseScore = (float)lParam->get("base_score")->number();
+  }
+  if (0 != lParam->get("num_feature")) {
+    _noFeatures = (uint)lParam->get("num_feature")->number();
+  }
+
+  std::vector<uint32_t> lOrder;
+  std::vector<uint32_t> lDepth;
+  for (const json_t &lTree : lTrees->_arr) {
+    const json_t *lLeft = lTree.get("left_children");
+    const json_t *lRight = lTree.get("right_children");
+    const json_t *lIndex = lTree.get("split_indices");
+    const json_t *lCond = lTree.get("split_conditions");
+    const json_t *lDefault = lTree.get("default_left");
+    if (0 == lLeft || 0 == lRight || 0 == lIndex || 0 == lCond || 0 == lDefault) {
+      std::cout << "TreeEnsemble: incomplete tree in '" << aFilename << "'." << std::endl;
+      clear();
+      return false;
+    }
+    const uint lNoNodes = lLeft->_arr.size();
+    // BFS order, children of a node become adjacent
+    lOrder.assign(1, 0);
+    lDepth.assign(1, 0);
+    for (uint k = 0; k < lOrder.size(); ++k) {
+      const uint32_t o = lOrder[k];
+      const int lL = (int)lLeft->_arr[o].number();
+      const int lR = (int)lRight->_arr[o].number();
+      if (0 <= lL) {
+        if ((uint)lL >= lNoNodes || 0 > lR || (uint)lR >= lNoNodes) {
+          std::cout << "TreeEnsemble: bad child index in '" << aFilename << "'." << std::endl;
+          clear();
+          return false;
+        }
+        lOrder.push_back(lL);
+        lOrder.push_back(lR);
+        lDepth.push_back(lDepth[k] + 1);
+        lDepth.push_back(lDepth[k] + 1);
+      }
+    }
+    tree_t t;
+    t._root = _node.size();
+    t._depth = *std::max_element(lDepth.begin(), lDepth.end());
+    uint32_t lNextChild = t._root + 1;
+    for (uint k = 0; k < lOrder.size(); ++k) {
+      const uint32_t o = lOrder[k];
+      node_t n;
+      if (0 > (int)lLeft->_arr[o].number()) {
+        n._split = std::numeric_limits<float>::infinity();
+        n._feature = k_default_left;
+        n._left = t._root + k;
+        n._value = (float)lCond->_arr[o].number();
+      } else {
+        const uint32_t lFeature = (uint32_t)lIndex->_arr[o].number();
+        if (lFeature >= _noFeatures) {
+          _noFeatures = lFeature + 1;
+        }
+        n._split = (float)lCond->_arr[o].number();
+        n._feature = lFeature | ((0 != lDefault->_arr[o].number()) ? k_default_left : 0);
+        n._left = lNextChild;
+        n._value = 0;
+        lNextChild += 2;
+      }
+      _node.push_back(n);
+    }
+    _maxDepth = std::max<uint>(_maxDepth, t._depth);
+    _tree.push_back(t);
+  }
+  return true;
+}
+
+void TreeEnsemble::predict_batch(const float *aMat, const uint aN,
+                                 const uint aRowSize, float *aOut) const {
+  const uint F = aRowSize;
+  float lSum[k_block];
+  uint32_t lIdx[k_block];
+  for (uint b = 0; b < aN; b += k_block) {
+    const uint lN = std::min<uint>(k_block, aN - b);
+    const float *lRows = aMat + (size_t)b * F;
+    for (uint k = 0; k < lN; ++k) {
+      lSum[k] = _baseScore;
+    }
+    for (const tree_t &t : _tree) {
+      for (uint k = 0; k < lN; ++k) {
+        lIdx[k] = t._root;
+      }
+      for (uint d = 0; d < t._depth; ++d) {
+        for (uint k = 0; k < lN; ++k) {
+          lIdx[k] = next(_node[lIdx[k]], lRows + (size_t)k * F);
+        }
+      }
+      for (uint k = 0; k < lN; ++k) {
+        lSum[k] += _node[lIdx[k]]._value;
+      }
+    }
+    for (uint k = 0; k < lN; ++k) {
+      aOut[b + k] = lSum[k];
+    }
+  }
+}
+
+std::ostream &TreeEnsemble::print(std::ostream &os) const {
+  os << "TreeEnsemble: " << noTrees() << " trees, " << noNodes() << " nodes, "
+     << noFeatures() << " features, max depth " << maxDepth()
+     << ", base score " << baseScore() << std::endl;
+  return os;
+}
+
+} // namespace H2D
@@ -0,0 +1,91 @@
+#ifndef XGB_TREE_ENSEMBLE_HH
+#define XGB_TREE_ENSEMBLE_HH
+
+#include <inttypes.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace H2D {
+
+/*
+ * TreeEnsemble
+ * native inference for a gbtree regression model saved by XGBoosterSaveModel
+ * in JSON format (e.g. <ds>_exgb_model.json).
+ * all trees live in one flat node array, the nodes of a tree are stored in
+ * BFS order and the two children of a node are adjacent, i.e.
+ *   next = _left + !(x[_feature] < _split)
+ * a leaf points to itself (_left = own index, _split = +inf), so every tree
+ * is evaluated branch free with exactly depth(tree) steps.
+ * missing values (NaN) follow the default direction stored in the model.
+ * prediction = base_score + sum of leaf values, summed in float in tree
+ * order as XGBoost does (identity link, reg:squarederror).
+ */
+
+class TreeEnsemble {
+  public:
+    struct node_t {
+      float    _split;   // go left iff x < _split
+      uint32_t _feature; // feature index | k_default_left
+      uint32_t _left;    // index of the left child, right child is _left + 1
+      float    _value;   // leaf value (0 for inner nodes)
+    };
+    static constexpr uint32_t k_default_left = 0x80000000;
+    struct tree_t {
+      uint32_t _root;
+      uint32_t _depth;
+    };
+    static constexpr uint k_block = 32; // rows per block in predict_batch
+  public:
+    TreeEnsemble();
+  public:
+    // false (with a message) if the file cannot be read or is no gbtree model
+    bool read(const std::string& aFilename);
+    void clear();
+  public:
+    inline bool     isLoaded()    const { return (0 < _tree.size()); }
+    inline uint     noTrees()     const { return _tree.size(); }
+    inline uint     noNodes()     const { return _node.size(); }
+    inline uint     noFeatures()  const { return _noFeatures; }
+    inline uint     maxDepth()    const { return _maxDepth; }
+    inline float    baseScore()   const { return _baseScore; }
+    inline const node_t& node(const uint i) const { return _node[i]; }
+    inline bool          isLeaf(const uint i) const { return (i == _node[i]._left); }
+    inline const tree_t& tree(const uint i) const { return _tree[i]; }
+    inline size_t   size() const { return (_node.size() * sizeof(node_t) + _tree.size() * sizeof(tree_t)); }
+  public:
+    // aRow: noFeatures() floats
+    inline float predict(const float* aRow) const {
+                   float lRes = _baseScore;
+                   for(const tree_t& t : _tree) {
+                     uint32_t lIdx = t._root;
+                     for(uint d = 0; d < t._depth; ++d) {
+                       lIdx = next(_node[lIdx], aRow);
+                     }
+                     lRes += _node[lIdx]._value;
+                   }
+                   return lRes;
+                 }
+    // aMat: aN rows of aRowSize >= noFeatures() floats (row major), aOut[i] = predict(aMat + i * aRowSize)
+    // trees are the outer loop within a block of k_block rows: the rows of a block
+    // are independent and walk the same (cache resident) tree in lock step
+    void predict_batch(const float* aMat, const uint aN, const uint aRowSize, float* aOut) const;
+  public:
+    std::ostream& print(std::ostream& os) const;
+  private:
+    static inline uint32_t next(const node_t& n, const float* aRow) {
+                             const float    x      = aRow[n._feature & ~k_default_left];
+                             const uint32_t lRight = (!(x < n._split)) & !((x != x) & (0 != (n._feature & k_default_left)));
+                             return (n._left + lRight);
+                           }
+  private:
+    std::vector<node_t> _node;
+    std::vector<tree_t> _tree;
+    float               _baseScore;
+    uint                _noFeatures;
+    uint                _maxDepth;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef XGB_COMPILED_HH
+#define XGB_COMPILED_HH
+
+#include "infra/EstimatorBase2dim.hh"
+#include "infra/types.hh"
+#include "XGBoost/XGBEstimator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <inttypes.h>
+#include <iostream>
+
+namespace H2D {
+
+/*
+ * xgb_ctree_tt
+ * one regression tree of fixed depth Tdepth as a complete binary tree:
+ * inner node i (root 0) has children 2i+1 and 2i+2, the leaves follow the
+ * 2^Tdepth - 1 inner nodes. trees of XGBoost's depth limited growth that
+ * stop early are padded by main_xgb_codegen: a padding node has split +inf
+ * and both subtrees carry the same leaf value.
+ * missing values (NaN) always go right, the XGB features are never NaN.
+ */
+
+template <uint Tdepth> struct xgb_ctree_tt {
+  static constexpr uint k_depth = Tdepth;
+  static constexpr uint k_no_inner = (1 << Tdepth) - 1;
+  static constexpr uint k_no_leaf = (1 << Tdepth);
+  float _split[k_no_inner];
+  uint8_t _feature[k_no_inner];
+  float _leaf[k_no_leaf];
+
+  inline float eval(const float *aRow) const {
+    uint i = 0;
+    for (uint d = 0; d < Tdepth; ++d) {
+      i = 2 * i + 1 + !(aRow[_feature[i]] < _split[i]);
+    }
+    return _leaf[i - k_no_inner];
+  }
+};
+
+/*
+ * XGBCompiled_TT
+ * estimator for a tree ensemble compiled into the binary.
+ * Tmodel is a struct generated by main_xgb_codegen from a saved model
+ * (<ds>_exgb_model.json):
+ *   static constexpr uint  k_depth, k_no_trees, k_no_features;
+ *   static constexpr float k_base_score;
+ *   static constexpr xgb_ctree_tt<k_depth> k_tree[k_no_trees];
+ * with aFeatureSource == 0 the features are xlo, xhi, ylo, yhi (XGB),
+ * otherwise the rows are filled by aFeatureSource->fill_features (EXGB, LWXGB).
+ */
+
+template <class Tmodel> class XGBCompiled_TT : public EstimatorBase2dim {
+public:
+  typedef xgb_ctree_tt<Tmodel::k_depth> tree_t;
+  static constexpr uint k_block = 32; // rows per block in predict_batch
+
+public:
+  XGBCompiled_TT(const double aQ, const double aTheta, const uint aMaxCard,
+                 const XGBEstimator *aFeatureSource = 0)
+      : EstimatorBase2dim(aQ, aTheta), _logMaxCard(std::log(aMaxCard)),
+        _featureSource(aFeatureSource) {}
+
+public:
+  static inline float predict(const float *aRow) {
+    float lRes = Tmodel::k_base_score;
+    for (uint t = 0; t < Tmodel::k_no_trees; ++t) {
+      lRes += Tmodel::k_tree[t].eval(aRow);
+    }
+    return lRes;
+  }
+  // trees are the outer loop within a block of rows (see TreeEnsemble::predict_batch)
+  static void predict_batch(const float *aMat, const uint aN,
+                            const uint aRowSize, float *aOut) {
+    float lSum[k_block];
+    for (uint b = 0; b < aN; b += k_block) {
+      const uint lN = std::min<uint>(k_block, aN - b);
+      const float *lRows = aMat + (size_t)b * aRowSize;
+      for (uint k = 0; k < lN; ++k) {
+        lSum[k] = Tmodel::k_base_score;
+      }
+      for (uint t = 0; t < Tmodel::k_no_trees; ++t) {
+        const tree_t &lTree = Tmodel::k_tree[t];
+        for (uint k = 0; k < lN; ++k) {
+          lSum[k] += lTree.eval(lRows + (size_t)k * aRowSize);
+        }
+      }
+      for (uint k = 0; k < lN; ++k) {
+        aOut[b + k] = lSum[k];
+      }
+    }
+  }
+
+public:
+  inline uint num_features() const {
+    return ((0 == _featureSource) ? 4 : _featureSource->num_features());
+  }
+  inline void fill_features(const query_t &aQuery, float *aRowOut) const {
+    if (0 == _featureSource) {
+      const rectangle_t &r = aQuery.rectangle();
+      aRowOut[0] = r._pll.x;
+      aRowOut[1] = r._pur.x;
+      aRowOut[2] = r._pll.y;
+      aRowOut[3] = r._pur.y;
+    } else {
+      _featureSource->fill_features(aQuery, aRowOut);
+    }
+  }
+  inline double card_of(const float aPred) const {
+    const double lRes = round(std::exp(aPred * _logMaxCard));
+    return std::max<double>(minEstimate(), lRes);
+  }
+
+public:
+  virtual double estimate(const query_t &lQuery) const {
+    float lRow[XGBEstimator::k_max_features];
+    fill_features(lQuery, lRow);
+    return card_of(predict(lRow));
+  }
+  virtual double estimate(const rectangle_t &r) const {
+    query_t lQuery;
+    lQuery._rectangle = r;
+    return estimate(lQuery);
+  }
+  virtual void estimate_batch(const query_t *aBegin, const size_t aN,
+                              double *aEstOut) const {
+    const uint lNoFeatures = num_features();
+    float lMat[k_block * XGBEstimator::k_max_features];
+    float lPred[k_block];
+    for (size_t b = 0; b < aN; b += k_block) {
+      const uint lN = std::min<size_t>(k_block, aN - b);
+      if (0 == _featureSource) {
+        for (uint k = 0; k < lN; ++k) {
+          fill_features(aBegin[b + k], lMat + k * lNoFeatures);
+        }
+      } else {
+        _featureSource->fill_features_batch(aBegin + b, lN, lMat);
+      }
+      predict_batch(lMat, lN, lNoFeatures, lPred);
+      for (uint k = 0; k < lN; ++k) {
+        aEstOut[b + k] = card_of(lPred[k]);
+      }
+    }
+  }
+  virtual uint size() const { return sizeof(Tmodel::k_tree); }
+  virtual std::ostream &print_name_param(std::ostream &os) const {
+    os << "XGBCompiled(" << Tmodel::k_no_trees << " trees, depth "
+       << Tmodel::k_depth << ")";
+    return os;
+  }
+
+private:
+  double _logMaxCard;
+  const XGBEstimator *_featureSource;
+};
+
+} // namespace H2D
+
+#endif
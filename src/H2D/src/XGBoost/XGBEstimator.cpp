@@ -12,14 +12,14 @@ XGBEstimator::XGBEstimator(const H2D::Cb &aCb,
       _num_train_queries(aCb.xgb_num_train_queries()), _filebase(file_base),
       _queries(queryvec), _trainQueries(trainQueryvec), _preds(queryvec.size()),
       _silent(), _use_gpu(), booster(), dtrain(), dtest(), deval(), _enriched(),
-      _aCb(aCb) {}
+      _model(), _aCb(aCb) {}
 
 XGBEstimator::XGBEstimator(XGBEstimator &oxgb)
     : _max_card(oxgb._max_card), _num_trees(oxgb._num_trees),
       _num_train_queries(oxgb._num_train_queries), _filebase(oxgb._filebase),
       _queries(oxgb._queries), _trainQueries(oxgb._trainQueries),
       _preds(oxgb._preds), _silent(1), _use_gpu(1), booster(), dtrain(),
-      dtest(), deval(), _enriched(), _aCb(oxgb._aCb)
+      dtest(), deval(), _enriched(), _model(oxgb._model), _aCb(oxgb._aCb)
 
 {}
 XGBEstimator &XGBEstimator::operator=(const XGBEstimator &oxgb) {
@@ -34,12 +34,13 @@ XGBEstimator &XGBEstimator::operator=(const XGBEstimator &oxgb) {
   this->booster = NULL;
   this->dtrain = NULL;
   this->dtest = NULL;
+  this->_model = oxgb._model;
   return *this;
 }
 std::ostream &XGBEstimator::print_name_param(std::ostream &os) const {
   return os;
 }
-uint XGBEstimator::size() const { return 0; }
+uint XGBEstimator::size() const { return _model.size(); }
 
 query_vt XGBEstimator::read_query_file(const std::string &aFilename) {
   _queries.clear();
@@ -74,7 +75,7 @@ void XGBEstimator::fill_libsvm_trainfiles() const {
   train_out_file.open(_aCb.inDir()+"/" + _aCb.sds() + "/" + _aCb.ds() +
                       "_train_libsvm.dat");
 
-  for (uint i = 0; i < (num_train_queries() - (num_train_queries() / 5)); i++) {
+  for (uint i = 0; i < num_train_split(); i++) {
     const query_t &cq = trainQueries()[i];
     const rectangle_t &cr = cq.rectangle();
     train_out_file << float(std::log(cq.card()) / std::log(max_card()))
@@ -86,8 +87,7 @@ void XGBEstimator::fill_libsvm_trainfiles() const {
   eval_out_file.open(_aCb.inDir()+"/" + _aCb.sds() + "/" + _aCb.ds() +
                      "_eval_libsvm.dat");
 
-  for (uint i = (num_train_queries() - (num_train_queries() / 5));
-       i < num_train_queries(); i++) {
+  for (uint i = num_train_split(); i < num_train_queries(); i++) {
     const query_t &cq = trainQueries()[i];
     const rectangle_t &cr = cq.rectangle();
 
@@ -114,6 +114,66 @@ void XGBEstimator::fill_libsvm_testfiles() const {
   test_out_file.close();
 }
 
+void XGBEstimator::fill_features(const query_t &aQuery, float *aRowOut) const {
+  const rectangle_t &r = aQuery.rectangle();
+  aRowOut[0] = feature(r._pll.x);
+  aRowOut[1] = feature(r._pur.x);
+  aRowOut[2] = feature(r._pll.y);
+  aRowOut[3] = feature(r._pur.y);
+}
+
+float XGBEstimator::text_float(const double x) {
+  char lBuf[32];
+  snprintf(lBuf, sizeof(lBuf), "%g", x);
+  return strtof(lBuf, NULL);
+}
+
+void XGBEstimator::fill_features_batch(const query_t *aBegin, const uint aN,
+                                       float *aMatOut) const {
+  const uint lNoFeatures = num_features();
+  for (uint i = 0; i < aN; ++i) {
+    fill_features(aBegin[i], aMatOut + (size_t)i * lNoFeatures);
+  }
+}
+
+void XGBEstimator::fill_matrix(const query_t *aBegin, const uint aN,
+                               float *aMatOut, float *aLabelOut) const {
+  const uint lNoFeatures = num_features();
+  for (uint i = 0; i < aN; ++i) {
+    aLabelOut[i] = label(aBegin[i]);
+  }
+  const uint lMinChunk = 256;
+  const uint lNoThreads = std::max<uint>(
+      1, std::min<uint>(_aCb.noThreads(), aN / lMinChunk));
+  if (1 == lNoThreads) {
+    fill_features_batch(aBegin, aN, aMatOut);
+    return;
+  }
+  std::vector<std::thread> lThreads;
+  const uint lChunk = (aN + lNoThreads - 1) / lNoThreads;
+  for (uint lBegin = 0; lBegin < aN; lBegin += lChunk) {
+    const uint lN = std::min<uint>(lChunk, aN - lBegin);
+    lThreads.push_back(std::thread(
+        &XGBEstimator::fill_features_batch, this, aBegin + lBegin, lN,
+        aMatOut + (size_t)lBegin * lNoFeatures));
+  }
+  for (auto &lThread : lThreads) {
+    lThread.join();
+  }
+}
+
+void XGBEstimator::create_dmatrix(const query_t *aBegin, const uint aN,
+                                  DMatrixHandle *aOut) const {
+  const uint lNoFeatures = num_features();
+  std::vector<float> lMat((size_t)aN * lNoFeatures);
+  std::vector<float> lLabel(aN);
+  fill_matrix(aBegin, aN, lMat.data(), lLabel.data());
+  safe_xgboost(XGDMatrixCreateFromMat(lMat.data(), aN, lNoFeatures,
+                                      std::numeric_limits<float>::quiet_NaN(),
+                                      aOut));
+  safe_xgboost(XGDMatrixSetFloatInfo(*aOut, "label", lLabel.data(), aN));
+}
+
 void XGBEstimator::train_model(const char *trainFileName,
                                const char *evalFileName)
 
@@ -121,7 +181,18 @@ void XGBEstimator::train_model(const char *trainFileName,
 
   safe_xgboost(XGDMatrixCreateFromFile(trainFileName, _silent, &dtrain));
   safe_xgboost(XGDMatrixCreateFromFile(evalFileName, _silent, &deval));
+  train_booster();
+}
 
+void XGBEstimator::train_model() {
+  const uint lSplit = num_train_split();
+  create_dmatrix(trainQueries().data(), lSplit, &dtrain);
+  create_dmatrix(trainQueries().data() + lSplit,
+                 num_train_queries() - lSplit, &deval);
+  train_booster();
+}
+
+void XGBEstimator::train_booster() {
   // create the booster
 
   DMatrixHandle eval_dmats[2] = {dtrain, deval};
@@ -171,14 +242,55 @@ void XGBEstimator::train_model(const char *trainFileName,
                                      &out_features, &out_n_features, &outShape,
                                      &out_scores));
 
-  safe_xgboost(
-      XGBoosterSaveModel(booster, (_aCb.outDir()+"/" + _aCb.sds() + "/" +
-                                   _aCb.ds() + "_exgb_model.json")
-                                      .c_str()));
+  const std::string lModelFile = _aCb.xgb_model_file();
+  safe_xgboost(XGBoosterSaveModel(booster, lModelFile.c_str()));
+  read_model(lModelFile);
+}
+
+bool XGBEstimator::read_model(const std::string &aFilename) {
+  if (!_model.read(aFilename)) {
+    return false;
+  }
+  if (_model.noFeatures() > num_features()) {
+    std::cout << "XGBEstimator: model '" << aFilename << "' uses "
+              << _model.noFeatures() << " features, only " << num_features()
+              << " are provided." << std::endl;
+    _model.clear();
+    return false;
+  }
+  return true;
+}
+
+uint XGBEstimator::check_model(const std::string &aName, std::ostream &os) {
+  run_prediction();
+  const uint lNoQuery = queries().size();
+  uint lNoMismatch = 0;
+  float lMaxDiff = 0;
+  float lRow[k_max_features];
+  for (uint i = 0; i < lNoQuery; ++i) {
+    fill_features(queries()[i], lRow);
+    const float lDiff = std::fabs(_model.predict(lRow) - _preds[i]);
+    if (0 < lDiff) {
+      ++lNoMismatch;
+      lMaxDiff = std::max(lMaxDiff, lDiff);
+    }
+  }
+  os << "! xgb-check " << aName << ' ' << lNoQuery << ' ' << lNoMismatch
+     << ' ' << lMaxDiff << std::endl;
+  return lNoMismatch;
 }
 
 void XGBEstimator::run_prediction(const char *testFileName) {
   safe_xgboost(XGDMatrixCreateFromFile(testFileName, _silent, &dtest));
+  predict();
+}
+
+void XGBEstimator::run_prediction() {
+  create_dmatrix(queries().data(), queries().size(), &dtest);
+  predict();
+}
+
+void XGBEstimator::predict() {
   float const *pred_card = NULL;
 
   char const config[] =
@@ -206,22 +318,53 @@ void XGBEstimator::run_prediction(const char *testFileName) {
 }
 
 double XGBEstimator::estimate(const rectangle_t &r) const {
-
-  std::cout << "Not a suitable estimate method for XGBoost" << std::endl;
-  return 0.0;
+  if (!_model.isLoaded()) {
+    std::cout << "Not a suitable estimate method for XGBoost" << std::endl;
+    return 0.0;
+  }
+  query_t lQuery;
+  lQuery._rectangle = r;
+  return estimate(lQuery);
 }
 
 double XGBEstimator::estimate(const query_t &lQuery) const {
-  double lRes = 0;
+  if (_model.isLoaded()) {
+    float lRow[k_max_features];
+    fill_features(lQuery, lRow);
+    return card_of(_model.predict(lRow));
+  }
   // return unnormalized card
-  lRes = round(std::exp(_preds[lQuery.no() - 1] * (std::log(max_card()))));
-  return std::max<double>(minEstimate(), lRes);
+  return card_of(_preds[lQuery.no() - 1]);
+}
+
+void XGBEstimator::estimate_batch(const query_t *aBegin, const size_t aN,
+                                  double *aEstOut) const {
+  if (!_model.isLoaded()) {
+    EstimatorBase2dim::estimate_batch(aBegin, aN, aEstOut);
+    return;
+  }
+  const uint lNoFeatures = num_features();
+  float lMat[TreeEnsemble::k_block * k_max_features];
+  float lPred[TreeEnsemble::k_block];
+  for (size_t b = 0; b < aN; b += TreeEnsemble::k_block) {
+    const uint lN = std::min<size_t>(TreeEnsemble::k_block, aN - b);
+    fill_features_batch(aBegin + b, lN, lMat);
+    _model.predict_batch(lMat, lN, lNoFeatures, lPred);
+    for (uint k = 0; k < lN; ++k) {
+      aEstOut[b + k] = card_of(lPred[k]);
+    }
+  }
 }
 
 XGBEstimator::~XGBEstimator() {
   safe_xgboost(XGBoosterFree(booster));
   safe_xgboost(XGDMatrixFree(dtrain));
-  safe_xgboost(XGDMatrixFree(dtest));
+  if (dtest) {
+    safe_xgboost(XGDMatrixFree(dtest));
+  }
+  if (deval) {
+    safe_xgboost(XGDMatrixFree(deval));
+  }
 }
 
 } // namespace H2D
@@ -3,16 +3,20 @@
 #include "infra/EstimatorBase2dim.hh"
 #include "infra/cb.hh"
 #include "infra/types.hh"
+#include "XGBoost/TreeEnsemble.hh"
 #include </home/rashedi/xgboost/include/xgboost/c_api.h>
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define safe_xgboost(call)                                                     \
@@ -43,11 +47,46 @@ public:
   void run_estimate();
   void run_prediction(const char *testFileName);
   void train_model(const char *trainFileName, const char *evalFileName);
+  // in memory: feature matrices are handed to XGDMatrixCreateFromMat,
+  // the first 80% of the training queries train, the rest evaluate
+  void run_prediction();
+  void train_model();
+  // one row of the feature matrix: xlo, xhi, ylo, yhi (+ enrichments)
+  virtual uint num_features() const { return 4; }
+  virtual void fill_features(const query_t &aQuery, float *aRowOut) const;
+  // aN rows into aMatOut (row major), the default loops over fill_features,
+  // enriched estimators override it to evaluate their estimators in batches
+  virtual void fill_features_batch(const query_t *aBegin, const uint aN,
+                                   float *aMatOut) const;
+  inline float label(const query_t &aQuery) const {
+    return feature(std::log(aQuery.card()) / std::log(max_card()));
+  }
+  // a real valued feature or label as the former libsvm text files held
+  // it (written with the default 6 significant digits, read back as
+  // float), such that models and estimates are those of the file based
+  // path. with --xgb-full-precision the value is only converted to float.
+  inline float feature(const double x) const {
+    return (_aCb.xgb_full_precision() ? float(x) : text_float(x));
+  }
+  static float text_float(const double x);
+  static constexpr uint k_max_features = 16;
   query_vt read_query_file(const std::string &aFilename);
   virtual void fill_libsvm_trainfiles() const;
   virtual void fill_libsvm_testfiles() const;
+  // after train_model (or read_model) the saved booster is evaluated
+  // natively by TreeEnsemble, otherwise estimate(query_t) looks up
+  // the prediction of run_prediction by query number
   double estimate(const query_t &lQuery) const;
   double estimate(const rectangle_t &r) const;
+  void estimate_batch(const query_t *aBegin, const size_t aN,
+                      double *aEstOut) const;
+  bool read_model(const std::string &aFilename);
+  // debug: predicts the test queries by XGBoost (run_prediction) and
+  // natively by model(), prints
+  // ! xgb-check <name> <#queries> <#mismatch> <max abs diff>
+  // returns the number of queries with different predictions
+  uint check_model(const std::string &aName, std::ostream &os);
+  inline const TreeEnsemble &model() const { return _model; }
   std::ostream &print_name_param(std::ostream &os) const;
   uint size() const;
   inline const std::string &filebase() const { return _filebase; }
@@ -59,6 +98,25 @@ public:
 
 protected:
   inline void setEnriched(uint value) { _enriched = value; }
+  inline uint num_train_split() const {
+    return (num_train_queries() - (num_train_queries() / 5));
+  }
+  // feature matrix and labels for aN queries: contiguous chunks of rows
+  // are filled by up to noThreads threads, the row order is that of the queries
+  void fill_matrix(const query_t *aBegin, const uint aN, float *aMatOut,
+                   float *aLabelOut) const;
+  // row major dense matrix plus labels for aN queries
+  void create_dmatrix(const query_t *aBegin, const uint aN,
+                      DMatrixHandle *aOut) const;
+
+private:
+  void train_booster();
+  void predict();
+  // inverse of label
+  inline double card_of(const float aPred) const {
+    const double lRes = round(std::exp(aPred * (std::log(max_card()))));
+    return std::max<double>(minEstimate(), lRes);
+  }
 
 private:
   uint _max_card;
@@ -73,6 +131,7 @@ private:
   BoosterHandle booster;
   DMatrixHandle dtrain, dtest, deval;
   uint _enriched;
+  TreeEnsemble _model;
 
 protected:
   H2D::Cb _aCb;
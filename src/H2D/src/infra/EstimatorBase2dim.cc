@@ -8,8 +8,17 @@ uint EstimatorBase2dim::_freqValSize = 4;
 
 EstimatorBase2dim::~EstimatorBase2dim() {}
 
+void
+EstimatorBase2dim::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  for(size_t i = 0; i < aN; ++i) {
+    aEstOut[i] = estimate(aBegin[i]);
+  }
+}
+
 void EstimatorBase2dim::run_prediction(const char* testFileName){}
 void EstimatorBase2dim::train_model(const char* trainFileName , const char* evalFileName){}
+void EstimatorBase2dim::run_prediction(){}
+void EstimatorBase2dim::train_model(){}
 void EstimatorBase2dim::fill_libsvm_trainfiles() const{}
 void EstimatorBase2dim::fill_libsvm_testfiles() const{}
 
@@ -18,8 +18,13 @@ class EstimatorBase2dim {
   public:
     virtual double estimate(const query_t& lQuery) const = 0;
     virtual double estimate(const rectangle_t& r) const = 0;
+    // aEstOut[i] = estimate(aBegin[i]) for i < aN
+    // the default loops over estimate, hot estimators override it
+    virtual void estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
     virtual void run_prediction(const char* testFileName);
     virtual void train_model(const char* trainFileName , const char* evalFileName);
+    virtual void run_prediction(); // in memory, no files
+    virtual void train_model();
     virtual void fill_libsvm_trainfiles() const;
     virtual void fill_libsvm_testfiles() const;
 
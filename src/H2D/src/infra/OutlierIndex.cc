@@ -0,0 +1,167 @@
+#include "OutlierIndex.hh"
+#include "data2dim.hh"
+
+#include <algorithm>
+
+namespace H2D {
+
+
+OutlierIndex::OutlierIndex() : _x(), _y(), _c(), _node(), _xs(), _xcum(), _ys(), _ycum() {}
+
+OutlierIndex::OutlierIndex(const Data2dim& aData) : _x(), _y(), _c(), _node(), _xs(), _xcum(), _ys(), _ycum() {
+  init(aData);
+}
+
+void
+OutlierIndex::init(const Data2dim& aData) {
+  const uint n = aData.size();
+  _x.resize(n);
+  _y.resize(n);
+  _c.resize(n);
+  _node.clear();
+
+  // 1-dim: sorted values with prefix sums
+  std::vector<std::pair<double, uint32_t>> lVal(n);
+  for(uint lDim = 0; lDim < 2; ++lDim) {
+    for(uint i = 0; i < n; ++i) {
+      lVal[i] = std::make_pair((0 == lDim) ? aData[i].x : aData[i].y, aData[i].c);
+    }
+    std::sort(lVal.begin(), lVal.end());
+    std::vector<double>&   lVs  = (0 == lDim) ? _xs : _ys;
+    std::vector<uint32_t>& lCum = (0 == lDim) ? _xcum : _ycum;
+    lVs.resize(n);
+    lCum.resize(n + 1);
+    lCum[0] = 0;
+    for(uint i = 0; i < n; ++i) {
+      lVs[i]      = lVal[i].first;
+      lCum[i + 1] = lCum[i] + lVal[i].second;
+    }
+  }
+
+  if(0 == n) {
+    return;
+  }
+
+  // 2-dim: implicit k-d tree over a complete binary tree
+  uint lNoLeaves = 1;
+  while(k_leaf_size * lNoLeaves < n) {
+    lNoLeaves *= 2;
+  }
+  _node.resize(2 * lNoLeaves - 1);
+  std::vector<xyc_t> lPoints(n);
+  for(uint i = 0; i < n; ++i) {
+    lPoints[i] = aData[i];
+  }
+  build(0, 0, n, 0, lPoints);
+  for(uint i = 0; i < n; ++i) {
+    _x[i] = lPoints[i].x;
+    _y[i] = lPoints[i].y;
+    _c[i] = lPoints[i].c;
+  }
+}
+
+void
+OutlierIndex::build(const uint aNode, const uint aBegin, const uint aEnd, const uint aLevel, std::vector<xyc_t>& aPoints) {
+  node_t& lNode = _node[aNode];
+  lNode._begin = aBegin;
+  lNode._end   = aEnd;
+  lNode._total = 0;
+  if(aBegin == aEnd) {
+    lNode._br._pll.x = lNode._br._pll.y = 1;   // empty rectangle,
+    lNode._br._pur.x = lNode._br._pur.y = 0;   // never intersects
+  } else {
+    lNode._br._pll.x = lNode._br._pur.x = aPoints[aBegin].x;
+    lNode._br._pll.y = lNode._br._pur.y = aPoints[aBegin].y;
+    for(uint i = aBegin; i < aEnd; ++i) {
+      const xyc_t& p = aPoints[i];
+      lNode._br._pll.x = std::min<double>(lNode._br._pll.x, p.x);
+      lNode._br._pll.y = std::min<double>(lNode._br._pll.y, p.y);
+      lNode._br._pur.x = std::max<double>(lNode._br._pur.x, p.x);
+      lNode._br._pur.y = std::max<double>(lNode._br._pur.y, p.y);
+      lNode._total += p.c;
+    }
+  }
+  const uint lLeft = 2 * aNode + 1;
+  if(lLeft >= _node.size()) {
+    return;
+  }
+  const uint lMid = aBegin + (aEnd - aBegin) / 2;
+  if(0 == (aLevel & 1)) {
+    std::nth_element(aPoints.begin() + aBegin, aPoints.begin() + lMid, aPoints.begin() + aEnd, Data2dim::LessX());
+  } else {
+    std::nth_element(aPoints.begin() + aBegin, aPoints.begin() + lMid, aPoints.begin() + aEnd, Data2dim::LessY());
+  }
+  build(lLeft,     aBegin, lMid, aLevel + 1, aPoints);
+  build(lLeft + 1, lMid,   aEnd, aLevel + 1, aPoints);
+}
+
+size_t
+OutlierIndex::size() const {
+  return (  (_x.size() + _y.size() + _xs.size() + _ys.size()) * sizeof(double)
+          + (_c.size() + _xcum.size() + _ycum.size()) * sizeof(uint32_t)
+          + _node.size() * sizeof(node_t));
+}
+
+uint
+OutlierIndex::scan(const uint aBegin, const uint aEnd, const rectangle_t& aRectangle) const {
+  uint lRes = 0;
+  for(uint i = aBegin; i < aEnd; ++i) {
+    lRes += aRectangle.containsHalfOpen(_x[i], _y[i]) ? _c[i] : 0;
+  }
+  return lRes;
+}
+
+uint
+OutlierIndex::countWithin(const rectangle_t& aRectangle) const {
+  if(_node.empty()) {
+    return 0;
+  }
+  const rectangle_t& r = aRectangle;
+  uint lRes = 0;
+  uint lStack[64];
+  uint lTop = 0;
+  lStack[lTop++] = 0;
+  while(0 < lTop) {
+    const uint    lNo   = lStack[--lTop];
+    const node_t& lNode = _node[lNo];
+    const rectangle_t& b = lNode._br;
+    if(b._pur.x < r._pll.x || b._pll.x >= r._pur.x || b._pur.y < r._pll.y || b._pll.y >= r._pur.y) {
+      continue; // disjoint (or empty)
+    }
+    if(r._pll.x <= b._pll.x && b._pur.x < r._pur.x && r._pll.y <= b._pll.y && b._pur.y < r._pur.y) {
+      lRes += lNode._total; // fully contained
+      continue;
+    }
+    const uint lLeft = 2 * lNo + 1;
+    if(lLeft >= _node.size()) {
+      lRes += scan(lNode._begin, lNode._end, r);
+    } else {
+      lStack[lTop++] = lLeft + 1;
+      lStack[lTop++] = lLeft;
+    }
+  }
+  return lRes;
+}
+
+uint
+OutlierIndex::count1dim(const std::vector<double>& aVal, const std::vector<uint32_t>& aCum,
+                        const double aLo, const double aHi) {
+  if(!(aLo < aHi)) {
+    return 0;
+  }
+  const size_t lLo = std::lower_bound(aVal.begin(), aVal.end(), aLo) - aVal.begin();
+  const size_t lHi = std::lower_bound(aVal.begin(), aVal.end(), aHi) - aVal.begin();
+  return (aCum[lHi] - aCum[lLo]);
+}
+
+uint
+OutlierIndex::countWithinX(const double aLo, const double aHi) const {
+  return count1dim(_xs, _xcum, aLo, aHi);
+}
+
+uint
+OutlierIndex::countWithinY(const double aLo, const double aHi) const {
+  return count1dim(_ys, _ycum, aLo, aHi);
+}
+
+} // end namespace
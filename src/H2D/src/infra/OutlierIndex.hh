@@ -0,0 +1,70 @@
+#ifndef H2D_INFRA_OUTLIER_INDEX_HH
+#define H2D_INFRA_OUTLIER_INDEX_HH
+
+#include <iostream>
+#include <vector>
+#include <inttypes.h>
+
+#include "types.hh"
+
+namespace H2D {
+
+class Data2dim;
+struct xyc_t;
+
+/*
+ * class OutlierIndex
+ * static index for exact counts of the phi-outliers of an estimator
+ * (Data2dim::split) within half-open rectangles [xlo,xhi) x [ylo,yhi)
+ * or half-open intervals in x or y alone.
+ * 2-dim: implicit k-d tree (node i has children 2i+1, 2i+2), built by
+ * median splits alternating on x and y. the points are packed column-wise
+ * in leaf order, every node carries its bounding rectangle and total.
+ * a node fully inside the query contributes its total, a node disjoint
+ * to the query is skipped, leaves (<= k_leaf_size points) are scanned.
+ * up to k_leaf_size points there is only the root, i.e. a linear scan.
+ * 1-dim: x and y values sorted, with prefix sums, binary search.
+ */
+
+class OutlierIndex {
+  public:
+    static constexpr uint k_leaf_size = 16;
+  public:
+    OutlierIndex();
+    OutlierIndex(const Data2dim& aData);
+  public:
+    void init(const Data2dim& aData);
+    uint countWithin(const rectangle_t& aRectangle) const;
+    uint countWithinX(const double aLo, const double aHi) const; // points with aLo <= x < aHi
+    uint countWithinY(const double aLo, const double aHi) const; // points with aLo <= y < aHi
+  public:
+    inline uint   n() const { return _x.size(); }
+    inline uint   noNodes() const { return _node.size(); }
+           size_t size() const; // in bytes
+  private:
+    struct node_t {
+      rectangle_t _br;    // bounding rectangle of the points below
+      uint32_t    _begin; // points [_begin, _end) in _x, _y, _c
+      uint32_t    _end;
+      uint32_t    _total;
+      node_t() : _br(), _begin(0), _end(0), _total(0) {}
+    };
+  private:
+    void build(const uint aNode, const uint aBegin, const uint aEnd, const uint aLevel, std::vector<xyc_t>& aPoints);
+    uint scan(const uint aBegin, const uint aEnd, const rectangle_t& aRectangle) const;
+    static uint count1dim(const std::vector<double>& aVal, const std::vector<uint32_t>& aCum,
+                          const double aLo, const double aHi);
+  private:
+    std::vector<double>   _x;    // points in leaf order
+    std::vector<double>   _y;
+    std::vector<uint32_t> _c;
+    std::vector<node_t>   _node; // implicit k-d tree
+    std::vector<double>   _xs;   // x values, sorted
+    std::vector<uint32_t> _xcum; // _xcum[i] = sum of frequencies of _xs[0..i)
+    std::vector<double>   _ys;   // y values, sorted
+    std::vector<uint32_t> _ycum;
+};
+
+} // end namespace
+
+#endif
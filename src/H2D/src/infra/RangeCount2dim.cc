@@ -0,0 +1,145 @@
+#include "RangeCount2dim.hh"
+#include "data2dim.hh"
+
+#include <algorithm>
+#include <numeric>
+
+namespace H2D {
+
+
+RangeCount2dim::RangeCount2dim(const std::vector<xyc_t>& aData) : _x(), _rank(), _freq(), _ys(), _level() {
+  const uint n = aData.size();
+
+  // distinct y values
+  _ys.resize(n);
+  for(uint i = 0; i < n; ++i) {
+    _ys[i] = aData[i].y;
+  }
+  std::sort(_ys.begin(), _ys.end());
+  _ys.erase(std::unique(_ys.begin(), _ys.end()), _ys.end());
+
+  // points in x order
+  std::vector<uint32_t> lPerm(n);
+  std::iota(lPerm.begin(), lPerm.end(), 0);
+  std::sort(lPerm.begin(), lPerm.end(), [&aData] (const uint32_t a, const uint32_t b) {
+                                          return (aData[a].x < aData[b].x);
+                                        });
+  _x.resize(n);
+  _rank.resize(n);
+  _freq.resize(n);
+  for(uint i = 0; i < n; ++i) {
+    const xyc_t& p = aData[lPerm[i]];
+    _x[i]    = p.x;
+    _rank[i] = std::lower_bound(_ys.begin(), _ys.end(), p.y) - _ys.begin();
+    _freq[i] = p.c;
+  }
+
+  // levels: sort leaf blocks, then merge pairs of blocks
+  // (rank, freq) pairs are kept in one array during construction
+  std::vector<uint64_t> lCur(n);
+  std::vector<uint64_t> lNxt(n);
+  for(uint i = 0; i < n; ++i) {
+    lCur[i] = (((uint64_t) _rank[i]) << 32) | _freq[i];
+  }
+  for(uint lBegin = 0; lBegin < n; lBegin += k_leaf_size) {
+    const uint lEnd = std::min<uint>(n, lBegin + k_leaf_size);
+    std::sort(lCur.begin() + lBegin, lCur.begin() + lEnd);
+  }
+  for(uint64_t lBlockSize = k_leaf_size; lBlockSize <= n; lBlockSize *= 2) {
+    if(k_leaf_size < lBlockSize) {
+      const uint64_t lHalf = lBlockSize / 2;
+      for(uint64_t lBegin = 0; lBegin < n; lBegin += lBlockSize) {
+        const uint64_t lMid = std::min<uint64_t>(n, lBegin + lHalf);
+        const uint64_t lEnd = std::min<uint64_t>(n, lBegin + lBlockSize);
+        std::merge(lCur.begin() + lBegin, lCur.begin() + lMid,
+                   lCur.begin() + lMid,   lCur.begin() + lEnd,
+                   lNxt.begin() + lBegin);
+      }
+      lCur.swap(lNxt);
+    }
+    _level.push_back(level_t());
+    level_t& lLevel = _level.back();
+    lLevel._rank.resize(n);
+    lLevel._cum.resize(n);
+    for(uint64_t lBegin = 0; lBegin < n; lBegin += lBlockSize) {
+      const uint64_t lEnd = std::min<uint64_t>(n, lBegin + lBlockSize);
+      uint32_t lCum = 0;
+      for(uint64_t i = lBegin; i < lEnd; ++i) {
+        lCum += (uint32_t) lCur[i];
+        lLevel._rank[i] = (uint32_t) (lCur[i] >> 32);
+        lLevel._cum[i]  = lCum;
+      }
+    }
+  }
+}
+
+uint
+RangeCount2dim::countBlock(const level_t& aLevel, const uint aBegin, const uint aEnd,
+                           const uint32_t aRankLo, const uint32_t aRankHi) const {
+  const uint32_t* lRank = aLevel._rank.data();
+  const uint lLo = std::lower_bound(lRank + aBegin, lRank + aEnd, aRankLo) - lRank;
+  const uint lHi = std::lower_bound(lRank + lLo,    lRank + aEnd, aRankHi) - lRank;
+  if(lLo == lHi) {
+    return 0;
+  }
+  const uint32_t lCumLo = (aBegin == lLo) ? 0 : aLevel._cum[lLo - 1];
+  return (aLevel._cum[lHi - 1] - lCumLo);
+}
+
+uint
+RangeCount2dim::countWithin(const rectangle_t& r) const {
+  if(!(r.xlo() < r.xhi() && r.ylo() < r.yhi())) {
+    return 0;
+  }
+  uint i0 = std::lower_bound(_x.begin(), _x.end(), r.xlo()) - _x.begin();
+  uint i1 = std::lower_bound(_x.begin() + i0, _x.end(), r.xhi()) - _x.begin();
+  const uint32_t lRankLo = std::lower_bound(_ys.begin(), _ys.end(), r.ylo()) - _ys.begin();
+  const uint32_t lRankHi = std::lower_bound(_ys.begin() + lRankLo, _ys.end(), r.yhi()) - _ys.begin();
+  if(i0 >= i1 || lRankLo >= lRankHi) {
+    return 0;
+  }
+
+  uint lRes = 0;
+  // scan up to the next leaf block boundaries
+  while(i0 < i1 && 0 != (i0 % k_leaf_size)) {
+    if(lRankLo <= _rank[i0] && _rank[i0] < lRankHi) {
+      lRes += _freq[i0];
+    }
+    ++i0;
+  }
+  while(i0 < i1 && 0 != (i1 % k_leaf_size)) {
+    --i1;
+    if(lRankLo <= _rank[i1] && _rank[i1] < lRankHi) {
+      lRes += _freq[i1];
+    }
+  }
+
+  // canonical decomposition of [i0,i1) into aligned blocks
+  uint l = 0;
+  uint lBlockSize = k_leaf_size;
+  while(i0 < i1) {
+    if(0 != ((i0 / lBlockSize) & 1)) {
+      lRes += countBlock(_level[l], i0, i0 + lBlockSize, lRankLo, lRankHi);
+      i0 += lBlockSize;
+    }
+    if(i0 < i1 && 0 != ((i1 / lBlockSize) & 1)) {
+      lRes += countBlock(_level[l], i1 - lBlockSize, i1, lRankLo, lRankHi);
+      i1 -= lBlockSize;
+    }
+    ++l;
+    lBlockSize *= 2;
+  }
+  return lRes;
+}
+
+size_t
+RangeCount2dim::size() const {
+  size_t lRes = _x.size() * (sizeof(double) + 2 * sizeof(uint32_t)) + _ys.size() * sizeof(double);
+  for(const auto& lLevel : _level) {
+    lRes += lLevel._rank.size() * 2 * sizeof(uint32_t);
+  }
+  return lRes;
+}
+
+} // end namespace
+
@@ -0,0 +1,58 @@
+#ifndef H2D_INFRA_RANGE_COUNT_2DIM_HH
+#define H2D_INFRA_RANGE_COUNT_2DIM_HH
+
+#include <iostream>
+#include <vector>
+#include <inttypes.h>
+
+#include "types.hh"
+
+namespace H2D {
+
+struct xyc_t;
+
+/*
+ * class RangeCount2dim
+ * static index for exact counts of weighted points within half-open
+ * rectangles [xlo,xhi) x [ylo,yhi).
+ * merge sort tree: points are sorted on x, y is replaced by its rank
+ * among the distinct y values. level k consists of blocks of 2^k
+ * consecutive points (in x order), each sorted on y-rank and carrying
+ * prefix sums of the frequencies.
+ * The lowest k_leaf_log levels are not materialized,
+ * blocks of that size are scanned instead.
+ * query: O(log^2 n), space: 8 * n * (log2(n) - k_leaf_log) bytes
+ */
+
+class RangeCount2dim {
+  public:
+    static constexpr uint k_leaf_log  = 5;
+    static constexpr uint k_leaf_size = (1 << k_leaf_log);
+  public:
+    RangeCount2dim(const std::vector<xyc_t>& aData);
+  public:
+    uint countWithin(const rectangle_t& aRectangle) const;
+  public:
+    inline uint   n() const { return _x.size(); }
+    inline uint   noLevel() const { return _level.size(); }
+           size_t size() const; // in bytes
+  private:
+    struct level_t {
+      std::vector<uint32_t> _rank; // y-rank, sorted within each block
+      std::vector<uint32_t> _cum;  // inclusive prefix sum of frequencies within each block
+      level_t() : _rank(), _cum() {}
+    };
+  private:
+    uint countBlock(const level_t& aLevel, const uint aBegin, const uint aEnd,
+                    const uint32_t aRankLo, const uint32_t aRankHi) const;
+  private:
+    std::vector<double>   _x;     // x values, sorted
+    std::vector<uint32_t> _rank;  // y-rank of point i (x order)
+    std::vector<uint32_t> _freq;  // frequency of point i (x order)
+    std::vector<double>   _ys;    // distinct y values, sorted
+    std::vector<level_t>  _level; // _level[l] has blocks of size 2^(l + k_leaf_log)
+};
+
+} // end namespace
+
+#endif
@@ -7,20 +7,30 @@ namespace H2D {
  * members for RegularPartitioning2dim
  */
 
-RegularPartitioning2dim::RegularPartitioning2dim() : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0) {}
+bool RegularPartitioning2dim::_useCum = true;
+
+RegularPartitioning2dim::RegularPartitioning2dim() : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0), _cum() {}
 
 RegularPartitioning2dim::RegularPartitioning2dim(const uint nx, const uint ny, const Data2dim& aData2dim) 
-                        : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0) {
+                        : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0), _cum() {
   initFromData2dim(nx, ny, aData2dim);
 }
 
 RegularPartitioning2dim::RegularPartitioning2dim(const rectangle_t& aRectangle,
                                                  const uint nx, const uint ny, 
                                                  const Data2dim& aData2dim) 
-                        : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0) {
+                        : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0), _cum() {
   initFromData2dim(aRectangle, nx, ny, aData2dim);
 }
 
+RegularPartitioning2dim::RegularPartitioning2dim(const rectangle_t& aRectangle,
+                                                 const uint nx, const uint ny, 
+                                                 const Data2dim& aData2dim,
+                                                 const uint aBegin, const uint aEnd) 
+                        : _descX(), _descY(), _vx(0), _vy(0), _m(), _total(0), _cum() {
+  initFromData2dim(aRectangle, nx, ny, aData2dim, aBegin, aEnd);
+}
+
 RegularPartitioning2dim::~RegularPartitioning2dim() {
   deleteVxy();
 }
@@ -34,6 +44,7 @@ RegularPartitioning2dim::allocVxy(const uint nx, const uint ny) {
   memset(_vx, 0, sizeof(uint) * nx);
   memset(_vy, 0, sizeof(uint) * ny);
   _m.rescale(nx, ny);
+  dropCum();
 }
 
 void
@@ -74,11 +85,12 @@ RegularPartitioning2dim::initPartitionDescXY(const Data2dim& aData,
 
 // _descX and _descY must have been set
 void
-RegularPartitioning2dim::initPartitioning(const uint nx, const uint ny, const Data2dim& aData2dim) {
+RegularPartitioning2dim::initPartitioning(const uint nx, const uint ny, const Data2dim& aData2dim,
+                                          const uint aBegin, const uint aEnd) {
   allocVxy(nx, ny);
   _total = 0;
 
-  for(uint i = 0; i < aData2dim.size(); ++i) {
+  for(uint i = aBegin; i < aEnd; ++i) {
     const xyc_t& e  = aData2dim[i];
     if(e.x < minX() || e.x >= maxX() || e.y < minY() || e.y >= maxY()) {
       continue;
@@ -163,18 +175,44 @@ RegularPartitioning2dim::initPartitioning(const Data2dim& aData,
 }
 
 
+void
+RegularPartitioning2dim::buildCum() {
+  dropCum();
+  if(!useCum() || (noRows() * noCols()) < k_cum_min_tiles) {
+    return;
+  }
+  const uint lRowSize = noCols() + 1;
+  _cum.assign((noRows() + 1) * lRowSize, 0.0);
+  for(uint i = 0; i < noRows(); ++i) {
+    double lRowSum = 0;
+    for(uint j = 0; j < noCols(); ++j) {
+      lRowSum += _m(i, j);
+      _cum[(i + 1) * lRowSize + (j + 1)] = _cum[i * lRowSize + (j + 1)] + lRowSum;
+    }
+  }
+}
+
 void
 RegularPartitioning2dim::initFromData2dim(const uint nx, const uint ny, const Data2dim& aData2dim) {
   initPartitionDescXY(nx, ny, aData2dim);
-  initPartitioning(nx, ny, aData2dim);
+  initPartitioning(nx, ny, aData2dim, 0, aData2dim.size());
+  buildCum();
 }
 
 void
 RegularPartitioning2dim::initFromData2dim(const rectangle_t& aRectangle,
                                           const uint nx, const uint ny, const Data2dim& aData2dim) {
+  initFromData2dim(aRectangle, nx, ny, aData2dim, 0, aData2dim.size());
+}
+
+void
+RegularPartitioning2dim::initFromData2dim(const rectangle_t& aRectangle,
+                                          const uint nx, const uint ny, const Data2dim& aData2dim,
+                                          const uint aBegin, const uint aEnd) {
   _descX.set(aRectangle.xlo(), aRectangle.xhi(), nx);
   _descY.set(aRectangle.ylo(), aRectangle.yhi(), ny);
-  initPartitioning(nx, ny, aData2dim);
+  initPartitioning(nx, ny, aData2dim, aBegin, aEnd);
+  buildCum();
 }
 
 void
@@ -185,6 +223,7 @@ RegularPartitioning2dim::initFromData2dim(const Data2dim& aData,
                                           const uint      aNy) {
   initPartitionDescXY(aData, aBegin, aEnd, aNx, aNy);
   initPartitioning(aData, aBegin, aEnd, aNx, aNy);
+  buildCum();
 }
 
 
@@ -197,6 +236,7 @@ RegularPartitioning2dim::initFromMatrix(const partitiondesc_t& aPdX,
   _descY = aPdY;
   _total = aTotal;
   _m     = aMatrix;
+  buildCum();
 };
 
 double
@@ -425,6 +465,14 @@ RegularPartitioning2dim::estimate(const query_t& lQuery) const {
     std::cout << "XYmin/max: " << lXmin << '-' << lXmax << '/' << lYmin << '-' << lYmax << std::endl;
   }
 
+  if(hasCum()) {
+    // a query starting on the max edge has no tile in x or y direction
+    if((lXmin > lXmax) || (lYmin > lYmax)) {
+      return 0.0;
+    }
+    return estimateCum(lRectangle, lXmin, lXmax, lYmin, lYmax);
+  }
+
   double lRes = 0.0;
   const double lTileArea = tileWidthX() * tileWidthY();
   rectangle_t lRectTile;
@@ -492,6 +540,14 @@ RegularPartitioning2dim::estimate(const rectangle_t& aRectangle) const {
     std::cout << "XYmin/max: " << lXmin << '-' << lXmax << '/' << lYmin << '-' << lYmax << std::endl;
   }
 
+  if(hasCum()) {
+    // a query starting on the max edge has no tile in x or y direction
+    if((lXmin > lXmax) || (lYmin > lYmax)) {
+      return 0.0;
+    }
+    return estimateCum(lRectangle, lXmin, lXmax, lYmin, lYmax);
+  }
+
   double lRes = 0.0;
   const double lTileArea = tileWidthX() * tileWidthY();
   rectangle_t lRectTile;
@@ -520,6 +576,133 @@ RegularPartitioning2dim::estimate(const rectangle_t& aRectangle) const {
   return lRes;
 }
 
+/*
+ * estimate_batch
+ * same arithmetic as estimate(rectangle_t), but the intersections of the
+ * query with the tile rows and columns are computed once per query
+ * instead of once per tile, the inner loop runs over a matrix row.
+ */
+
+void
+RegularPartitioning2dim::estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const {
+  const double lTileArea = tileWidthX() * tileWidthY();
+  const double* lM = matrix().data();
+  const uint    lNoCols = noCols();
+  std::vector<double> lWy(noCols()); // y-extent of intersection with tile column j
+  std::vector<bool>   lEy(noCols()); // intersection with tile column j is empty
+
+  for(size_t q = 0; q < aN; ++q) {
+    rectangle_t lRectangle = aBegin[q].rectangle();
+    aEstOut[q] = 0.0;
+    if(lRectangle.isEmpty()) {
+      continue;
+    }
+    if(lRectangle.xlo() < minX()) { lRectangle.xlo(minX()); }
+    if(lRectangle.ylo() < minY()) { lRectangle.ylo(minY()); }
+    if(lRectangle.xhi() > maxX()) { lRectangle.xhi(maxX()); }
+    if(lRectangle.yhi() > maxY()) { lRectangle.yhi(maxY()); }
+    if(lRectangle.isEmpty()) {
+      continue;
+    }
+
+    const uint lXmin = (uint) floor( (lRectangle.xlo() - minX()) / tileWidthX());
+    const uint lYmin = (uint) floor( (lRectangle.ylo() - minY()) / tileWidthY());
+    const uint lXmax = std::min<uint>(noRows() - 1, (uint) floor ( (lRectangle.xhi() - minX()) / tileWidthX()));
+    const uint lYmax = std::min<uint>(noCols() - 1, (uint) floor ( (lRectangle.yhi() - minY()) / tileWidthY()));
+    if(hasCum()) {
+      if((lXmin <= lXmax) && (lYmin <= lYmax)) {
+        aEstOut[q] = estimateCum(lRectangle, lXmin, lXmax, lYmin, lYmax);
+      }
+      continue;
+    }
+
+    double lTileLo = minY() + lYmin * tileWidthY();
+    double lTileHi = lTileLo + tileWidthY();
+    for(uint j = lYmin; j <= lYmax; ++j) {
+      const double lLo = std::max<double>(lRectangle.ylo(), lTileLo);
+      const double lHi = std::min<double>(lRectangle.yhi(), lTileHi);
+      lEy[j] = (lLo > lHi);
+      lWy[j] = (lHi - lLo);
+      lTileLo += tileWidthY();
+      lTileHi += tileWidthY();
+    }
+
+    double lRes = 0.0;
+    lTileLo = minX() + lXmin * tileWidthX();
+    lTileHi = lTileLo + tileWidthX();
+    for(uint i = lXmin; i <= lXmax; ++i) {
+      const double lLo = std::max<double>(lRectangle.xlo(), lTileLo);
+      const double lHi = std::min<double>(lRectangle.xhi(), lTileHi);
+      if(!(lLo > lHi)) {
+        const double  lWx  = (lHi - lLo);
+        const double* lRow = lM + i * lNoCols;
+        for(uint j = lYmin; j <= lYmax; ++j) {
+          if(!lEy[j]) {
+            lRes += ((lWx * lWy[j]) / lTileArea) * lRow[j];
+          }
+        }
+      }
+      lTileLo += tileWidthX();
+      lTileHi += tileWidthX();
+    }
+    aEstOut[q] = lRes;
+  }
+}
+
+/*
+ * estimateCum
+ * the query covers the tiles [aXmin,aXmax] x [aYmin,aYmax], the inner tiles
+ * (aXmin,aXmax) x (aYmin,aYmax) completely. with fx(i), fy(j) the covered
+ * fraction of tile column i, tile row j, the estimate
+ *   sum_{i,j} fx(i) * fy(j) * m(i,j)
+ * splits into the inner block, the border strips and the (up to) four
+ * corner tiles, all taken from _cum except for the corners.
+ */
+
+double
+RegularPartitioning2dim::estimateCum(const rectangle_t& aRectangle,
+                                     const uint aXmin, const uint aXmax,
+                                     const uint aYmin, const uint aYmax) const {
+  // border tiles: index and covered fraction, one border if min == max
+  uint   lIx[2] = { aXmin, aXmax };
+  uint   lIy[2] = { aYmin, aYmax };
+  double lFx[2];
+  double lFy[2];
+  const uint lNx = (aXmin < aXmax) ? 2 : 1;
+  const uint lNy = (aYmin < aYmax) ? 2 : 1;
+  for(uint k = 0; k < lNx; ++k) {
+    const double lTileLo = minX() + lIx[k] * tileWidthX();
+    const double lLo = std::max<double>(aRectangle.xlo(), lTileLo);
+    const double lHi = std::min<double>(aRectangle.xhi(), lTileLo + tileWidthX());
+    lFx[k] = std::max<double>(0.0, lHi - lLo) / tileWidthX();
+  }
+  for(uint k = 0; k < lNy; ++k) {
+    const double lTileLo = minY() + lIy[k] * tileWidthY();
+    const double lLo = std::max<double>(aRectangle.ylo(), lTileLo);
+    const double lHi = std::min<double>(aRectangle.yhi(), lTileLo + tileWidthY());
+    lFy[k] = std::max<double>(0.0, lHi - lLo) / tileWidthY();
+  }
+
+  const uint lInnerXbegin = aXmin + 1;
+  const uint lInnerXend   = std::max<uint>(lInnerXbegin, aXmax);
+  const uint lInnerYbegin = aYmin + 1;
+  const uint lInnerYend   = std::max<uint>(lInnerYbegin, aYmax);
+
+  double lRes = cum(lInnerXbegin, lInnerXend, lInnerYbegin, lInnerYend);
+  for(uint k = 0; k < lNx; ++k) {
+    lRes += lFx[k] * cum(lIx[k], lIx[k] + 1, lInnerYbegin, lInnerYend);
+  }
+  for(uint l = 0; l < lNy; ++l) {
+    lRes += lFy[l] * cum(lInnerXbegin, lInnerXend, lIy[l], lIy[l] + 1);
+  }
+  for(uint k = 0; k < lNx; ++k) {
+    for(uint l = 0; l < lNy; ++l) {
+      lRes += lFx[k] * lFy[l] * _m(lIx[k], lIy[l]);
+    }
+  }
+  return lRes;
+}
+
 double
 RegularPartitioning2dim::estimateIgnore(const rectangle_t& aRectangle, const double aEpsilon) const {
   const bool lTrace = false;
@@ -681,6 +864,7 @@ RegularPartitioning2dim::maxEntry() const {
 
 void
 RegularPartitioning2dim::shrink2(const uint m, const uint n) {
+  dropCum();
   for(uint i = 0; i < m; i += 2) {
     for(uint j = 0; j < n; j += 2) {
       _m(i >> 1, j >> 1) = _m(i,j) + _m(i,j+1) + _m(i+1,j) + _m(i+1,j+1);
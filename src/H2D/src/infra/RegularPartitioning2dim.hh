@@ -29,21 +29,35 @@ namespace H2D {
  * calculates the 2-dimensional regular partitioning
  * of a given Data2dim object with nx partitions in x-direction and
  * ny partitions in y-direction.
+ * init* additionally build a summed-area table _cum of the tile
+ * frequencies (if useCum() and the grid has at least k_cum_min_tiles
+ * tiles): estimate then sums the fully covered tiles in O(1) and only
+ * interpolates the partially covered border tiles.
+ * every non-const access to the tiles drops _cum.
  */
 
 class RegularPartitioning2dim : public EstimatorBase2dim {
   private:
     RegularPartitioning2dim(const RegularPartitioning2dim&);
     RegularPartitioning2dim& operator=(const RegularPartitioning2dim&);
+  public:
+    static constexpr uint k_cum_min_tiles = 256;
+    static inline bool useCum() { return _useCum; }
+    static inline void useCum(const bool x) { _useCum = x; }
   public:
     RegularPartitioning2dim();
     RegularPartitioning2dim(const uint nx, const uint ny, const Data2dim&);
     // in case a bounding rectangle is known, use
     RegularPartitioning2dim(const rectangle_t& aRectangle, const uint nx, const uint ny, const Data2dim&);
+    // same, for the points [aBegin, aEnd) only
+    RegularPartitioning2dim(const rectangle_t& aRectangle, const uint nx, const uint ny, const Data2dim&,
+                            const uint aBegin, const uint aEnd);
     ~RegularPartitioning2dim();
   public:
     void initFromData2dim(const uint nx, const uint ny, const Data2dim&);
     void initFromData2dim(const rectangle_t& aRectangle, const uint nx, const uint ny, const Data2dim&);
+    void initFromData2dim(const rectangle_t& aRectangle, const uint nx, const uint ny, const Data2dim&,
+                          const uint aBegin, const uint aEnd);
     void initFromData2dim(const Data2dim&, const uint aBegin, const uint aEnd, const uint nx, const uint ny);
   public:
     void initFromMatrix(const partitiondesc_t& aPdX,
@@ -98,8 +112,9 @@ class RegularPartitioning2dim : public EstimatorBase2dim {
            uint  noGtLimit(const uint aLimit) const;
            uint  noGtLimit(const uint aLimit, const uint aNxSub, const uint aNySub) const;
     inline uint  operator()(const uint i, const uint j) const { return (uint) _m(i,j); }
-    inline double& operator()(const uint i, const uint j) { return _m(i,j); }
-    inline void  set(const int i, const int j, const double x) { _m(i,j) = x; }
+    inline double& operator()(const uint i, const uint j) { dropCum(); return _m(i,j); }
+    inline void  set(const int i, const int j, const double x) { dropCum(); _m(i,j) = x; }
+    inline bool  hasCum() const { return (0 < _cum.size()); }
     inline void mkRectangle(const uint i, const uint j, rectangle_t& r) const {
                   partitiondescxy_t lPd(_descX, _descY);
                   lPd.getRectangle(i, j, r);
@@ -110,6 +125,7 @@ class RegularPartitioning2dim : public EstimatorBase2dim {
   public:
     virtual double estimate(const rectangle_t& r) const;
     virtual double estimate(const query_t& lQuery) const;
+    virtual void   estimate_batch(const query_t* aBegin, const size_t aN, double* aEstOut) const;
     // ignore tiles with only a small area in common with query rectangle
     double estimateIgnore(const rectangle_t& r, const double aEpsilon) const;
   public:
@@ -133,11 +149,22 @@ class RegularPartitioning2dim : public EstimatorBase2dim {
     void initPartitionDescXY(const uint nx, const uint ny, const Data2dim&);
     void initPartitionDescXY(const Data2dim&, const uint aBegin, const uint aEnd,
                                               const uint nx, const uint ny);
-    void initPartitioning(const uint nx, const uint ny, const Data2dim&);
+    void initPartitioning(const uint nx, const uint ny, const Data2dim&, const uint aBegin, const uint aEnd);
     void initPartitioning(const Data2dim&, const uint aBegin, const uint aEnd,
                                            const uint nx, const uint ny);
     void allocVxy(const uint nx, const uint ny);
     void deleteVxy();
+    void buildCum();
+    inline void dropCum() { _cum.clear(); }
+    // sum of tiles [aXbegin,aXend) x [aYbegin,aYend)
+    inline double cum(const uint aXbegin, const uint aXend, const uint aYbegin, const uint aYend) const {
+                    const uint lRowSize = noCols() + 1;
+                    return (  _cum[aXend   * lRowSize + aYend] - _cum[aXbegin * lRowSize + aYend]
+                            - _cum[aXend   * lRowSize + aYbegin] + _cum[aXbegin * lRowSize + aYbegin]);
+                  }
+    // estimate for a query rectangle clipped to the grid, touching tiles [aXmin,aXmax] x [aYmin,aYmax]
+    double estimateCum(const rectangle_t& aRectangle,
+                       const uint aXmin, const uint aXmax, const uint aYmin, const uint aYmax) const;
   private:
     partitiondesc_t _descX;
     partitiondesc_t _descY;
@@ -145,6 +172,9 @@ class RegularPartitioning2dim : public EstimatorBase2dim {
     uint*  _vy; // cumulated frequencies along y-axis, partitioned into ny equi width intervals
     Matrix _m;  // 2-dimensional regular partitioning of frequency
     uint   _total; // size of relation
+    std::vector<double> _cum; // (nx+1) x (ny+1) summed-area table of _m, empty if not built
+  private:
+    static bool _useCum;
 };
 
 
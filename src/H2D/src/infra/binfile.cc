@@ -0,0 +1,380 @@
+#include "binfile.hh"
+
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace H2D {
+
+/*
+ *  MappedFile members
+ */
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool
+MappedFile::open(const std::string& aFilename, const bool aSequential) {
+  close();
+  const int lFd = ::open(aFilename.c_str(), O_RDONLY);
+  if(0 > lFd) {
+    return false;
+  }
+  struct stat lStat;
+  if(0 != fstat(lFd, &lStat) || 0 == lStat.st_size) {
+    ::close(lFd);
+    return false;
+  }
+  void* lPtr = mmap(0, lStat.st_size, PROT_READ, MAP_PRIVATE, lFd, 0);
+  ::close(lFd);
+  if(MAP_FAILED == lPtr) {
+    return false;
+  }
+  madvise(lPtr, lStat.st_size, (aSequential ? MADV_SEQUENTIAL : MADV_WILLNEED));
+  _data = (const char*) lPtr;
+  _size = lStat.st_size;
+  return true;
+}
+
+void
+MappedFile::close() {
+  if(0 != _data) {
+    munmap((void*) _data, _size);
+  }
+  _data = 0;
+  _size = 0;
+}
+
+/*
+ *  column views
+ */
+
+static bool
+check_header(const MappedFile& aFile, const uint32_t aMagic, const size_t aRowSize, uint64_t& aNOut) {
+  if(sizeof(binfile_header_t) > aFile.size()) {
+    return false;
+  }
+  const binfile_header_t* lHeader = (const binfile_header_t*) aFile.data();
+  if(aMagic != lHeader->_magic || binfile_header_t::k_version != lHeader->_version) {
+    return false;
+  }
+  if(aFile.size() != sizeof(binfile_header_t) + lHeader->_n * aRowSize) {
+    return false;
+  }
+  aNOut = lHeader->_n;
+  return true;
+}
+
+bool
+BinHist::open(const std::string& aFilename) {
+  _n = 0;
+  if(!_file.open(aFilename)) {
+    return false;
+  }
+  const size_t lRowSize = 2 * sizeof(double) + sizeof(uint32_t);
+  if(!check_header(_file, binfile_header_t::k_magic_hist, lRowSize, _n)) {
+    _file.close();
+    return false;
+  }
+  const char* lBase = _file.data() + sizeof(binfile_header_t);
+  _x = (const double*) lBase;
+  _y = _x + _n;
+  _c = (const uint32_t*) (_y + _n);
+  return true;
+}
+
+bool
+BinQuery::open(const std::string& aFilename) {
+  _n = 0;
+  if(!_file.open(aFilename)) {
+    return false;
+  }
+  const size_t lRowSize = 2 * sizeof(uint32_t) + 4 * sizeof(double);
+  if(!check_header(_file, binfile_header_t::k_magic_query, lRowSize, _n)) {
+    _file.close();
+    return false;
+  }
+  const char* lBase = _file.data() + sizeof(binfile_header_t);
+  _no   = (const uint32_t*) lBase;
+  _card = _no + _n;
+  _xlo  = (const double*) (_card + _n);
+  _xhi  = _xlo + _n;
+  _ylo  = _xhi + _n;
+  _yhi  = _ylo + _n;
+  return true;
+}
+
+void
+BinQuery::get(const uint64_t i, query_t& aQueryOut) const {
+  aQueryOut._no   = _no[i];
+  aQueryOut._card = _card[i];
+  aQueryOut._rectangle = rectangle_t(_xlo[i], _ylo[i], _xhi[i], _yhi[i]);
+}
+
+/*
+ *  synopsis files
+ */
+
+void
+SynopsisWriter::addBytes(const void* aPtr, const size_t aSize) {
+  _section.push_back(std::string((const char*) aPtr, aSize));
+}
+
+void
+SynopsisWriter::add(const Data2dim& aData) {
+  const size_t n = aData.size();
+  std::vector<double>   lX(n);
+  std::vector<double>   lY(n);
+  std::vector<uint32_t> lC(n);
+  for(size_t i = 0; i < n; ++i) {
+    lX[i] = aData[i].x;
+    lY[i] = aData[i].y;
+    lC[i] = aData[i].c;
+  }
+  add(lX.data(), n);
+  add(lY.data(), n);
+  add(lC.data(), n);
+}
+
+bool
+SynopsisWriter::write(const std::string& aFilename) const {
+  if(synfile_header_t::k_max_section < _section.size()) {
+    std::cerr << "Too many sections for \'" << aFilename << "\'\n";
+    return false;
+  }
+  const uint64_t k_align = synfile_header_t::k_align;
+  synfile_header_t lHeader(_kind);
+  lHeader._noSection = _section.size();
+  uint64_t lOffset = ((sizeof(lHeader) + k_align - 1) / k_align) * k_align;
+  for(size_t i = 0; i < _section.size(); ++i) {
+    lHeader._offset[i] = lOffset;
+    lHeader._size[i]   = _section[i].size();
+    lOffset += ((_section[i].size() + k_align - 1) / k_align) * k_align;
+  }
+
+  std::error_code lEc;
+  const std::filesystem::path lDir = std::filesystem::path(aFilename).parent_path();
+  if(!lDir.empty()) {
+    std::filesystem::create_directories(lDir, lEc);
+  }
+  // write to a temporary and rename, readers never see a partial file
+  const std::string lTmp = aFilename + ".tmp";
+  {
+    std::ofstream os(lTmp, std::ios::binary | std::ios::trunc);
+    if(!os) {
+      std::cerr << "Could not open \'" << lTmp << "\'\n";
+      return false;
+    }
+    const char lPad[k_align] = {0};
+    os.write((const char*) &lHeader, sizeof(lHeader));
+    uint64_t lPos = sizeof(lHeader);
+    for(size_t i = 0; i < _section.size(); ++i) {
+      os.write(lPad, lHeader._offset[i] - lPos);
+      os.write(_section[i].data(), _section[i].size());
+      lPos = lHeader._offset[i] + _section[i].size();
+    }
+    os.write(lPad, lOffset - lPos);
+    if(!os) {
+      return false;
+    }
+  }
+  std::filesystem::rename(lTmp, aFilename, lEc);
+  return !lEc;
+}
+
+bool
+SynopsisFile::open(const std::string& aFilename, const uint32_t aKind) {
+  _header = 0;
+  if(!_file.open(aFilename, false)) {
+    return false;
+  }
+  const synfile_header_t* lHeader = (const synfile_header_t*) _file.data();
+  bool lOk = (sizeof(synfile_header_t) <= _file.size())
+          && (synfile_header_t::k_magic   == lHeader->_magic)
+          && (synfile_header_t::k_version == lHeader->_version)
+          && (aKind == lHeader->_kind)
+          && (synfile_header_t::k_max_section >= lHeader->_noSection);
+  for(uint i = 0; lOk && i < lHeader->_noSection; ++i) {
+    lOk = (0 == (lHeader->_offset[i] % synfile_header_t::k_align))
+       && (lHeader->_offset[i] <= _file.size())
+       && (lHeader->_size[i] <= _file.size() - lHeader->_offset[i]);
+  }
+  if(!lOk) {
+    _file.close();
+    return false;
+  }
+  _header = lHeader;
+  return true;
+}
+
+bool
+SynopsisFile::get(const uint aFirstSection, Data2dim& aDataOut) const {
+  size_t lNx = 0, lNy = 0, lNc = 0;
+  const double*   lX = array<double>(aFirstSection, lNx);
+  const double*   lY = array<double>(aFirstSection + 1, lNy);
+  const uint32_t* lC = array<uint32_t>(aFirstSection + 2, lNc);
+  if(0 == lX || 0 == lY || 0 == lC || lNx != lNy || lNx != lNc) {
+    return false;
+  }
+  for(size_t i = 0; i < lNx; ++i) {
+    aDataOut.push_back(lX[i], lY[i], lC[i]);
+  }
+  return true;
+}
+
+/*
+ *  reading and writing
+ */
+
+bool
+has_bin_sibling(const std::string& aFilename) {
+  const std::string lBin = bin_sibling(aFilename);
+  std::error_code lEc;
+  if(!std::filesystem::is_regular_file(lBin, lEc)) {
+    return false;
+  }
+  if(!std::filesystem::exists(aFilename, lEc)) {
+    return true;
+  }
+  // a stale binary file must not shadow its text file
+  return (std::filesystem::last_write_time(aFilename, lEc) <= std::filesystem::last_write_time(lBin, lEc));
+}
+
+template<typename T>
+static void
+write_column(std::ostream& os, const std::vector<T>& aColumn) {
+  os.write((const char*) aColumn.data(), aColumn.size() * sizeof(T));
+}
+
+bool
+write_hist_bin(const std::string& aFilename, const Data2dim& aData) {
+  const uint64_t n = aData.size();
+  std::vector<double>   lX(n);
+  std::vector<double>   lY(n);
+  std::vector<uint32_t> lC(n);
+  for(uint64_t i = 0; i < n; ++i) {
+    lX[i] = aData[i].x;
+    lY[i] = aData[i].y;
+    lC[i] = aData[i].c;
+  }
+  std::ofstream os(aFilename, std::ios::binary | std::ios::trunc);
+  if(!os) {
+    std::cerr << "Could not open \'" << aFilename << "\'\n";
+    return false;
+  }
+  const binfile_header_t lHeader(binfile_header_t::k_magic_hist, n);
+  os.write((const char*) &lHeader, sizeof(lHeader));
+  write_column(os, lX);
+  write_column(os, lY);
+  write_column(os, lC);
+  return (bool) os;
+}
+
+bool
+read_hist_bin(const std::string& aFilename, Data2dim& aDataOut, const size_t aLowLim) {
+  BinHist lBin;
+  if(!lBin.open(aFilename)) {
+    return false;
+  }
+  size_t lTotal = 0;
+  for(uint64_t i = 0; i < lBin.n(); ++i) {
+    aDataOut.push_back(lBin.x(i), lBin.y(i), lBin.c(i));
+    lTotal += lBin.c(i);
+    if(0 < aLowLim && aLowLim < lTotal) {
+      break;
+    }
+  }
+  return true;
+}
+
+bool
+write_query_bin(const std::string& aFilename, const query_vt& aQueries) {
+  const uint64_t n = aQueries.size();
+  std::vector<uint32_t> lNo(n);
+  std::vector<uint32_t> lCard(n);
+  std::vector<double>   lXlo(n);
+  std::vector<double>   lXhi(n);
+  std::vector<double>   lYlo(n);
+  std::vector<double>   lYhi(n);
+  for(uint64_t i = 0; i < n; ++i) {
+    const query_t& q = aQueries[i];
+    lNo[i]   = q.no();
+    lCard[i] = q.card();
+    lXlo[i]  = q.rectangle().xlo();
+    lXhi[i]  = q.rectangle().xhi();
+    lYlo[i]  = q.rectangle().ylo();
+    lYhi[i]  = q.rectangle().yhi();
+  }
+  std::ofstream os(aFilename, std::ios::binary | std::ios::trunc);
+  if(!os) {
+    std::cerr << "Could not open \'" << aFilename << "\'\n";
+    return false;
+  }
+  const binfile_header_t lHeader(binfile_header_t::k_magic_query, n);
+  os.write((const char*) &lHeader, sizeof(lHeader));
+  write_column(os, lNo);
+  write_column(os, lCard);
+  write_column(os, lXlo);
+  write_column(os, lXhi);
+  write_column(os, lYlo);
+  write_column(os, lYhi);
+  return (bool) os;
+}
+
+bool
+read_query_bin(const std::string& aFilename, query_vt& aQueriesOut, const size_t aMaxNo) {
+  BinQuery lBin;
+  if(!lBin.open(aFilename)) {
+    return false;
+  }
+  uint64_t n = lBin.n();
+  if(0 < aMaxNo && aMaxNo < n) {
+    n = aMaxNo;
+  }
+  aQueriesOut.resize(n);
+  for(uint64_t i = 0; i < n; ++i) {
+    lBin.get(i, aQueriesOut[i]);
+  }
+  return true;
+}
+
+bool
+read_query_text(const std::string& aFilename, query_vt& aQueriesOut, const size_t aMaxNo) {
+  std::ifstream lIs(aFilename);
+  if(!lIs) {
+    std::cout << "Can't open file '" << aFilename << "'." << std::endl;
+    return false;
+  }
+  query_t lQuery;
+  while(!lIs.eof()) {
+    lIs >> lQuery._no;
+    if(lIs.eof()) {
+      break;
+    }
+    lIs >> lQuery._card;
+    if(lIs.eof()) {
+      break;
+    }
+    if(lQuery._rectangle.read(lIs)) {
+      aQueriesOut.push_back(lQuery);
+      if(0 < aMaxNo && aQueriesOut.size() >= aMaxNo) {
+        break;
+      }
+    } else {
+      std::cout << "can't read rectangle number " << aQueriesOut.size()
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // end namespace
+
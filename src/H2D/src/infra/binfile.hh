@@ -0,0 +1,199 @@
+#ifndef HIST2DIM_BINFILE_HH
+#define HIST2DIM_BINFILE_HH
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <inttypes.h>
+
+#include "types.hh"
+#include "data2dim.hh"
+
+namespace H2D {
+
+/*
+ * binary columnar formats for .hist and .qu files
+ * layout (all little endian, native alignment):
+ *   .hist.bin: header, x[n] (double), y[n] (double), c[n] (uint32)
+ *   .qu*.bin : header, no[n] (uint32), card[n] (uint32),
+ *              xlo[n], xhi[n], ylo[n], yhi[n] (double)
+ * the binary sibling of file f is f + ".bin".
+ * it is only used if it is at least as new as f.
+ */
+
+struct binfile_header_t {
+  uint32_t _magic;   // k_magic_hist or k_magic_query
+  uint32_t _version; // k_version
+  uint64_t _n;       // number of rows
+
+  static constexpr uint32_t k_magic_hist  = 0x48443248; // "H2DH"
+  static constexpr uint32_t k_magic_query = 0x51443248; // "H2DQ"
+  static constexpr uint32_t k_version     = 1;
+
+  binfile_header_t() : _magic(0), _version(0), _n(0) {}
+  binfile_header_t(const uint32_t aMagic, const uint64_t aN) : _magic(aMagic), _version(k_version), _n(aN) {}
+};
+
+/*
+ * read-only memory mapping of a whole file
+ */
+
+class MappedFile {
+  public:
+    MappedFile() : _data(0), _size(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+  public:
+    // aSequential: advise a front to back scan, otherwise prefetch all
+    bool open(const std::string& aFilename, const bool aSequential = true);
+    void close();
+  public:
+    inline bool        isOpen() const { return (0 != _data); }
+    inline const char* data()   const { return _data; }
+    inline size_t      size()   const { return _size; }
+  private:
+    const char* _data;
+    size_t      _size;
+};
+
+/*
+ * zero-copy column views on a mapped .hist.bin/.qu.bin file
+ */
+
+class BinHist {
+  public:
+    BinHist() : _file(), _n(0), _x(0), _y(0), _c(0) {}
+    BinHist(const BinHist&) = delete;
+    BinHist& operator=(const BinHist&) = delete;
+  public:
+    bool open(const std::string& aFilename);
+  public:
+    inline uint64_t n() const { return _n; }
+    inline double   x(const uint64_t i) const { return _x[i]; }
+    inline double   y(const uint64_t i) const { return _y[i]; }
+    inline uint32_t c(const uint64_t i) const { return _c[i]; }
+  private:
+    MappedFile      _file;
+    uint64_t        _n;
+    const double*   _x;
+    const double*   _y;
+    const uint32_t* _c;
+};
+
+class BinQuery {
+  public:
+    BinQuery() : _file(), _n(0), _no(0), _card(0), _xlo(0), _xhi(0), _ylo(0), _yhi(0) {}
+    BinQuery(const BinQuery&) = delete;
+    BinQuery& operator=(const BinQuery&) = delete;
+  public:
+    bool open(const std::string& aFilename);
+  public:
+    inline uint64_t n() const { return _n; }
+    inline uint32_t no(const uint64_t i)   const { return _no[i]; }
+    inline uint32_t card(const uint64_t i) const { return _card[i]; }
+    inline double   xlo(const uint64_t i)  const { return _xlo[i]; }
+    inline double   xhi(const uint64_t i)  const { return _xhi[i]; }
+    inline double   ylo(const uint64_t i)  const { return _ylo[i]; }
+    inline double   yhi(const uint64_t i)  const { return _yhi[i]; }
+    void get(const uint64_t i, query_t& aQueryOut) const;
+  private:
+    MappedFile      _file;
+    uint64_t        _n;
+    const uint32_t* _no;
+    const uint32_t* _card;
+    const double*   _xlo;
+    const double*   _xhi;
+    const double*   _ylo;
+    const double*   _yhi;
+};
+
+/*
+ * synopsis files: estimators saved after construction
+ * layout: synfile_header_t, then up to k_max_section sections, each
+ * starting at a multiple of k_align bytes, such that arrays of plain
+ * structs can be used in place once the file is mapped.
+ * _kind is the H2D_kind_t of the estimator, section 0 is by convention
+ * an estimator specific info struct (parameters, statistics).
+ */
+
+struct synfile_header_t {
+  static constexpr uint32_t k_magic       = 0x53443248; // "H2DS"
+  static constexpr uint32_t k_version     = 1;
+  static constexpr uint32_t k_max_section = 16;
+  static constexpr uint64_t k_align       = 64;
+
+  uint32_t _magic;
+  uint32_t _version;
+  uint32_t _kind;
+  uint32_t _noSection;
+  uint64_t _offset[k_max_section]; // from the beginning of the file
+  uint64_t _size[k_max_section];   // in bytes
+
+  synfile_header_t() : _magic(0), _version(0), _kind(0), _noSection(0), _offset(), _size() {}
+  synfile_header_t(const uint32_t aKind) : _magic(k_magic), _version(k_version), _kind(aKind), _noSection(0), _offset(), _size() {}
+};
+
+class SynopsisWriter {
+  public:
+    SynopsisWriter(const uint32_t aKind) : _kind(aKind), _section() {}
+  public:
+    template<typename T>
+    inline void add(const T* aArr, const size_t aN) { addBytes(aArr, aN * sizeof(T)); }
+           void addBytes(const void* aPtr, const size_t aSize);
+           void add(const Data2dim& aData); // three sections: x, y, c
+    // creates missing directories
+    bool write(const std::string& aFilename) const;
+  private:
+    uint32_t                 _kind;
+    std::vector<std::string> _section;
+};
+
+class SynopsisFile {
+  public:
+    SynopsisFile() : _file(), _header(0) {}
+    SynopsisFile(const SynopsisFile&) = delete;
+    SynopsisFile& operator=(const SynopsisFile&) = delete;
+  public:
+    // fails if the file is missing, damaged, or not of kind aKind
+    bool open(const std::string& aFilename, const uint32_t aKind);
+  public:
+    inline uint        noSection() const { return _header->_noSection; }
+    inline const void* section(const uint i) const { return (_file.data() + _header->_offset[i]); }
+    inline size_t      sectionSize(const uint i) const { return _header->_size[i]; }
+    // array of aNOut structs in section i, 0 if the size does not fit
+    template<typename T>
+    inline const T*    array(const uint i, size_t& aNOut) const;
+    // inverse of SynopsisWriter::add(const Data2dim&)
+    bool get(const uint aFirstSection, Data2dim& aDataOut) const;
+  private:
+    MappedFile              _file;
+    const synfile_header_t* _header;
+};
+
+template<typename T>
+const T*
+SynopsisFile::array(const uint i, size_t& aNOut) const {
+  aNOut = 0;
+  if(i >= noSection() || 0 != (sectionSize(i) % sizeof(T))) {
+    return 0;
+  }
+  aNOut = sectionSize(i) / sizeof(T);
+  return (const T*) section(i);
+}
+
+inline std::string bin_sibling(const std::string& aFilename) { return aFilename + ".bin"; }
+bool has_bin_sibling(const std::string& aFilename);
+
+bool write_hist_bin(const std::string& aFilename, const Data2dim& aData);
+bool read_hist_bin(const std::string& aFilename, Data2dim& aDataOut, const size_t aLowLim = 0);
+
+// aMaxNo = 0: read all queries
+bool write_query_bin(const std::string& aFilename, const query_vt& aQueries);
+bool read_query_bin(const std::string& aFilename, query_vt& aQueriesOut, const size_t aMaxNo = 0);
+bool read_query_text(const std::string& aFilename, query_vt& aQueriesOut, const size_t aMaxNo = 0);
+
+} // end namespace
+
+
+#endif
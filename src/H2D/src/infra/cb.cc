@@ -5,7 +5,9 @@ namespace H2D {
 
 Cb::Cb() : _filename(), _isHistFile(false), 
            _no_query(0), _filename_query(),
-           _sds(), _ds(),_inDir(),_outDir(),_trainQDir(),_testQDir(),
+           _batchCount(false), _verifyQuery(false), _noThreads(1), _noBuildThreads(1), _latency(false), _queryOrder(0), _queryOrderCmp(0),
+           _noSweepThreads(1),
+           _sds(), _ds(),_inDir(),_outDir(),_trainQDir(),_testQDir(),_synopsisDir(),_manifest(),
            _nx(0), _ny(0), 
            _rx(5), _ry(5), 
            _fieldWidth(4), 
@@ -74,6 +76,12 @@ Cb::Cb() : _filename(), _isHistFile(false),
            _xgb(false),
            _xgb_num_trees(100),
            _xgb_num_train_queries(10000),
+           _xgb_dump_libsvm(false),
+           _xgb_full_precision(false),
+           _xgb_check(false),
+           _xgb_model(),
+           _xgb_codegen(),
+           _xgb_codegen_name("XgbCompiledModel"),
            _exgb(false),
            _lwxgb(false),
 	   _nxgb(false),
@@ -92,6 +100,14 @@ Cb::filename_query(const std::string& x) {
   _filename_query = x;
 }
 
+std::string
+Cb::xgb_model_file() const {
+  if(0 < xgb_model().size()) {
+    return xgb_model();
+  }
+  return (outDir() + "/" + sds() + "/" + ds() + "_exgb_model.json");
+}
+
 } // end namespace
 
 
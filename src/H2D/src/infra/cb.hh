@@ -26,12 +26,38 @@ class Cb {
     inline const std::string& filename_query() const { return _filename_query; }
            void filename_query(const std::string&);
 
+    inline bool batchCount() const { return _batchCount; }
+    inline void batchCount(const bool& x) { _batchCount = x; }
+
+    inline bool verifyQuery() const { return _verifyQuery; }
+    inline void verifyQuery(const bool& x) { _verifyQuery = x; }
+
+    inline uint noThreads() const { return _noThreads; }
+    inline void noThreads(const uint& x) { _noThreads = x; }
+
+    inline uint noBuildThreads() const { return _noBuildThreads; }
+    inline void noBuildThreads(const uint& x) { _noBuildThreads = x; }
+
+    inline bool latency() const { return _latency; }
+    inline void latency(const bool& x) { _latency = x; }
+
+    inline uint queryOrder() const { return _queryOrder; }
+    inline void queryOrder(const uint& x) { _queryOrder = x; }
+
+    inline uint queryOrderCmp() const { return _queryOrderCmp; }
+    inline void queryOrderCmp(const uint& x) { _queryOrderCmp = x; }
+
+    inline uint noSweepThreads() const { return _noSweepThreads; }
+    inline void noSweepThreads(const uint& x) { _noSweepThreads = x; }
+
     inline const std::string& sds() const { return _sds; }
     inline const std::string& ds()  const { return _ds; }
     inline const std::string& inDir() const {return _inDir;}
     inline const std::string& outDir() const {return _outDir;}
     inline const std::string& trainQDir() const {return _trainQDir;}
     inline const std::string& testQDir() const {return _testQDir;}
+    inline const std::string& synopsisDir() const {return _synopsisDir;}
+    inline const std::string& manifest() const {return _manifest;}
 
     inline void sds(const std::string& aSDS) { _sds = aSDS; }
     inline void ds(const std::string&  aDS ) { _ds  = aDS;  }
@@ -39,6 +65,8 @@ class Cb {
     inline void outDir(const std::string& outDir ) {_outDir = outDir;}
     inline void trainQDir(const std::string& trainQDir ) {_trainQDir = trainQDir;}
     inline void testQDir(const std::string& testQDir ) {_testQDir = testQDir;}
+    inline void synopsisDir(const std::string& synopsisDir ) {_synopsisDir = synopsisDir;}
+    inline void manifest(const std::string& manifest ) {_manifest = manifest;}
 
 
 
@@ -194,6 +222,26 @@ class Cb {
     inline uint xgb_num_train_queries() const { return _xgb_num_train_queries; }
     inline void xgb_num_train_queries(const uint& x) { _xgb_num_train_queries = x; }
 
+    inline bool xgb_dump_libsvm() const { return _xgb_dump_libsvm; }
+    inline void xgb_dump_libsvm(const bool& x) { _xgb_dump_libsvm = x; }
+
+    inline bool xgb_full_precision() const { return _xgb_full_precision; }
+    inline void xgb_full_precision(const bool& x) { _xgb_full_precision = x; }
+
+    inline bool xgb_check() const { return _xgb_check; }
+    inline void xgb_check(const bool& x) { _xgb_check = x; }
+
+    // saved booster, empty: <outDir>/<sds>/<ds>_exgb_model.json
+    inline const std::string& xgb_model() const { return _xgb_model; }
+    inline void xgb_model(const std::string& x) { _xgb_model = x; }
+           std::string xgb_model_file() const;
+
+    inline const std::string& xgb_codegen() const { return _xgb_codegen; }
+    inline void xgb_codegen(const std::string& x) { _xgb_codegen = x; }
+
+    inline const std::string& xgb_codegen_name() const { return _xgb_codegen_name; }
+    inline void xgb_codegen_name(const std::string& x) { _xgb_codegen_name = x; }
+
 
     inline bool gridtree() const { return _gridtree; }
     inline void gridtree(const bool& x) { _gridtree = x; }
@@ -302,12 +350,22 @@ class Cb {
     bool        _isHistFile; // x, y, count (hist file) vs. x, y (value (only) file)
     uint        _no_query; // number of queries to generate (main_gen_query)
     std::string _filename_query; // filename to write queries to
+    bool        _batchCount;     // main_gen_query: count all generated queries in one sweep
+    bool        _verifyQuery;    // main_gen_query: recount the cardinalities of an existing query file
+    uint        _noThreads;      // number of threads evaluating the test queries (<= 1: serial)
+    uint        _noBuildThreads; // number of threads building a GxTree (<= 1: serial)
+    bool        _latency;        // record per query latencies of estimate (main_queryset_estimates)
+    uint        _queryOrder;     // order of estimating the test queries: 0 file, 1 z-curve, 2 Hilbert curve
+    uint        _queryOrderCmp;  // rounds timing file order against _queryOrder (0: ordered run only)
+    uint        _noSweepThreads; // number of threads running the tasks of main_sweep
     std::string _sds;            // name of set of data sets (directory name)
     std::string _ds;             // name of data set (filename without suffix .hist)
     std::string _inDir;
     std::string _outDir;
     std::string _trainQDir;
     std::string _testQDir;
+    std::string _synopsisDir;    // saved estimators (QTS, GxTree), empty: always build
+    std::string _manifest;       // data sets and estimators to run (main_sweep)
     uint        _nx; // number of partitions in x direction
     uint        _ny; // number of partitions in y direction
     uint        _rx; // number of subpartitionings in x direction, e.g., for EqDepth
@@ -378,6 +436,12 @@ class Cb {
     bool        _xgb;        // XGBoost  
     uint	_xgb_num_trees;//num of XGBoost trees
     uint	_xgb_num_train_queries;//_xgb_num_train_queries
+    bool        _xgb_dump_libsvm; // debug: additionally write the feature matrices as libsvm files
+    bool        _xgb_full_precision; // xgb features and labels as float instead of rounded like the libsvm text files
+    bool        _xgb_check;        // debug: compare native and XGBoost predictions of the trained model
+    std::string _xgb_model;        // saved booster (main_xgb_codegen, main_xgb_bench)
+    std::string _xgb_codegen;      // header generated by main_xgb_codegen
+    std::string _xgb_codegen_name; // name of the generated model struct
     bool        _exgb; // enriched XGboost
     bool        _lwxgb; // enriched ebo minsel avi XGboost
     bool        _nxgb; //enriched xgb with QTS1D selectivities
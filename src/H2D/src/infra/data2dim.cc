@@ -1,4 +1,5 @@
 #include "data2dim.hh"
+#include "fenwick_tt.hh"
 
 namespace H2D {
 
@@ -34,9 +35,11 @@ operator<<(std::ostream& os, const xy_t& x) {
 }
 
 
-Data2dim::Data2dim(const Data2dim& aData) : _data(aData._data),_colX(),_colY() {}
+bool Data2dim::_useIndex = true;
 
-Data2dim::Data2dim(const Data2dim& aData, const rectangle_t& aRectangle) : _data(),_colX(),_colY() {
+Data2dim::Data2dim(const Data2dim& aData) : _data(aData._data),_colX(),_colY(),_index(0),_noScan(0) {}
+
+Data2dim::Data2dim(const Data2dim& aData, const rectangle_t& aRectangle) : _data(),_colX(),_colY(),_index(0),_noScan(0) {
   init();
   for(xyc_vt::const_iterator lIter = aData._data.begin(); lIter != aData._data.end(); ++lIter) {
     if(aRectangle.containsHalfOpen((*lIter).x, (*lIter).y)) {
@@ -49,8 +52,16 @@ Data2dim::Data2dim(const Data2dim& aData, const rectangle_t& aRectangle) : _data
   fin();
 }
 
+Data2dim::~Data2dim() {
+  delete _index.load();
+}
+
 Data2dim&
 Data2dim::operator=(const Data2dim& aData) {
+  if(this == &aData) {
+    return (*this);
+  }
+  dropIndex();
   _data = aData._data;
   _colX = aData._colX;
   _colY = aData._colY;
@@ -104,19 +115,21 @@ Data2dim::readValueFile(const std::string& aFileName, const size_t aLowLim) {
 
 Data2dim&
 Data2dim::push_back(const xyc_t& x) {
+  dropIndex();
   _data.push_back(x);
   return (*this);
 }
 
 Data2dim&
 Data2dim::push_back(const double x, const double y, const uint c) {
+  dropIndex();
   _data.push_back(xyc_t(x,y,c));
   return (*this);
 }
 
 void
 Data2dim::init() {
-  _data.clear();
+  clear();
 }
 
 void
@@ -280,6 +293,40 @@ for(uint i = 0; i < size(); ++i) {
 /////////////
 uint
 Data2dim::countWithin(const rectangle_t& aRectangle) const {
+  const RangeCount2dim* lIndex = index();
+  if(0 == lIndex && _useIndex && k_index_min_size <= size()) {
+    if(k_index_min_scan <= _noScan.fetch_add(1, std::memory_order_relaxed)) {
+      lIndex = buildIndex();
+    }
+  }
+  if(0 != lIndex) {
+    return lIndex->countWithin(aRectangle);
+  }
+  return countWithinScan(aRectangle);
+}
+
+const RangeCount2dim*
+Data2dim::index() const {
+  return _index.load(std::memory_order_acquire);
+}
+
+// concurrent callers may build the index twice, only one survives
+const RangeCount2dim*
+Data2dim::buildIndex() const {
+  const RangeCount2dim* lIndex = index();
+  if(0 != lIndex) {
+    return lIndex;
+  }
+  const RangeCount2dim* lNew = new RangeCount2dim(_data);
+  if(_index.compare_exchange_strong(lIndex, lNew, std::memory_order_acq_rel)) {
+    return lNew;
+  }
+  delete lNew;
+  return lIndex;
+}
+
+uint
+Data2dim::countWithinScan(const rectangle_t& aRectangle) const {
   uint lRes = 0;
   for(uint i = 0; i < size(); ++i) {
     if(aRectangle.containsHalfOpen(_data[i].x, _data[i].y)) {
@@ -289,10 +336,105 @@ Data2dim::countWithin(const rectangle_t& aRectangle) const {
   return lRes;
 }
 
+void
+Data2dim::countWithin(const query_t* aBegin, const size_t aN, uint* aCountOut) const {
+  const RangeCount2dim* lIndex = index();
+  if(0 == lIndex && _useIndex && k_index_min_size <= size() && k_index_min_scan <= aN) {
+    lIndex = buildIndex();
+  }
+  if(0 != lIndex) {
+    for(size_t i = 0; i < aN; ++i) {
+      aCountOut[i] = lIndex->countWithin(aBegin[i].rectangle());
+    }
+    return;
+  }
+  const uint lBlockSize = 512; // 12 KB of points
+  for(size_t i = 0; i < aN; ++i) {
+    aCountOut[i] = 0;
+  }
+  for(uint lBegin = 0; lBegin < size(); lBegin += lBlockSize) {
+    const uint lEnd = std::min<uint>(size(), lBegin + lBlockSize);
+    for(size_t i = 0; i < aN; ++i) {
+      const rectangle_t& r = aBegin[i].rectangle();
+      uint lRes = 0;
+      for(uint j = lBegin; j < lEnd; ++j) {
+        if(r.containsHalfOpen(_data[j].x, _data[j].y)) {
+          lRes += _data[j].c;
+        }
+      }
+      aCountOut[i] += lRes;
+    }
+  }
+}
+
+void
+Data2dim::countWithinBatch(query_vt& aQueries) const {
+  // y-ranks
+  std::vector<double> lYs(size());
+  for(uint i = 0; i < size(); ++i) {
+    lYs[i] = _data[i].y;
+  }
+  std::sort(lYs.begin(), lYs.end());
+  lYs.erase(std::unique(lYs.begin(), lYs.end()), lYs.end());
+
+  // points in x order
+  struct sweeppoint_t {
+    double   _x;
+    uint32_t _rank;
+    uint32_t _c;
+  };
+  std::vector<sweeppoint_t> lPoints(size());
+  for(uint i = 0; i < size(); ++i) {
+    const xyc_t& p = _data[i];
+    lPoints[i]._x    = p.x;
+    lPoints[i]._rank = std::lower_bound(lYs.begin(), lYs.end(), p.y) - lYs.begin();
+    lPoints[i]._c    = p.c;
+  }
+  std::sort(lPoints.begin(), lPoints.end(), [] (const sweeppoint_t& a, const sweeppoint_t& b) { return (a._x < b._x); });
+
+  // events: card = F(xhi) - F(xlo), F(X) = count of points with x < X and y in [ylo,yhi)
+  struct event_t {
+    double   _x;
+    uint32_t _idx; // index of query
+    bool     _hi;  // event at xhi (add) or at xlo (subtract)
+  };
+  std::vector<event_t>  lEvents;
+  std::vector<uint32_t> lRankLo(aQueries.size());
+  std::vector<uint32_t> lRankHi(aQueries.size());
+  std::vector<int64_t>  lCard(aQueries.size(), 0);
+  lEvents.reserve(2 * aQueries.size());
+  for(uint i = 0; i < aQueries.size(); ++i) {
+    const rectangle_t& r = aQueries[i].rectangle();
+    if(!(r.xlo() < r.xhi() && r.ylo() < r.yhi())) {
+      continue;
+    }
+    lRankLo[i] = std::lower_bound(lYs.begin(), lYs.end(), r.ylo()) - lYs.begin();
+    lRankHi[i] = std::lower_bound(lYs.begin(), lYs.end(), r.yhi()) - lYs.begin();
+    lEvents.push_back({r.xlo(), i, false});
+    lEvents.push_back({r.xhi(), i, true});
+  }
+  std::sort(lEvents.begin(), lEvents.end(), [] (const event_t& a, const event_t& b) { return (a._x < b._x); });
+
+  Fenwick_TT<int64_t> lFenwick(lYs.size());
+  uint p = 0;
+  for(const event_t& e : lEvents) {
+    while(p < lPoints.size() && lPoints[p]._x < e._x) {
+      lFenwick.add(lPoints[p]._rank, lPoints[p]._c);
+      ++p;
+    }
+    const int64_t lCount = lFenwick.range(lRankLo[e._idx], lRankHi[e._idx]);
+    lCard[e._idx] += (e._hi ? lCount : -lCount);
+  }
+
+  for(uint i = 0; i < aQueries.size(); ++i) {
+    aQueries[i]._card = (uint32_t) lCard[i];
+  }
+}
+
 void
 Data2dim::split(Data2dim& aRegular, Data2dim& aOutlier, const uint aPhi) const {
-  aRegular._data.clear();
-  aOutlier._data.clear();
+  aRegular.clear();
+  aOutlier.clear();
   for(uint i = 0; i < size(); ++i) {
     const xyc_t& x = (*this)[i];
     if(aPhi >= x.c) {
@@ -305,8 +447,8 @@ Data2dim::split(Data2dim& aRegular, Data2dim& aOutlier, const uint aPhi) const {
 
 void
 Data2dim::splitX(Data2dim& aLeft, Data2dim& aRight, const double aValue) const {
-  aLeft._data.clear();
-  aRight._data.clear();
+  aLeft.clear();
+  aRight.clear();
   for(uint i = 0; i < size(); ++i) {
     const xyc_t& p = (*this)[i];
     if(p.x <= aValue) {
@@ -320,8 +462,8 @@ Data2dim::splitX(Data2dim& aLeft, Data2dim& aRight, const double aValue) const {
 
 void
 Data2dim::splitY(Data2dim& aLeft, Data2dim& aRight, const double aValue) const {
-  aLeft._data.clear();
-  aRight._data.clear();
+  aLeft.clear();
+  aRight.clear();
   for(uint i = 0; i < size(); ++i) {
     const xyc_t& p = (*this)[i];
     if(p.y <= aValue) {
@@ -788,7 +930,7 @@ Data2dim::variance(const uint aBegin, const uint aEnd) const {
  
   lVarianceX.init(); 
   lVarianceY.init(); 
-  for(uint i = 0; i < aEnd; ++i) {
+  for(uint i = aBegin; i < aEnd; ++i) {
     const xyc_t& p = _data[i];
     lVarianceX.step(p.x);
     lVarianceY.step(p.y);
@@ -805,7 +947,7 @@ Data2dim::sse(const uint aBegin, const uint aEnd) const {
  
   lVarianceX.init(); 
   lVarianceY.init(); 
-  for(uint i = 0; i < aEnd; ++i) {
+  for(uint i = aBegin; i < aEnd; ++i) {
     const xyc_t& p = _data[i];
     lVarianceX.step(p.x);
     lVarianceY.step(p.y);
@@ -924,6 +1066,48 @@ Data2dim::partitionY(Data2dim& aData0, Data2dim& aData1, const double aBoundary)
   }
 }
 
+// american flag sort on the tile number (nx*ny: outside the grid).
+// the tile of a point is calculated once for counting and once when
+// the point is moved to its final position.
+void
+Data2dim::partitionTiles(const partitiondescxy_t& aPd, const uint aBegin, const uint aEnd,
+                         uint* aTileBeginOut) {
+  dropIndex();
+  const uint lNx = (uint) aPd.pdX().anz();
+  const uint lNy = (uint) aPd.pdY().anz();
+  const uint lNoTiles = lNx * lNy;
+  const auto lTileOf = [&aPd, lNx, lNy, lNoTiles] (const xyc_t& p) {
+    const uint lIdxX = aPd.idxXcorrected(p.x);
+    const uint lIdxY = aPd.idxYcorrected(p.y);
+    return ((lIdxX < lNx && lIdxY < lNy) ? (lIdxX * lNy + lIdxY) : lNoTiles);
+  };
+
+  std::vector<uint> lNext(lNoTiles + 1, 0);
+  for(uint k = aBegin; k < aEnd; ++k) {
+    ++lNext[lTileOf(_data[k])];
+  }
+  uint lPos = aBegin;
+  for(uint t = 0; t <= lNoTiles; ++t) {
+    const uint lCount = lNext[t];
+    aTileBeginOut[t] = lNext[t] = lPos;
+    lPos += lCount;
+  }
+
+  // once tiles 0..nx*ny-1 are filled, the rest is outside the grid
+  for(uint t = 0; t < lNoTiles; ++t) {
+    const uint lTileEnd = aTileBeginOut[t + 1];
+    while(lNext[t] < lTileEnd) {
+      xyc_t lCur  = _data[lNext[t]];
+      uint  lTile = lTileOf(lCur);
+      while(lTile != t) {
+        std::swap(lCur, _data[lNext[lTile]++]);
+        lTile = lTileOf(lCur);
+      }
+      _data[lNext[t]++] = lCur;
+    }
+  }
+}
+
 
 
 /*
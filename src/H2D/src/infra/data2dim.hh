@@ -6,12 +6,14 @@
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include <assert.h>
 
 #include "../../../infra/aggregate.hh"
 #include "../../../infra/variance.hh"
 
 #include "types.hh"
+#include "RangeCount2dim.hh"
 
 namespace H2D {
 
@@ -64,15 +66,16 @@ class Data2dim {
     class LessX { public: inline bool operator()(const xyc_t& a, const xyc_t& b) const { return (a.x < b.x); } };
     class LessY { public: inline bool operator()(const xyc_t& a, const xyc_t& b) const { return (a.y < b.y); } };
   public:
-    Data2dim() : _data(),_colX(),_colY() {}
+    Data2dim() : _data(),_colX(),_colY(),_index(0),_noScan(0) {}
     Data2dim(const Data2dim&);
     Data2dim(const Data2dim& aData, const rectangle_t& aRectangle);
+    ~Data2dim();
   public:
     void init();
     void step(const double& x, const double& y, const uint& c);
     void fin();
   public:
-    inline void clear() { _data.clear(); }
+    inline void clear() { _data.clear(); dropIndex(); }
     void fillCols(Data2dim& aData);
     inline std::vector<double> getColX() const {return _colX;}
     inline std::vector<double> getColY() const {return _colY;}
@@ -93,6 +96,12 @@ class Data2dim {
     bool partition3x3(Data2dim lPartition[3][3], uint lCumFreq[3][3]) const; // returns false if bounding rectangle has area 0
     void partitionX(Data2dim&, Data2dim&, const double aBoundary) const;
     void partitionY(Data2dim&, Data2dim&, const double aBoundary) const;
+    // in place (unstable): permutes [aBegin, aEnd) such that the points of
+    // tile (i,j) of aPd (idxXcorrected, idxYcorrected) are in
+    // [aTileBeginOut[i*ny+j], aTileBeginOut[i*ny+j+1]), the points outside
+    // the grid in [aTileBeginOut[nx*ny], aEnd). aTileBeginOut: nx*ny+1 entries
+    void partitionTiles(const partitiondescxy_t& aPd, const uint aBegin, const uint aEnd,
+                        uint* aTileBeginOut);
   public:
     // must be sorted on either x or y
     inline double spreadX(const uint i) const { return (_data[i+1].x - _data[i].x); }
@@ -101,7 +110,25 @@ class Data2dim {
     inline double areaY  (const uint i) const { return (_data[i].c * spreadY(i)); }
   public:
     uint countWithin(const rectangle_t& aRectangle) const; // number of points in rectangle
+    uint countWithinScan(const rectangle_t& aRectangle) const; // same, by linear scan
+    // exact cardinalities of all queries (overwrites _card),
+    // one sweep over x with a Fenwick tree on y-ranks: O((n + q) log n)
+    void countWithinBatch(query_vt& aQueries) const;
+    // aCountOut[i] = countWithin(aBegin[i].rectangle()) for i < aN,
+    // uses the index if it pays off, otherwise scans the points in
+    // cache sized blocks against all queries
+    void countWithin(const query_t* aBegin, const size_t aN, uint* aCountOut) const;
     uint countLine(const line_t& aLine, int dim) const;
+  public:
+    // countWithin switches to a RangeCount2dim index once it has been
+    // called k_index_min_scan times on at least k_index_min_size points.
+    // The index is dropped by every non-const access to the data.
+    static constexpr uint k_index_min_size = 1024;
+    static constexpr uint k_index_min_scan = 32;
+    static inline bool useIndex() { return _useIndex; }
+    static inline void useIndex(const bool x) { _useIndex = x; }
+    const RangeCount2dim* index() const; // nullptr if not (yet) built
+    const RangeCount2dim* buildIndex() const;
   public:
     void split(Data2dim& aRegular, Data2dim& aOutlier, const uint aPhi) const;
     // all points with p.x <= aValue in left, others in right
@@ -144,31 +171,44 @@ class Data2dim {
   public:
     uint size() const { return _data.size(); }
     const xyc_t& operator[](const uint i) const { return _data[i]; }
-          xyc_t& operator[](const uint i)       { return _data[i]; }
+          xyc_t& operator[](const uint i)       { dropIndex(); return _data[i]; }
     const xyc_t& last() const { return _data[_data.size() - 1]; }
     Data2dim& push_back(const xyc_t&);
     Data2dim& push_back(const double, const double, const uint c = 1);
     inline void swap(uint i, uint j) { std::swap<xyc_t>(_data[i], _data[j]); }
+    inline void reserve(const size_t n) { _data.reserve(n); }
   public:
     Data2dim& operator=(const Data2dim&);
   public:
     inline xyc_vt::iterator beginIter() {
+      dropIndex();
       return _data.begin();
     }
     inline xyc_vt::const_iterator beginIter() const {
       return _data.begin();
     }
     inline xyc_vt::iterator endIter() {
+      dropIndex();
       return _data.end();
     }
     inline xyc_vt::const_iterator endIter() const {
       return _data.end();
     }
 
+  private:
+    inline void dropIndex() {
+                  if(0 != _index.load(std::memory_order_relaxed)) {
+                    delete _index.exchange(0);
+                  }
+                  _noScan.store(0, std::memory_order_relaxed);
+                }
   private:
     xyc_vt _data;
     std::vector<double> _colX;
     std::vector<double> _colY;
+    mutable std::atomic<const RangeCount2dim*> _index;  // built lazily by countWithin
+    mutable std::atomic<uint>                  _noScan; // number of scans done by countWithin
+    static  bool                               _useIndex;
 };
 
 
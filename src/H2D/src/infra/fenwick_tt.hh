@@ -0,0 +1,39 @@
+#ifndef INFRA_FENWICK_TT_HH
+#define INFRA_FENWICK_TT_HH
+
+#include <inttypes.h>
+#include <vector>
+
+/*
+ * Fenwick_TT
+ * Fenwick tree (binary indexed tree) over positions 0 .. n-1
+ * add:    point update in O(log n)
+ * prefix: sum over positions [0,i) in O(log n)
+ */
+
+template<typename Tval>
+class Fenwick_TT {
+  public:
+    Fenwick_TT(const uint32_t n) : _tree(n + 1, 0) {}
+  public:
+    inline uint32_t n() const { return (_tree.size() - 1); }
+    inline void add(uint32_t i, const Tval aVal) {
+                  for(++i; i < _tree.size(); i += (i & (-i))) {
+                    _tree[i] += aVal;
+                  }
+                }
+    inline Tval prefix(uint32_t i) const {
+                  Tval lRes = 0;
+                  for(; 0 < i; i -= (i & (-i))) {
+                    lRes += _tree[i];
+                  }
+                  return lRes;
+                }
+    inline Tval range(const uint32_t aBegin, const uint32_t aEnd) const {
+                  return (prefix(aEnd) - prefix(aBegin));
+                }
+  private:
+    std::vector<Tval> _tree;
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <inttypes.h>
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 
 
 /*
@@ -15,6 +17,10 @@
  * CAUTION:
  * the interpreter might read/write one byte more than necessary
  * the written parts remain unchanged.
+ * getRow* and sumDecompressed decode the tiles (x,yBegin) .. (x,yEnd-1),
+ * which are consecutive in _grid, from one 64 bit word (getRowBits)
+ * instead of two byte loads per tile. the word is read from within
+ * the NoBytes bytes of the grid.
  */
 
 
@@ -52,6 +58,18 @@ struct Grid_TT {
 
   inline uint noChildren() const; // counts number of cells with iBit set
 
+  // the tiles (x,y), (x,y+1), .. (x,Tgrid-1), (x,y) in the lowest Tbits bits
+  inline uint64_t getRowBits(const uint32_t x, const uint32_t y) const;
+  // aOut[k] = get(x, yBegin + k), k < yEnd - yBegin
+  inline void   getRow(const uint32_t x, const uint32_t yBegin, const uint32_t yEnd, uint32_t* aOut) const;
+  // aOut[k] = aTable[get(x, yBegin + k)], aTable the decompression table of a scale
+  inline void   getRowDecompressed(const uint32_t x, const uint32_t yBegin, const uint32_t yEnd,
+                                   const double* aTable, double* aOut) const;
+  // sum of aTable[get(i,j)] over [xBegin,xEnd) x [yBegin,yEnd), in the order of a loop over get
+  inline double sumDecompressed(const uint32_t xBegin, const uint32_t xEnd,
+                                const uint32_t yBegin, const uint32_t yEnd,
+                                const double* aTable) const;
+
   std::ostream& print(std::ostream& os) const;
 };
 
@@ -109,6 +127,69 @@ Grid_TT<Tgrid,Tbits>::noChildren() const {
   return lRes;
 }
 
+// little endian, as get
+template<uint32_t Tgrid, uint32_t Tbits>
+uint64_t
+Grid_TT<Tgrid,Tbits>::getRowBits(const uint32_t x, const uint32_t y) const {
+  static_assert(7 + Tgrid * Tbits <= 64, "a row and the shift must fit into a word");
+  const uint32_t lTileIdx = tileIdx(x,y);
+  const uint32_t lByteIdx = byteIdx(lTileIdx);
+  uint64_t lWord = 0;
+  if(8 <= NoBytes) {
+    // the row ends within the grid: the 8 bytes ending with the grid hold it
+    const uint32_t lBegin = std::min<uint32_t>(lByteIdx, NoBytes - 8);
+    memcpy(&lWord, _grid + lBegin, 8);
+    return (lWord >> (8 * (lByteIdx - lBegin) + shift(lTileIdx)));
+  }
+  // small grid: assembled in a register, a partial copy into lWord would
+  // be stored and reloaded
+  if(4 <= NoBytes) {
+    uint32_t lLo, lHi;
+    memcpy(&lLo, _grid, 4);
+    memcpy(&lHi, _grid + NoBytes - 4, 4);
+    lWord = (lLo | ((uint64_t) lHi << ((8 * (NoBytes - 4)) & 0x3F)));
+  } else {
+    for(uint32_t k = 0; k < NoBytes; ++k) {
+      lWord |= ((uint64_t) _grid[k] << (8 * k));
+    }
+  }
+  return (lWord >> (Tbits * lTileIdx));
+}
+
+template<uint32_t Tgrid, uint32_t Tbits>
+void
+Grid_TT<Tgrid,Tbits>::getRow(const uint32_t x, const uint32_t yBegin, const uint32_t yEnd, uint32_t* aOut) const {
+  const uint64_t lBits = getRowBits(x, yBegin);
+  for(uint32_t k = 0; k < yEnd - yBegin; ++k) {
+    aOut[k] = (lBits >> (Tbits * k)) & Mask;
+  }
+}
+
+template<uint32_t Tgrid, uint32_t Tbits>
+void
+Grid_TT<Tgrid,Tbits>::getRowDecompressed(const uint32_t x, const uint32_t yBegin, const uint32_t yEnd,
+                                         const double* aTable, double* aOut) const {
+  const uint64_t lBits = getRowBits(x, yBegin);
+  for(uint32_t k = 0; k < yEnd - yBegin; ++k) {
+    aOut[k] = aTable[(lBits >> (Tbits * k)) & Mask];
+  }
+}
+
+template<uint32_t Tgrid, uint32_t Tbits>
+double
+Grid_TT<Tgrid,Tbits>::sumDecompressed(const uint32_t xBegin, const uint32_t xEnd,
+                                      const uint32_t yBegin, const uint32_t yEnd,
+                                      const double* aTable) const {
+  double lSum = 0;
+  for(uint32_t x = xBegin; x < xEnd; ++x) {
+    const uint64_t lBits = getRowBits(x, yBegin);
+    for(uint32_t k = 0; k < yEnd - yBegin; ++k) {
+      lSum += aTable[(lBits >> (Tbits * k)) & Mask];
+    }
+  }
+  return lSum;
+}
+
 template<uint32_t Tgrid, uint32_t Tbits>
 std::ostream&
 Grid_TT<Tgrid,Tbits>::print(std::ostream& os) const {
@@ -0,0 +1,142 @@
+#ifndef INFRA_VITTER_D_TT_HH
+#define INFRA_VITTER_D_TT_HH
+
+#include <inttypes.h>
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+/*
+ * vitter_d_tt
+ * sequential random sampling without replacement:
+ * selects n of the records 0 .. N-1, each subset with equal probability,
+ * and calls aEmit(i) for the selected records in increasing order.
+ * Method D of J.S. Vitter, An efficient algorithm for sequential random
+ * sampling, ACM TOMS 13(1), 1987: O(n) expected random numbers and time,
+ * O(1) space. switches to Method A once n >= N/13 (alpha = 1/13).
+ */
+
+template<class Trng>
+inline double
+vitter_u01_tt(Trng& aRng) { // [0,1)
+  return std::uniform_real_distribution<double>(0.0, 1.0)(aRng);
+}
+
+template<class Trng>
+inline double
+vitter_u_tt(Trng& aRng) { // (0,1], argument of log
+  return (1.0 - vitter_u01_tt(aRng));
+}
+
+template<class Trng, class Temit>
+void
+vitter_a_tt(int64_t N, int64_t n, Trng& aRng, Temit& aEmit, int64_t aCur) {
+  double  lNreal = (double) N;
+  int64_t lTop   = N - n;
+  while(2 <= n) {
+    const double V = vitter_u01_tt(aRng);
+    int64_t S = 0;
+    double lQuot = lTop / lNreal;
+    while(lQuot > V) {
+      ++S;
+      --lTop;
+      lNreal -= 1.0;
+      lQuot = (lQuot * lTop) / lNreal;
+    }
+    aCur += S;
+    aEmit(aCur);
+    ++aCur;
+    lNreal -= 1.0;
+    --n;
+  }
+  if(1 == n) {
+    const int64_t S = (int64_t) (std::round(lNreal) * vitter_u01_tt(aRng));
+    aEmit(aCur + S);
+  }
+}
+
+template<class Trng, class Temit>
+void
+vitter_d_tt(int64_t N, int64_t n, Trng& aRng, Temit& aEmit) {
+  if(0 >= n) {
+    return;
+  }
+  if(n >= N) {
+    for(int64_t i = 0; i < N; ++i) {
+      aEmit(i);
+    }
+    return;
+  }
+  const int64_t lAlphaInv = 13;
+  int64_t lCur      = 0;
+  double  lNreal    = (double) N;
+  double  lnreal    = (double) n;
+  double  lNinv     = 1.0 / lnreal;
+  double  lVprime   = std::exp(std::log(vitter_u_tt(aRng)) * lNinv);
+  int64_t lQu1      = N - n + 1;
+  double  lQu1real  = lNreal - lnreal + 1.0;
+  int64_t lThreshold = lAlphaInv * n;
+  while(1 < n && lThreshold < N) {
+    const double lNmin1inv = 1.0 / (lnreal - 1.0);
+    int64_t S = 0;
+    while(true) {
+      double X = 0;
+      while(true) {
+        X = lNreal * (1.0 - lVprime);
+        S = (int64_t) X;
+        if(S < lQu1) {
+          break;
+        }
+        lVprime = std::exp(std::log(vitter_u_tt(aRng)) * lNinv);
+      }
+      const double U  = vitter_u_tt(aRng);
+      const double lNegSreal = (double) -S;
+      const double y1 = std::exp(std::log(U * lNreal / lQu1real) * lNmin1inv);
+      lVprime = y1 * (1.0 - X / lNreal) * (lQu1real / (lNegSreal + lQu1real));
+      if(1.0 >= lVprime) {
+        break; // accept S
+      }
+      double  y2 = 1.0;
+      double  lTop = lNreal - 1.0;
+      double  lBottom = 0;
+      int64_t lLimit = 0;
+      if((n - 1) > S) {
+        lBottom = lNreal - lnreal;
+        lLimit  = N - S;
+      } else {
+        lBottom = lNreal + lNegSreal - 1.0;
+        lLimit  = lQu1;
+      }
+      for(int64_t t = N - 1; t >= lLimit; --t) {
+        y2 = (y2 * lTop) / lBottom;
+        lTop    -= 1.0;
+        lBottom -= 1.0;
+      }
+      if((lNreal / (lNreal - X)) >= (y1 * std::exp(std::log(y2) * lNmin1inv))) {
+        lVprime = std::exp(std::log(vitter_u_tt(aRng)) * lNmin1inv);
+        break; // accept S
+      }
+      lVprime = std::exp(std::log(vitter_u_tt(aRng)) * lNinv);
+    }
+    // skip S records, select the next one
+    lCur += S;
+    aEmit(lCur);
+    ++lCur;
+    N        = N - S - 1;
+    lNreal   = lNreal - (double) S - 1.0;
+    --n;
+    lnreal  -= 1.0;
+    lNinv    = lNmin1inv;
+    lQu1    -= S;
+    lQu1real -= (double) S;
+    lThreshold -= lAlphaInv;
+  }
+  if(1 < n) {
+    vitter_a_tt(N, n, aRng, aEmit, lCur);
+  } else {
+    const int64_t S = std::min<int64_t>(N - 1, (int64_t) (N * lVprime));
+    aEmit(lCur + S);
+  }
+}
+
+#endif
@@ -17,6 +17,14 @@ construct_arg_desc(argdesc_vt& x) {
 
   x.push_back(new uarg_t("--no-query", 100, &Cb::no_query, "number of queries to generate") );
   x.push_back(new sarg_t("--file-query", "", &Cb::filename_query, "file name for generated queries") );
+  x.push_back(new barg_t("--batch", false, &Cb::batchCount, "count generated queries in one sweep (main_gen_query)") );
+  x.push_back(new barg_t("--verify-query", false, &Cb::verifyQuery, "recheck cardinalities of query file given by --file-query") );
+  x.push_back(new uarg_t("--threads", 1, &Cb::noThreads, "number of threads evaluating the test queries") );
+  x.push_back(new uarg_t("--build-threads", 1, &Cb::noBuildThreads, "number of threads building a GxTree") );
+  x.push_back(new barg_t("--latency", false, &Cb::latency, "print per query latency quantiles of estimate") );
+  x.push_back(new uarg_t("--query-order", 0, &Cb::queryOrder, "estimate test queries in 0: file, 1: z-curve, 2: Hilbert order of their centers") );
+  x.push_back(new uarg_t("--query-order-cmp", 0, &Cb::queryOrderCmp, "with --query-order: rounds timing file vs. scheduled order (0: no file order run)") );
+  x.push_back(new uarg_t("--sweep-threads", 1, &Cb::noSweepThreads, "number of threads running the tasks of main_sweep") );
 
   x.push_back(new sarg_t("--sds", "", &Cb::sds, "name of set of data sets (directory name)"));
   x.push_back(new sarg_t("--ds",  "", &Cb::ds,  "name of data set (file name without suffix .hist)"));
@@ -24,6 +32,8 @@ construct_arg_desc(argdesc_vt& x) {
   x.push_back(new sarg_t("--outDir",  "", &Cb::outDir,  "Dir path for output results and XGB models"));
   x.push_back(new sarg_t("--trainQDir",  "", &Cb::trainQDir,  "Dir path for .qu_t100k training queries"));
   x.push_back(new sarg_t("--testQDir",  "", &Cb::testQDir,  "Dir path for .qu_a tst queries"));
+  x.push_back(new sarg_t("--synopsisDir",  "", &Cb::synopsisDir,  "Dir path for saved QTS/GxTree synopses (reused if present)"));
+  x.push_back(new sarg_t("--manifest",  "", &Cb::manifest,  "file with the data sets and estimators to run (main_sweep)"));
 
   x.push_back( new uarg_t("--dim", 0, &Cb::dim, "dim for NR partition, 0:x and 1:y") );
   x.push_back( new uarg_t("--nx", 11, &Cb::nx, "number of partitions in x-direction") );
@@ -84,6 +94,12 @@ construct_arg_desc(argdesc_vt& x) {
 
   x.push_back( new uarg_t("--xgb-num-trees", 500,&Cb::xgb_num_trees,"number of trees for xb"));
   x.push_back( new uarg_t("--xgb-num-train-queries", 20000,&Cb::xgb_num_train_queries,"number of queries to be taken for training xgb"));
+  x.push_back( new barg_t("--xgb-dump-libsvm", false, &Cb::xgb_dump_libsvm, "debug: write xgb train/eval/test features as libsvm files"));
+  x.push_back( new barg_t("--xgb-full-precision", false, &Cb::xgb_full_precision, "xgb features and labels in float precision (default: 6 digits as the former libsvm files)"));
+  x.push_back( new barg_t("--xgb-check", false, &Cb::xgb_check, "debug: check native against XGBoost predictions of the trained xgb model"));
+  x.push_back( new sarg_t("--xgb-model", "", &Cb::xgb_model, "saved xgb model (default: <outDir>/<sds>/<ds>_exgb_model.json)"));
+  x.push_back( new sarg_t("--xgb-codegen", "", &Cb::xgb_codegen, "header file generated by main_xgb_codegen"));
+  x.push_back( new sarg_t("--xgb-codegen-name", "XgbCompiledModel", &Cb::xgb_codegen_name, "name of the struct generated by main_xgb_codegen"));
 
   x.push_back( new barg_t("--gta", false, &Cb::gridtree, "GridTree") );
 
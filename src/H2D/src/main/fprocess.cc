@@ -22,6 +22,7 @@ fRunQuery(const H2D::Data2dim& aData,
 
   if(aCb.gxtree()) {
       const bool lCheckEncoding = true;
+      H2D::GxTree::noBuildThreads(aCb.noBuildThreads());
       lGxt = new H2D::GxTree(aData, (H2D::GxTree::gx_kind_t) aCb.kind(), aCb.budget(),
                      aCb.leafRefinement(), aCb.lrf(),
                      aCb.minimumNodeTotal(),
@@ -541,6 +542,7 @@ fProcessGxTree(const H2D::Data2dim& aData,
 
   Measure lMeasureT;
   Measure lMeasureE;
+  H2D::GxTree::noBuildThreads(aCb.noBuildThreads());
   lMeasureE.start();
   lMeasureT.start();
   H2D::GxTree lGxt(aData, (H2D::GxTree::gx_kind_t) aCb.kind(), aCb.budget(), 
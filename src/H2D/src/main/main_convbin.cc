@@ -0,0 +1,94 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include <string>
+#include <vector>
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+#include "infra/data2dim.hh"
+#include "infra/binfile.hh"
+
+extern "C" {
+  #include "infra/cmeasure.h"
+}
+
+#include "arg.hh"
+
+/*
+ *  convert text files into their binary siblings (<file>.bin)
+ *  --file <f>.hist        data file (histogram format, use with --hist)
+ *  --file <f>             data file (value format)
+ *  --file-query <f>.qu*   query file
+ *  both may be given at once.
+ */
+
+bool
+convert_data(const H2D::Cb& aCb) {
+  H2D::Data2dim lData;
+  if(aCb.isHistFile()) {
+    lData.readHistFile(aCb.filename());
+  } else {
+    lData.readValueFile(aCb.filename());
+  }
+  if(0 == lData.size()) {
+    std::cerr << "no data read from '" << aCb.filename() << "'." << std::endl;
+    return false;
+  }
+  const std::string lFilenameOut = H2D::bin_sibling(aCb.filename());
+  if(!H2D::write_hist_bin(lFilenameOut, lData)) {
+    return false;
+  }
+  std::cout << "# " << lFilenameOut << ": " << lData.size() << " rows" << std::endl;
+  return true;
+}
+
+bool
+convert_query(const H2D::Cb& aCb) {
+  H2D::query_vt lQueries;
+  if(!H2D::read_query_text(aCb.filename_query(), lQueries) || 0 == lQueries.size()) {
+    std::cerr << "no queries read from '" << aCb.filename_query() << "'." << std::endl;
+    return false;
+  }
+  const std::string lFilenameOut = H2D::bin_sibling(aCb.filename_query());
+  if(!H2D::write_query_bin(lFilenameOut, lQueries)) {
+    return false;
+  }
+  std::cout << "# " << lFilenameOut << ": " << lQueries.size() << " rows" << std::endl;
+  return true;
+}
+
+int
+main(const int argc, const char* argv[]) {
+  H2D::Cb lCb;
+  argdesc_vt lArgDesc;
+  construct_arg_desc(lArgDesc);
+
+  if(!parse_args<H2D::Cb>(1, argc, argv, lArgDesc, lCb)) {
+    std::cerr << "error while parsing arguments." << std::endl;
+    return -1;
+  }
+  if(lCb.help()) {
+    print_usage(std::cout, argv[0], lArgDesc);
+    return 0;
+  }
+  if(0 == lCb.filename().size() && 0 == lCb.filename_query().size()) {
+    std::cerr << "neither --file nor --file-query given." << std::endl;
+    return -1;
+  }
+
+  cmeasure_t lMeas;
+  cmeasure_start(&lMeas);
+  bool lOk = true;
+  if(0 < lCb.filename().size()) {
+    lOk = convert_data(lCb) && lOk;
+  }
+  if(0 < lCb.filename_query().size()) {
+    lOk = convert_query(lCb) && lOk;
+  }
+  cmeasure_stop(&lMeas);
+  std::cout << "# total   runtime = " << cmeasure_total_s(&lMeas) << " [s]" << std::endl;
+  return (lOk ? 0 : -1);
+}
+
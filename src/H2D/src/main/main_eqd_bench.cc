@@ -0,0 +1,190 @@
+#include <iostream>
+#include <iomanip>
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+#include "infra/data2dim.hh"
+#include "infra/binfile.hh"
+#include "infra/CrystalClock.hh"
+#include "EquiDepthHist/EqDepHist.hh"
+#include "OneDEqDepHist/OneDEqDepHist.hh"
+
+#include "arg.hh"
+
+/*
+ *  per query cycles of the bucket lookup of EqDepHist (k_simple) and
+ *  OneDEqDepHist, linear scan over the buckets (as formerly done by
+ *  estimateIntervals, estimateIntervalsX) vs. binary search with prefix
+ *  sums, for 64 .. 4096 buckets on one data set
+ *  (<inDir>/<sds>/<ds>.hist) and its test queries (<testQDir>/<sds>/<ds>.qu_a).
+ */
+
+// former EqDepHist::estimateY, one bucket after the other
+double
+scan_eqd_y(const H2D::rectangle_t& aRecQuery, const H2D::EqDepHist::entry_vt& aVy, const double aXlo, const double aXhi) {
+  double lRes = 0.0;
+  H2D::rectangle_t lRecIsec;
+  H2D::rectangle_t lRecTile;
+  lRecTile.xlo(aXlo);
+  lRecTile.xhi(aXhi);
+  for(uint j = 0; j < aVy.size(); ++j) {
+    const H2D::EqDepHist::entry_t& e = aVy[j];
+    if(e.hi() <= aRecQuery.ylo()) {
+      continue;
+    }
+    if(aRecQuery.yhi() <= e.lo()) {
+      break;
+    }
+    lRecTile.ylo(e.lo());
+    lRecTile.yhi(e.hi());
+    if(aRecQuery.contains(lRecTile)) {
+      lRes += (double) e.cf();
+    } else
+    if(e.lo() < e.hi() && aXlo < aXhi) {
+      lRecIsec.isec(aRecQuery, lRecTile);
+      lRes += (lRecIsec.area() / lRecTile.area()) * e.cf();
+    } else
+    if(e.lo() >= e.hi()) {
+      const double lXIsecLo = std::max<double>(aRecQuery.xlo(), aXlo);
+      const double lXIsecHi = std::min<double>(aRecQuery.xhi(), aXhi);
+      lRes += ((lXIsecHi - lXIsecLo) / (aXhi - aXlo)) * e.cf();
+    } else
+    if(aXlo >= aXhi) {
+      const double lYIsecLo = std::max<double>(aRecQuery.ylo(), e.lo());
+      const double lYIsecHi = std::min<double>(aRecQuery.yhi(), e.hi());
+      lRes += ((lYIsecHi - lYIsecLo) / (e.hi() - e.lo())) * e.cf();
+    }
+  }
+  return lRes;
+}
+
+double
+scan_eqd(const H2D::rectangle_t& r, const H2D::EqDepHist& aHist) {
+  double lRes = 0.0;
+  for(uint i = 0; i < aHist.vx().size(); ++i) {
+    const H2D::EqDepHist::entry_t& e = aHist.vx()[i];
+    if(e.hi() <= r.xlo()) {
+      continue;
+    }
+    if(r.xhi() <= e.lo()) {
+      break;
+    }
+    lRes += scan_eqd_y(r, aHist.vy()[i], e.lo(), e.hi());
+  }
+  return lRes;
+}
+
+// former OneDEqDepHist::estimateIntervalsX
+double
+scan_oned(const H2D::rectangle_t& r, const H2D::OneDEqDepHist& aHist, const uint aTotal) {
+  uint lower = 0;
+  uint upper = aHist.vx().size();
+  for(uint i = 0; i < aHist.vx().size(); ++i) {
+    if(aHist.vx()[i].hi() <= r.xlo()) {
+      lower = i;
+      continue;
+    }
+    if(r.xhi() <= aHist.vx()[i].lo()) {
+      upper = i;
+      break;
+    }
+  }
+  return (upper - lower) * (aTotal / aHist.nx());
+}
+
+void
+report(const char* aName, const uint aNoBuckets, const uint64_t aCycles, const uint aNoQueries) {
+  const double lCyclesPerQuery = (double) aCycles / (double) aNoQueries;
+  std::cout << std::setw(8) << aName << ' '
+            << std::setw(10) << aNoBuckets << ' '
+            << std::setw(10) << aNoQueries << ' '
+            << std::setw(12) << std::fixed << std::setprecision(1) << lCyclesPerQuery << ' '
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << (lCyclesPerQuery * 1.0e9 / CrystalClock::frequency())
+            << std::endl;
+}
+
+int
+main(const int argc, const char* argv[]) {
+  H2D::Cb lCb;
+  argdesc_vt lArgDesc;
+  construct_arg_desc(lArgDesc);
+
+  if(!parse_args<H2D::Cb>(1, argc, argv, lArgDesc, lCb)) {
+    std::cerr << "error while parsing arguments." << std::endl;
+    return -1;
+  }
+  if(lCb.help()) {
+    print_usage(std::cout, argv[0], lArgDesc);
+    return 0;
+  }
+
+  const std::string lFilenameData  = lCb.inDir() + '/' + lCb.sds() + '/' + lCb.ds() + ".hist";
+  const std::string lFilenameQuery = lCb.testQDir() + '/' + lCb.sds() + '/' + lCb.ds() + ".qu_a";
+  H2D::Data2dim lData;
+  if(!(H2D::has_bin_sibling(lFilenameData) && H2D::read_hist_bin(H2D::bin_sibling(lFilenameData), lData))) {
+    lData.readHistFile(lFilenameData);
+  }
+  H2D::query_vt lQueries;
+  if(!(H2D::has_bin_sibling(lFilenameQuery) && H2D::read_query_bin(H2D::bin_sibling(lFilenameQuery), lQueries))) {
+    lQueries.clear();
+    H2D::read_query_text(lFilenameQuery, lQueries);
+  }
+  if(0 == lData.size() || 0 == lQueries.size()) {
+    std::cerr << "Can't read '" << lFilenameData << "' or '" << lFilenameQuery << "'." << std::endl;
+    return -1;
+  }
+  CrystalClock::init();
+
+  std::cout << "# " << std::setw(6) << "method" << ' '
+            << std::setw(10) << "#buckets" << ' '
+            << std::setw(10) << "#queries" << ' '
+            << std::setw(12) << "cycles/query" << ' '
+            << std::setw(12) << "ns/query" << std::endl;
+
+  const uint lNoQueries = lQueries.size();
+  const uint lTotal     = lData.total();
+  std::vector<double> lRef(lNoQueries);
+  for(uint n = 8; n <= 64; n *= 2) {
+    // 2-dim: n x n buckets, no outliers
+    const H2D::EqDepHist lEqd(lData, H2D::EqDepHist::k_simple, n, n, 0, 0, 0, 2, 100, false);
+    uint64_t lBegin = CrystalClock::current();
+    for(uint i = 0; i < lNoQueries; ++i) {
+      lRef[i] = scan_eqd(lQueries[i].rectangle(), lEqd);
+    }
+    uint64_t lEnd = CrystalClock::current();
+    report("eqd-scan", n * n, CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+    double lMaxRelDiff = 0;
+    lBegin = CrystalClock::current();
+    for(uint i = 0; i < lNoQueries; ++i) {
+      const double lEst = lEqd.estimateIntervals(lQueries[i].rectangle());
+      lMaxRelDiff = std::max<double>(lMaxRelDiff, std::fabs(lEst - lRef[i]) / std::max<double>(1.0, lRef[i]));
+    }
+    lEnd = CrystalClock::current();
+    report("eqd-bs", n * n, CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+    std::cout << "# eqd: max rel diff to scan " << std::scientific << lMaxRelDiff << std::endl;
+
+    // 1-dim: n * n buckets per dimension
+    const H2D::OneDEqDepHist lOneD(lData, 0, 2, 100, n * n, false);
+    lBegin = CrystalClock::current();
+    for(uint i = 0; i < lNoQueries; ++i) {
+      lRef[i] = scan_oned(lQueries[i].rectangle(), lOneD, lTotal);
+    }
+    lEnd = CrystalClock::current();
+    report("1d-scan", n * n, CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+    uint lNoDiff = 0;
+    lBegin = CrystalClock::current();
+    for(uint i = 0; i < lNoQueries; ++i) {
+      lNoDiff += (lRef[i] != lOneD.estimateIntervalsX(lQueries[i].rectangle()));
+    }
+    lEnd = CrystalClock::current();
+    report("1d-bs", n * n, CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+    std::cout << "# 1d: differs from scan for " << lNoDiff << " queries" << std::endl;
+  }
+  return 0;
+}
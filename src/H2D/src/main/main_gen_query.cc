@@ -5,10 +5,13 @@
 #include <string>
 #include <vector>
 #include <random>
+#include <cmath>
+#include <algorithm>
 
 #include "infra/types.hh"
 #include "infra/cb.hh"
 #include "infra/data2dim.hh"
+#include "infra/binfile.hh"
 
 extern "C" {
   #include "infra/cmeasure.h"
@@ -53,6 +56,127 @@ generate_query(std::ostream& os, const H2D::Data2dim& aData, const H2D::Cb& aCb)
   }
 }
 
+// same queries as generate_query,
+// but candidates are counted in rounds by Data2dim::countWithinBatch
+void
+generate_query_batch(std::ostream& os, const H2D::Data2dim& aData, const H2D::Cb& aCb) {
+  rng32_t lRng;
+  std::uniform_int_distribution<uint>    lIntDist(0, aData.size() - 1);
+  std::uniform_real_distribution<double> lDubDist(0, 0.1);
+
+  H2D::rectangle_t lBr; // bounding rectangle of all data points
+  aData.getBoundingRectangle(lBr);
+
+  H2D::query_vt lCand;
+  double f = 0;
+  for(uint i = 0; i < aCb.no_query();) {
+    const uint lNoMissing = aCb.no_query() - i;
+    lCand.resize(lNoMissing + (lNoMissing / 8) + 16);
+    for(auto& lQuery : lCand) {
+      H2D::rectangle_t& lQr = lQuery._rectangle;
+      const uint lTupleNo = lIntDist(lRng);
+      const H2D::xyc_t& t = aData[lTupleNo];
+      f = lDubDist(lRng);
+      lQr.xlo(t.x + f * (lBr.xlo() - t.x));
+      f = lDubDist(lRng);
+      lQr.xhi(t.x + f * (lBr.xhi() - t.x));
+      f = lDubDist(lRng);
+      lQr.ylo(t.y + f * (lBr.ylo() - t.y));
+      f = lDubDist(lRng);
+      lQr.yhi(t.y + f * (lBr.yhi() - t.y));
+      f = lDubDist(lRng);
+    }
+    aData.countWithinBatch(lCand);
+    for(uint k = 0; k < lCand.size() && i < aCb.no_query(); ++k) {
+      if(0 < lCand[k].card()) {
+        ++i;
+        os << i << ' ' << lCand[k].card() << ' ' << lCand[k].rectangle() << std::endl;
+      }
+    }
+  }
+}
+
+// half a unit in the last digit of aVal printed with aDigits significant digits
+double
+print_error(const double aVal, const int aDigits) {
+  if(0 == aVal) {
+    return 0;
+  }
+  return 0.5 * std::pow(10.0, std::floor(std::log10(std::fabs(aVal))) - aDigits + 1);
+}
+
+// recount the cardinalities of all queries in aCb.filename_query()
+// the query files hold rectangles rounded to 6 significant digits (the
+// default precision of the generator), points near their boundary may
+// lie on either side. a cardinality that differs from the recount but
+// lies between the counts of the rectangle shrunk and grown by the
+// rounding error is only reported as within print precision.
+// returns the number of queries with a wrong cardinality
+uint
+verify_query(const H2D::Data2dim& aData, const H2D::Cb& aCb) {
+  constexpr int k_print_digits = 6;
+  H2D::query_vt lQueries;
+  if(!(H2D::has_bin_sibling(aCb.filename_query()) &&
+       H2D::read_query_bin(H2D::bin_sibling(aCb.filename_query()), lQueries))) {
+    lQueries.clear();
+    H2D::read_query_text(aCb.filename_query(), lQueries);
+  }
+  H2D::query_vt lRecount(lQueries);
+  aData.countWithinBatch(lRecount);
+
+  H2D::query_vt lInner;
+  H2D::query_vt lOuter;
+  std::vector<uint> lMismatch;
+  for(uint i = 0; i < lQueries.size(); ++i) {
+    if(lQueries[i].card() == lRecount[i].card()) {
+      continue;
+    }
+    const H2D::rectangle_t& r = lQueries[i].rectangle();
+    lMismatch.push_back(i);
+    lInner.push_back(lQueries[i]);
+    lOuter.push_back(lQueries[i]);
+    H2D::rectangle_t& lIr = lInner.back()._rectangle;
+    H2D::rectangle_t& lOr = lOuter.back()._rectangle;
+    lIr.xlo(r.xlo() + print_error(r.xlo(), k_print_digits));
+    lIr.xhi(r.xhi() - print_error(r.xhi(), k_print_digits));
+    lIr.ylo(r.ylo() + print_error(r.ylo(), k_print_digits));
+    lIr.yhi(r.yhi() - print_error(r.yhi(), k_print_digits));
+    lOr.xlo(r.xlo() - print_error(r.xlo(), k_print_digits));
+    lOr.xhi(r.xhi() + print_error(r.xhi(), k_print_digits));
+    lOr.ylo(r.ylo() - print_error(r.ylo(), k_print_digits));
+    lOr.yhi(r.yhi() + print_error(r.yhi(), k_print_digits));
+  }
+  aData.countWithinBatch(lInner);
+  aData.countWithinBatch(lOuter);
+
+  uint lNoBad = 0;
+  uint lNoPrec = 0;
+  uint lMaxDiff = 0;
+  for(uint k = 0; k < lMismatch.size(); ++k) {
+    const uint i = lMismatch[k];
+    const uint lInnerCard = (lInner[k].rectangle().isEmpty() ? 0 : lInner[k].card());
+    if((lInnerCard <= lQueries[i].card()) && (lQueries[i].card() <= lOuter[k].card())) {
+      ++lNoPrec;
+      continue;
+    }
+    ++lNoBad;
+    const uint lDiff = std::max(lQueries[i].card(), lRecount[i].card()) - std::min(lQueries[i].card(), lRecount[i].card());
+    lMaxDiff = std::max<uint>(lMaxDiff, lDiff);
+    if(aCb.trace()) {
+      std::cout << lQueries[i].no() << ' '
+                << lQueries[i].card() << ' '
+                << lRecount[i].card() << ' '
+                << lQueries[i].rectangle()
+                << std::endl;
+    }
+  }
+  std::cout << "# no queries      = " << lQueries.size() << std::endl;
+  std::cout << "# no within prec  = " << lNoPrec << std::endl;
+  std::cout << "# no bad card     = " << lNoBad << std::endl;
+  std::cout << "# max card diff   = " << lMaxDiff << std::endl;
+  return lNoBad;
+}
+
 int
 main(const int argc, const char* argv[]) {
   H2D::Cb lCb;
@@ -88,12 +212,26 @@ main(const int argc, const char* argv[]) {
   std::cout << "# outfile = " << lCb.filename_query() << std::endl;
 
   cmeasure_t lMeas;
+  if(lCb.verifyQuery()) {
+    if(0 == lCb.filename_query().size()) {
+      std::cerr << "no query file given." << std::endl;
+      return -1;
+    }
+    cmeasure_start(&lMeas);
+    const uint lNoBad = verify_query(lData, lCb);
+    cmeasure_stop(&lMeas);
+    std::cout << "# total   runtime = " << cmeasure_total_s(&lMeas) << " [s]" << std::endl;
+    return (0 == lNoBad ? 0 : 1);
+  }
+
+  void (*lGenerate)(std::ostream&, const H2D::Data2dim&, const H2D::Cb&) =
+         (lCb.batchCount() ? generate_query_batch : generate_query);
   cmeasure_start(&lMeas);
   if(0 == lCb.filename_query().size()) {
-    generate_query(std::cout, lData, lCb);
+    (*lGenerate)(std::cout, lData, lCb);
   } else {
     std::ofstream lOs(lCb.filename_query());
-    generate_query(lOs, lData, lCb);
+    (*lGenerate)(lOs, lData, lCb);
   }
   cmeasure_stop(&lMeas);
   double lNoQ = ((double) lCb.no_query());
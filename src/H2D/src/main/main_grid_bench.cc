@@ -0,0 +1,172 @@
+#include <iostream>
+#include <iomanip>
+
+#include <vector>
+#include <random>
+
+#include "infra/grid_tt.hh"
+#include "infra/CrystalClock.hh"
+
+/*
+ *  per tile cycles of summing the decompressed tile frequencies over
+ *  sub-rectangles of packed Grid_TT grids, for every (Tgrid, Tbits)
+ *  used by the GxTree nodes:
+ *    get: get(i,j) and a table lookup per tile (as formerly estimateLeaf)
+ *    row: getRowDecompressed per row, added in the same order as get
+ *    sum: sumDecompressed
+ *  all three add in the same order and must agree exactly,
+ *  getRow must agree with get.
+ */
+
+struct rect_t {
+  uint32_t _xb, _xe, _yb, _ye;
+};
+
+template<uint32_t Tgrid, uint32_t Tbits>
+void
+bench(const uint32_t aNoGrids, const uint32_t aNoRect, std::mt19937& aRng) {
+  typedef Grid_TT<Tgrid,Tbits> grid_t;
+
+  // grids back to back, as the nodes in their arrays
+  std::vector<uint8_t> lBytes(aNoGrids * grid_t::NoBytes + 1);
+  for(size_t k = 0; k < lBytes.size(); ++k) {
+    lBytes[k] = aRng() & 0xFF;
+  }
+  std::vector<double> lTable(1 << Tbits);
+  for(size_t k = 0; k < lTable.size(); ++k) {
+    lTable[k] = 1.0 + (aRng() % 100000) / 7.0;
+  }
+  std::vector<rect_t> lRect(aNoRect);
+  uint64_t lNoTiles = 0;
+  for(uint32_t r = 0; r < aNoRect; ++r) {
+    rect_t& x = lRect[r];
+    x._xb = aRng() % Tgrid;
+    x._xe = x._xb + 1 + (aRng() % (Tgrid - x._xb));
+    x._yb = aRng() % Tgrid;
+    x._ye = x._yb + 1 + (aRng() % (Tgrid - x._yb));
+    lNoTiles += (x._xe - x._xb) * (x._ye - x._yb);
+  }
+  lNoTiles *= aNoGrids;
+
+  std::vector<double> lRef(aNoGrids * aNoRect);
+  std::vector<double> lRow(aNoGrids * aNoRect);
+  std::vector<double> lSum(aNoGrids * aNoRect);
+  grid_t lGrid;
+
+  uint64_t lBegin = CrystalClock::current();
+  for(uint32_t g = 0; g < aNoGrids; ++g) {
+    lGrid.attach(lBytes.data() + g * grid_t::NoBytes);
+    for(uint32_t r = 0; r < aNoRect; ++r) {
+      const rect_t& x = lRect[r];
+      double lRes = 0;
+      for(uint32_t i = x._xb; i < x._xe; ++i) {
+        for(uint32_t j = x._yb; j < x._ye; ++j) {
+          lRes += lTable[lGrid.get(i,j)];
+        }
+      }
+      lRef[g * aNoRect + r] = lRes;
+    }
+  }
+  const uint64_t lCyclesGet = CrystalClock::cycles(lBegin, CrystalClock::current());
+
+  lBegin = CrystalClock::current();
+  double lBuf[Tgrid];
+  for(uint32_t g = 0; g < aNoGrids; ++g) {
+    lGrid.attach(lBytes.data() + g * grid_t::NoBytes);
+    for(uint32_t r = 0; r < aNoRect; ++r) {
+      const rect_t& x = lRect[r];
+      double lRes = 0;
+      for(uint32_t i = x._xb; i < x._xe; ++i) {
+        lGrid.getRowDecompressed(i, x._yb, x._ye, lTable.data(), lBuf);
+        for(uint32_t j = x._yb; j < x._ye; ++j) {
+          lRes += lBuf[j - x._yb];
+        }
+      }
+      lRow[g * aNoRect + r] = lRes;
+    }
+  }
+  const uint64_t lCyclesRow = CrystalClock::cycles(lBegin, CrystalClock::current());
+
+  lBegin = CrystalClock::current();
+  for(uint32_t g = 0; g < aNoGrids; ++g) {
+    lGrid.attach(lBytes.data() + g * grid_t::NoBytes);
+    for(uint32_t r = 0; r < aNoRect; ++r) {
+      const rect_t& x = lRect[r];
+      lSum[g * aNoRect + r] = lGrid.sumDecompressed(x._xb, x._xe, x._yb, x._ye, lTable.data());
+    }
+  }
+  const uint64_t lCyclesSum = CrystalClock::cycles(lBegin, CrystalClock::current());
+
+  // codes of whole rows
+  uint32_t lCode[Tgrid];
+  uint32_t lNoDiffRow = 0;
+  uint32_t lNoDiffSum = 0;
+  uint32_t lNoDiffCode = 0;
+  for(uint32_t g = 0; g < aNoGrids; ++g) {
+    lGrid.attach(lBytes.data() + g * grid_t::NoBytes);
+    for(uint32_t i = 0; i < Tgrid; ++i) {
+      lGrid.getRow(i, 0, Tgrid, lCode);
+      for(uint32_t j = 0; j < Tgrid; ++j) {
+        lNoDiffCode += (lCode[j] != lGrid.get(i,j));
+      }
+    }
+  }
+  for(size_t k = 0; k < lRef.size(); ++k) {
+    lNoDiffRow += (lRef[k] != lRow[k]);
+    lNoDiffSum += (lRef[k] != lSum[k]);
+  }
+
+  const double lNoTilesD = (double) lNoTiles;
+  std::cout << std::setw(5) << Tgrid << ' '
+            << std::setw(5) << Tbits << ' '
+            << std::setw(12) << lNoTiles << ' '
+            << std::fixed << std::setprecision(2)
+            << std::setw(10) << (lCyclesGet / lNoTilesD) << ' '
+            << std::setw(10) << (lCyclesRow / lNoTilesD) << ' '
+            << std::setw(10) << (lCyclesSum / lNoTilesD) << ' '
+            << std::setw(6) << lNoDiffCode << ' '
+            << std::setw(6) << lNoDiffRow << ' '
+            << std::setw(6) << lNoDiffSum
+            << std::endl;
+}
+
+int
+main() {
+  CrystalClock::init();
+  std::mt19937 lRng;
+  const uint32_t lNoGrids = 4096;
+  const uint32_t lNoRect  = 64;
+
+  std::cout << "# " << std::setw(3) << "grid" << ' '
+            << std::setw(5) << "bits" << ' '
+            << std::setw(12) << "#tiles" << ' '
+            << std::setw(10) << "get c/t" << ' '
+            << std::setw(10) << "row c/t" << ' '
+            << std::setw(10) << "sum c/t" << ' '
+            << std::setw(6) << "dcode" << ' '
+            << std::setw(6) << "drow" << ' '
+            << std::setw(6) << "dsum" << std::endl;
+
+  bench<2,3>(lNoGrids, lNoRect, lRng);
+  bench<2,4>(lNoGrids, lNoRect, lRng);
+  bench<3,3>(lNoGrids, lNoRect, lRng);
+  bench<3,4>(lNoGrids, lNoRect, lRng);
+  bench<3,5>(lNoGrids, lNoRect, lRng);
+  bench<4,2>(lNoGrids, lNoRect, lRng);
+  bench<4,3>(lNoGrids, lNoRect, lRng);
+  bench<4,4>(lNoGrids, lNoRect, lRng);
+  bench<4,5>(lNoGrids, lNoRect, lRng);
+  bench<4,6>(lNoGrids, lNoRect, lRng);
+  bench<5,2>(lNoGrids, lNoRect, lRng);
+  bench<5,3>(lNoGrids, lNoRect, lRng);
+  bench<5,4>(lNoGrids, lNoRect, lRng);
+  bench<5,5>(lNoGrids, lNoRect, lRng);
+  bench<5,6>(lNoGrids, lNoRect, lRng);
+  bench<5,7>(lNoGrids, lNoRect, lRng);
+  bench<6,2>(lNoGrids, lNoRect, lRng);
+  bench<6,3>(lNoGrids, lNoRect, lRng);
+  bench<6,5>(lNoGrids, lNoRect, lRng);
+  bench<7,4>(lNoGrids, lNoRect, lRng);
+  bench<8,3>(lNoGrids, lNoRect, lRng);
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <iomanip>
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+#include "infra/data2dim.hh"
+#include "infra/binfile.hh"
+#include "infra/OutlierIndex.hh"
+#include "infra/CrystalClock.hh"
+
+#include "arg.hh"
+
+/*
+ *  per query cycles of outlier counting, linear scan (as formerly done by
+ *  the outlierCount of all phi-outlier estimators) vs. OutlierIndex,
+ *  for outlier sets of 10 .. 100k points drawn from one data set
+ *  (<inDir>/<sds>/<ds>.hist) and its test queries (<testQDir>/<sds>/<ds>.qu_a).
+ */
+
+void
+report(const char* aName, const uint aNoOutlier, const uint64_t aCycles, const uint aNoQueries) {
+  const double lCyclesPerQuery = (double) aCycles / (double) aNoQueries;
+  std::cout << std::setw(8) << aName << ' '
+            << std::setw(10) << aNoOutlier << ' '
+            << std::setw(10) << aNoQueries << ' '
+            << std::setw(12) << std::fixed << std::setprecision(1) << lCyclesPerQuery << ' '
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << (lCyclesPerQuery * 1.0e9 / CrystalClock::frequency())
+            << std::endl;
+}
+
+int
+main(const int argc, const char* argv[]) {
+  H2D::Cb lCb;
+  argdesc_vt lArgDesc;
+  construct_arg_desc(lArgDesc);
+
+  if(!parse_args<H2D::Cb>(1, argc, argv, lArgDesc, lCb)) {
+    std::cerr << "error while parsing arguments." << std::endl;
+    return -1;
+  }
+  if(lCb.help()) {
+    print_usage(std::cout, argv[0], lArgDesc);
+    return 0;
+  }
+
+  const std::string lFilenameData  = lCb.inDir() + '/' + lCb.sds() + '/' + lCb.ds() + ".hist";
+  const std::string lFilenameQuery = lCb.testQDir() + '/' + lCb.sds() + '/' + lCb.ds() + ".qu_a";
+  H2D::Data2dim lData;
+  if(!(H2D::has_bin_sibling(lFilenameData) && H2D::read_hist_bin(H2D::bin_sibling(lFilenameData), lData))) {
+    lData.readHistFile(lFilenameData);
+  }
+  H2D::query_vt lQueries;
+  if(!(H2D::has_bin_sibling(lFilenameQuery) && H2D::read_query_bin(H2D::bin_sibling(lFilenameQuery), lQueries))) {
+    lQueries.clear();
+    H2D::read_query_text(lFilenameQuery, lQueries);
+  }
+  if(0 == lData.size() || 0 == lQueries.size()) {
+    std::cerr << "Can't read '" << lFilenameData << "' or '" << lFilenameQuery << "'." << std::endl;
+    return -1;
+  }
+  CrystalClock::init();
+  H2D::Data2dim::useIndex(false); // countWithin of the outliers must scan
+
+  std::cout << "# " << std::setw(6) << "method" << ' '
+            << std::setw(10) << "#outlier" << ' '
+            << std::setw(10) << "#queries" << ' '
+            << std::setw(12) << "cycles/query" << ' '
+            << std::setw(12) << "ns/query" << std::endl;
+
+  std::mt19937 lRng;
+  const uint lNoQueries = lQueries.size();
+  std::vector<uint> lRef(lNoQueries);
+  for(uint n = 10; n <= 100000; n *= 10) {
+    // outliers: n points of the data set, high frequencies as after Data2dim::split
+    H2D::Data2dim lOutlier;
+    for(uint i = 0; i < n; ++i) {
+      const H2D::xyc_t& p = lData[lRng() % lData.size()];
+      lOutlier.push_back(p.x, p.y, p.c + 100);
+    }
+    const H2D::Data2dim& lOutlierConst = lOutlier;
+
+    uint64_t lBegin = CrystalClock::current();
+    for(uint i = 0; i < lNoQueries; ++i) {
+      lRef[i] = lOutlierConst.countWithinScan(lQueries[i].rectangle());
+    }
+    uint64_t lEnd = CrystalClock::current();
+    report("scan", n, CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+
+    lBegin = CrystalClock::current();
+    H2D::OutlierIndex lIndex(lOutlierConst);
+    lEnd = CrystalClock::current();
+    const uint64_t lBuildCycles = CrystalClock::cycles(lBegin, lEnd);
+    uint lNoDiff = 0;
+    lBegin = CrystalClock::current();
+    for(uint i = 0; i < lNoQueries; ++i) {
+      lNoDiff += (lRef[i] != lIndex.countWithin(lQueries[i].rectangle()));
+    }
+    lEnd = CrystalClock::current();
+    report("index", n, CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+    std::cout << "# index: " << lIndex.noNodes() << " nodes, " << lIndex.size() << " bytes, "
+              << lBuildCycles << " cycles to build, differs from scan for "
+              << lNoDiff << " queries" << std::endl;
+  }
+  return 0;
+}
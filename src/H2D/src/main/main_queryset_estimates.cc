@@ -60,6 +60,11 @@
  *  must exist 
  *  - <ds>.hist file with input data in form of a histogram
  *  - <ds>.qu   file with generated queries
+ *  --synopsisDir: QTS and GxTree are saved there after construction
+ *  and loaded instead of rebuilt by later runs with the same parameters
+ *  --query-order 1 or 2: the queries are estimated in z-curve or Hilbert
+ *  order of their centers, with --query-order-cmp <n> the time of file
+ *  order is measured in n alternating rounds and printed for comparison
  */
 
 
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <random>
+
+#include "infra/types.hh"
+#include "infra/data2dim.hh"
+#include "infra/RegularPartitioning2dim.hh"
+
+/*
+ *  regression check of RegularPartitioning2dim with summed-area table:
+ *  estimate(rectangle_t), estimate(query_t) and estimate_batch must give
+ *  the estimates of the tile loop (useCum(false)), in particular for
+ *  queries starting on the max edge of the grid (xlo = maxX or
+ *  ylo = maxY), which have no tile in one direction.
+ *  a 32x32 grid over 1000 points in [0,99]^2 and random queries.
+ *  returns 0 if all estimates agree.
+ */
+
+typedef std::mt19937 rng32_t;
+
+bool
+is_equal(const double a, const double b) {
+  return (std::fabs(a - b) <= 1e-9 * std::max<double>(1.0, std::fabs(a)));
+}
+
+void
+add_query(H2D::query_vt& aQueries, const double aXlo, const double aXhi, const double aYlo, const double aYhi) {
+  H2D::query_t lQuery;
+  lQuery._no = aQueries.size() + 1;
+  lQuery._rectangle.xlo(aXlo);
+  lQuery._rectangle.xhi(aXhi);
+  lQuery._rectangle.ylo(aYlo);
+  lQuery._rectangle.yhi(aYhi);
+  aQueries.push_back(lQuery);
+}
+
+int
+main() {
+  const uint   lNoPoints = 1000;
+  const uint   lNoRandom = 100000;
+  const uint   lNx = 32;
+  const uint   lNy = 32;
+  const double lMax = 99;
+
+  rng32_t lRng;
+  std::uniform_int_distribution<uint>    lIntDist(0, (uint) lMax);
+  std::uniform_real_distribution<double> lDubDist(-10, lMax + 10);
+
+  H2D::Data2dim lData;
+  lData.init();
+  lData.step(0, 0, 1);
+  lData.step(lMax, lMax, 1);
+  for(uint i = 2; i < lNoPoints; ++i) {
+    lData.step(lIntDist(lRng), lIntDist(lRng), 1 + (i % 7));
+  }
+  lData.fin();
+
+  H2D::query_vt lQueries;
+  // max edge
+  add_query(lQueries, lMax, lMax, 0, lMax);
+  add_query(lQueries, lMax, lMax + 5, 0, lMax);
+  add_query(lQueries, 0, lMax, lMax, lMax);
+  add_query(lQueries, 0, lMax, lMax, lMax + 5);
+  add_query(lQueries, lMax, lMax, lMax, lMax);
+  add_query(lQueries, lMax, lMax + 5, lMax, lMax + 5);
+  add_query(lQueries, 50, lMax, lMax, lMax);
+  add_query(lQueries, lMax, lMax, 50, lMax);
+  // min edge
+  add_query(lQueries, 0, 0, 0, lMax);
+  add_query(lQueries, 0, lMax, 0, 0);
+  add_query(lQueries, -5, 0, -5, 0);
+  for(uint i = 0; i < lNoRandom; ++i) {
+    const double x1 = lDubDist(lRng);
+    const double x2 = lDubDist(lRng);
+    const double y1 = lDubDist(lRng);
+    const double y2 = lDubDist(lRng);
+    add_query(lQueries, std::min(x1, x2), std::max(x1, x2), std::min(y1, y2), std::max(y1, y2));
+  }
+
+  H2D::RegularPartitioning2dim::useCum(true);
+  H2D::RegularPartitioning2dim lCum(lNx, lNy, lData);
+  H2D::RegularPartitioning2dim::useCum(false);
+  H2D::RegularPartitioning2dim lLoop(lNx, lNy, lData);
+  H2D::RegularPartitioning2dim::useCum(true);
+
+  if(!lCum.hasCum() || lLoop.hasCum()) {
+    std::cout << "summed-area table not built as expected." << std::endl;
+    return 1;
+  }
+
+  std::vector<double> lBatchCum(lQueries.size());
+  std::vector<double> lBatchLoop(lQueries.size());
+  lCum.estimate_batch(lQueries.data(), lQueries.size(), lBatchCum.data());
+  lLoop.estimate_batch(lQueries.data(), lQueries.size(), lBatchLoop.data());
+
+  uint lNoBad = 0;
+  for(uint i = 0; i < lQueries.size(); ++i) {
+    const H2D::query_t& lQuery = lQueries[i];
+    const double lExpected = lLoop.estimate(lQuery.rectangle());
+    const double lEst[4] = { lCum.estimate(lQuery.rectangle()),
+                             lCum.estimate(lQuery),
+                             lBatchCum[i],
+                             lBatchLoop[i] };
+    for(uint k = 0; k < 4; ++k) {
+      if(!is_equal(lExpected, lEst[k])) {
+        ++lNoBad;
+        std::cout << "query " << lQuery.no() << ' ' << lQuery.rectangle()
+                  << " variant " << k << ": " << std::setprecision(17)
+                  << lEst[k] << " != " << lExpected << std::endl;
+      }
+    }
+  }
+  std::cout << "# no queries  = " << lQueries.size() << std::endl;
+  std::cout << "# no mismatch = " << lNoBad << std::endl;
+  return (0 == lNoBad ? 0 : 1);
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "infra/argbase.hh"
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+#include "infra/util.hh"
+
+extern "C" {
+  #include "infra/cmeasure.h"
+}
+
+#include "arg.hh"
+
+#include "sweep.hh"
+
+/*
+ *  run the estimators of a manifest on all data sets of the manifest
+ *  in one process, instead of one main_queryset_estimates per
+ *  (data set, estimator). see sweep.hh for the manifest format.
+ *  --manifest       data sets and estimators
+ *  --sweep-threads  number of tasks run concurrently
+ *  --inDir, --outDir, --trainQDir, --testQDir, --synopsisDir and the
+ *  other options are those of main_queryset_estimates and apply to all
+ *  tasks, the .out files go to <outDir>/<sds>/<no>_<sds>_<ds>_<syn>.out
+ *  e.g.
+ *    ./main_sweep --manifest tiger.manifest --sweep-threads 16 --inDir ... --outDir ... --trainQDir ... --testQDir ...
+ */
+
+int
+main(const int argc, const char* argv[]) {
+  H2D::Cb lCb;
+  argdesc_vt lArgDesc;
+  construct_arg_desc(lArgDesc);
+
+  if(!parse_args<H2D::Cb>(1, argc, argv, lArgDesc, lCb)) {
+    std::cerr << "error while parsing arguments." << std::endl;
+    return -1;
+  }
+
+  if(lCb.help()) {
+    print_usage(std::cout, argv[0], lArgDesc);
+    return 0;
+  }
+
+  if(0 == lCb.manifest().size()) {
+    std::cerr << "no manifest given." << std::endl;
+    return -1;
+  }
+
+  const std::string gDirIn  = lCb.inDir();
+  const std::string gDirOut = lCb.outDir();
+
+  if(!std::filesystem::exists(gDirIn) || !std::filesystem::is_directory(gDirIn)) {
+    std::cout << "not a valid directory: '" << gDirIn << std::endl;
+    return -1;
+  }
+
+  if(!std::filesystem::exists(gDirOut) || !std::filesystem::is_directory(gDirOut)) {
+    std::cout << "not a valid directory: '" << gDirOut << std::endl;
+    return -1;
+  }
+
+  H2D::Sweep lSweep(lCb);
+  if(!lSweep.read_manifest(lCb.manifest())) {
+    return -1;
+  }
+
+  cmeasure_t lMeas;
+  cmeasure_start(&lMeas);
+  lSweep.run(lCb.noSweepThreads());
+  cmeasure_stop(&lMeas);
+
+  std::cout << "# sweep: "
+            << lSweep.datasets().size() << " data sets, "
+            << lSweep.estimators().size() << " estimators, "
+            << lSweep.noTasks() << " tasks, "
+            << lSweep.noFailed() << " failed, "
+            << cmeasure_total_s(&lMeas) << " s" << std::endl;
+  return (0 == lSweep.noFailed()) ? 0 : -1;
+}
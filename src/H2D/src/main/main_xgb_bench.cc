@@ -0,0 +1,239 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+#include "infra/data2dim.hh"
+#include "infra/binfile.hh"
+#include "infra/CrystalClock.hh"
+
+#include "XGBoost/TreeEnsemble.hh"
+#include "XGBoost/XGBCompiled.hh"
+#include "GxTree/GxTree.hh"
+
+#ifdef XGB_COMPILED_HEADER
+  #include XGB_COMPILED_HEADER
+  #ifndef XGB_COMPILED_MODEL
+    #define XGB_COMPILED_MODEL XgbCompiledModel
+  #endif
+#endif
+
+#include "arg.hh"
+
+/*
+ *  per query cycles of learned vs. traditional estimators on the test queries
+ *  (<testQDir>/<sds>/<ds>.qu_a) of one data set (<inDir>/<sds>/<ds>.hist):
+ *    xgb-api-batch   XGDMatrixCreateFromMat + XGBoosterPredictFromDMatrix, all queries at once
+ *    xgb-api-1row    the same with one DMatrix per query
+ *    native          TreeEnsemble::predict (flat node array)
+ *    native-batch    TreeEnsemble::predict_batch
+ *    compiled        XGBCompiled_TT::predict (header from main_xgb_codegen)
+ *    compiled-batch  XGBCompiled_TT::predict_batch
+ *    gxtree          GxTreeItp::estimate
+ *  the model must be a plain XGB model (features xlo, xhi, ylo, yhi), see --xgb-model.
+ *  the compiled variant needs to be built with
+ *    -DXGB_COMPILED_HEADER='"<generated>.hh"' [-DXGB_COMPILED_MODEL=<--xgb-codegen-name>]
+ */
+
+typedef std::vector<float> float_vt;
+
+void
+report(const char* aName, const uint64_t aCycles, const uint aNoQueries) {
+  const double lCyclesPerQuery = (double) aCycles / (double) aNoQueries;
+  std::cout << std::setw(16) << aName << ' '
+            << std::setw(10) << aNoQueries << ' '
+            << std::setw(12) << std::fixed << std::setprecision(1) << lCyclesPerQuery << ' '
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << (lCyclesPerQuery * 1.0e9 / CrystalClock::frequency())
+            << std::endl;
+}
+
+// number of rows where aPred differs from aRef
+uint
+no_diff(const float_vt& aRef, const float_vt& aPred) {
+  uint lRes = 0;
+  for(size_t i = 0; i < aRef.size(); ++i) {
+    lRes += (aRef[i] != aPred[i]);
+  }
+  return lRes;
+}
+
+bool
+check_xgb(const int aErr, const char* aCall) {
+  if(0 != aErr) {
+    std::cout << "# xgboost: " << aCall << ": " << XGBGetLastError() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void
+bench_xgb_api(const H2D::Cb& aCb, const float_vt& aMat, const uint aNoQueries, const float_vt& aRef) {
+  BoosterHandle lBooster = 0;
+  if(!check_xgb(XGBoosterCreate(0, 0, &lBooster), "XGBoosterCreate")) {
+    return;
+  }
+  if(!check_xgb(XGBoosterLoadModel(lBooster, aCb.xgb_model_file().c_str()), "XGBoosterLoadModel")) {
+    XGBoosterFree(lBooster);
+    return;
+  }
+  char const lConfig[] = "{\"training\": false, \"type\": 0, "
+                         "\"iteration_begin\": 0, \"iteration_end\": 0, \"strict_shape\": false}";
+  const float lMissing = std::numeric_limits<float>::quiet_NaN();
+  float_vt lPred(aNoQueries);
+  DMatrixHandle lMat = 0;
+  bst_ulong const* lShape = 0;
+  bst_ulong lDim = 0;
+  float const* lRes = 0;
+
+  uint64_t lBegin = CrystalClock::current();
+  bool lOk = check_xgb(XGDMatrixCreateFromMat(aMat.data(), aNoQueries, 4, lMissing, &lMat), "XGDMatrixCreateFromMat")
+          && check_xgb(XGBoosterPredictFromDMatrix(lBooster, lMat, lConfig, &lShape, &lDim, &lRes), "XGBoosterPredictFromDMatrix");
+  if(lOk) {
+    std::copy(lRes, lRes + aNoQueries, lPred.begin());
+  }
+  uint64_t lEnd = CrystalClock::current();
+  XGDMatrixFree(lMat);
+  if(!lOk) {
+    XGBoosterFree(lBooster);
+    return;
+  }
+  report("xgb-api-batch", CrystalClock::cycles(lBegin, lEnd), aNoQueries);
+  std::cout << "# xgb-api-batch differs from native for " << no_diff(aRef, lPred) << " queries" << std::endl;
+
+  const uint lNoSingle = std::min<uint>(aNoQueries, 10000);
+  lBegin = CrystalClock::current();
+  for(uint i = 0; i < lNoSingle; ++i) {
+    XGDMatrixCreateFromMat(aMat.data() + 4 * i, 1, 4, lMissing, &lMat);
+    XGBoosterPredictFromDMatrix(lBooster, lMat, lConfig, &lShape, &lDim, &lRes);
+    lPred[i] = *lRes;
+    XGDMatrixFree(lMat);
+  }
+  lEnd = CrystalClock::current();
+  report("xgb-api-1row", CrystalClock::cycles(lBegin, lEnd), lNoSingle);
+  XGBoosterFree(lBooster);
+}
+
+int
+main(const int argc, const char* argv[]) {
+  H2D::Cb lCb;
+  argdesc_vt lArgDesc;
+  construct_arg_desc(lArgDesc);
+
+  if(!parse_args<H2D::Cb>(1, argc, argv, lArgDesc, lCb)) {
+    std::cerr << "error while parsing arguments." << std::endl;
+    return -1;
+  }
+  if(lCb.help()) {
+    print_usage(std::cout, argv[0], lArgDesc);
+    return 0;
+  }
+
+  // data and queries as in ProcessQueryFile::process_query_file
+  const std::string lFilenameData  = lCb.inDir() + '/' + lCb.sds() + '/' + lCb.ds() + ".hist";
+  const std::string lFilenameQuery = lCb.testQDir() + '/' + lCb.sds() + '/' + lCb.ds() + ".qu_a";
+  H2D::Data2dim lData;
+  if(!(H2D::has_bin_sibling(lFilenameData) && H2D::read_hist_bin(H2D::bin_sibling(lFilenameData), lData))) {
+    lData.readHistFile(lFilenameData);
+  }
+  H2D::query_vt lQueries;
+  if(!(H2D::has_bin_sibling(lFilenameQuery) && H2D::read_query_bin(H2D::bin_sibling(lFilenameQuery), lQueries))) {
+    lQueries.clear();
+    H2D::read_query_text(lFilenameQuery, lQueries);
+  }
+  if(0 == lData.size() || 0 == lQueries.size()) {
+    std::cerr << "Can't read '" << lFilenameData << "' or '" << lFilenameQuery << "'." << std::endl;
+    return -1;
+  }
+  const double lTotal = lData.total();
+  const uint   lSampleSize = (uint) std::ceil(std::sqrt(lTotal * std::log(lTotal)));
+  lCb.budget(8 * lSampleSize);
+  lCb.theta(std::ceil(std::sqrt(lTotal / std::log(lTotal))));
+  lCb.phi(100);
+
+  H2D::TreeEnsemble lEns;
+  if(!lEns.read(lCb.xgb_model_file())) {
+    return -1;
+  }
+  if(4 < lEns.noFeatures()) {
+    std::cerr << "model uses " << lEns.noFeatures() << " features, only plain XGB models are supported." << std::endl;
+    return -1;
+  }
+  lEns.print(std::cout);
+
+  const uint lNoQueries = lQueries.size();
+  float_vt lMat(4 * lNoQueries);
+  for(uint i = 0; i < lNoQueries; ++i) {
+    const H2D::rectangle_t& r = lQueries[i].rectangle();
+    lMat[4 * i + 0] = r._pll.x;
+    lMat[4 * i + 1] = r._pur.x;
+    lMat[4 * i + 2] = r._pll.y;
+    lMat[4 * i + 3] = r._pur.y;
+  }
+  CrystalClock::init();
+
+  std::cout << "# " << std::setw(14) << "method" << ' '
+            << std::setw(10) << "#queries" << ' '
+            << std::setw(12) << "cycles/query" << ' '
+            << std::setw(12) << "ns/query" << std::endl;
+
+  // native
+  float_vt lRef(lNoQueries);
+  float_vt lPred(lNoQueries);
+  uint64_t lBegin = CrystalClock::current();
+  for(uint i = 0; i < lNoQueries; ++i) {
+    lRef[i] = lEns.predict(lMat.data() + 4 * i);
+  }
+  uint64_t lEnd = CrystalClock::current();
+  report("native", CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+
+  lBegin = CrystalClock::current();
+  lEns.predict_batch(lMat.data(), lNoQueries, 4, lPred.data());
+  lEnd = CrystalClock::current();
+  report("native-batch", CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+  std::cout << "# native-batch differs from native for " << no_diff(lRef, lPred) << " queries" << std::endl;
+
+#ifdef XGB_COMPILED_HEADER
+  typedef H2D::XGBCompiled_TT<XGB_COMPILED_MODEL> compiled_t;
+  lBegin = CrystalClock::current();
+  for(uint i = 0; i < lNoQueries; ++i) {
+    lPred[i] = compiled_t::predict(lMat.data() + 4 * i);
+  }
+  lEnd = CrystalClock::current();
+  report("compiled", CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+  std::cout << "# compiled differs from native for " << no_diff(lRef, lPred) << " queries" << std::endl;
+
+  lBegin = CrystalClock::current();
+  compiled_t::predict_batch(lMat.data(), lNoQueries, 4, lPred.data());
+  lEnd = CrystalClock::current();
+  report("compiled-batch", CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+#else
+  std::cout << "# compiled: not built with -DXGB_COMPILED_HEADER" << std::endl;
+#endif
+
+  bench_xgb_api(lCb, lMat, lNoQueries, lRef);
+
+  // GxTree as constructed in ProcessQueryFile::new_estimator
+  H2D::GxTree lGxt(lData, H2D::GxTree::K_GLMS, lCb.budget(),
+                   lCb.leafRefinement(), lCb.lrf(),
+                   lCb.minimumNodeTotal(), lCb.phi(), 2, 1, false);
+  lGxt.encode(false);
+  H2D::GxTreeItp lGxtItp(lGxt.outlier(), lGxt.encoding(), false);
+  double lSum = 0;
+  lBegin = CrystalClock::current();
+  for(uint i = 0; i < lNoQueries; ++i) {
+    lSum += lGxtItp.estimate(lQueries[i].rectangle());
+  }
+  lEnd = CrystalClock::current();
+  report("gxtree", CrystalClock::cycles(lBegin, lEnd), lNoQueries);
+  std::cout << "# gxtree sum of estimates " << lSum << std::endl;
+  return 0;
+}
+
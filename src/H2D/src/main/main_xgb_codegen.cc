@@ -0,0 +1,146 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdio.h>
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+#include "XGBoost/TreeEnsemble.hh"
+
+#include "arg.hh"
+
+/*
+ *  generate a C++ header from a saved XGBoost model (XGBEstimator::train_model)
+ *  for the plug-in estimator XGBCompiled_TT (XGBoost/XGBCompiled.hh):
+ *  every tree becomes a complete binary tree of depth max(3, model depth),
+ *  floats are written as hex literals, i.e. bit exact.
+ *  --xgb-model <f>.json         model (default <outDir>/<sds>/<ds>_exgb_model.json)
+ *  --xgb-codegen <f>.hh         output header
+ *  --xgb-codegen-name <name>    name of the generated struct (XgbCompiledModel)
+ */
+
+typedef H2D::TreeEnsemble TreeEnsemble;
+
+std::string
+hex_float(const float x) {
+  if(x == std::numeric_limits<float>::infinity()) {
+    return "HUGE_VALF";
+  }
+  char lBuf[64];
+  snprintf(lBuf, sizeof(lBuf), "%af", (double) x);
+  return std::string(lBuf);
+}
+
+// fill position aPos (level aLevel) of the complete tree with node aNode,
+// leaves above the last level are repeated in both subtrees
+void
+fill_complete(const TreeEnsemble& aEns, const uint aNode, const uint aPos, const uint aLevel, const uint aDepth,
+              std::vector<float>& aSplit, std::vector<uint>& aFeature, std::vector<float>& aLeaf) {
+  const TreeEnsemble::node_t& n = aEns.node(aNode);
+  const uint lNoInner = (1 << aDepth) - 1;
+  if(aLevel == aDepth) {
+    aLeaf[aPos - lNoInner] = n._value;
+    return;
+  }
+  if(aEns.isLeaf(aNode)) {
+    aSplit[aPos]   = std::numeric_limits<float>::infinity();
+    aFeature[aPos] = 0;
+    fill_complete(aEns, aNode, 2 * aPos + 1, aLevel + 1, aDepth, aSplit, aFeature, aLeaf);
+    fill_complete(aEns, aNode, 2 * aPos + 2, aLevel + 1, aDepth, aSplit, aFeature, aLeaf);
+  } else {
+    aSplit[aPos]   = n._split;
+    aFeature[aPos] = n._feature & ~TreeEnsemble::k_default_left;
+    fill_complete(aEns, n._left,     2 * aPos + 1, aLevel + 1, aDepth, aSplit, aFeature, aLeaf);
+    fill_complete(aEns, n._left + 1, 2 * aPos + 2, aLevel + 1, aDepth, aSplit, aFeature, aLeaf);
+  }
+}
+
+bool
+generate(std::ostream& os, const TreeEnsemble& aEns, const std::string& aModelFile, const std::string& aName) {
+  const uint lDepth   = std::max<uint>(3, aEns.maxDepth());
+  const uint lNoInner = (1 << lDepth) - 1;
+  if(255 < aEns.noFeatures()) {
+    std::cerr << "more than 255 features." << std::endl;
+    return false;
+  }
+  os << "// generated by main_xgb_codegen from " << aModelFile << ", do not edit" << std::endl
+     << "#ifndef XGB_COMPILED_" << aName << "_HH" << std::endl
+     << "#define XGB_COMPILED_" << aName << "_HH" << std::endl
+     << std::endl
+     << "#include \"XGBoost/XGBCompiled.hh\"" << std::endl
+     << "#include <cmath>" << std::endl
+     << std::endl
+     << "struct " << aName << " {" << std::endl
+     << "  static constexpr uint  k_depth       = " << lDepth << ';' << std::endl
+     << "  static constexpr uint  k_no_trees    = " << aEns.noTrees() << ';' << std::endl
+     << "  static constexpr uint  k_no_features = " << aEns.noFeatures() << ';' << std::endl
+     << "  static constexpr float k_base_score  = " << hex_float(aEns.baseScore()) << ';' << std::endl
+     << "  static constexpr H2D::xgb_ctree_tt<" << lDepth << "> k_tree[k_no_trees] = {" << std::endl;
+  std::vector<float> lSplit(lNoInner);
+  std::vector<uint>  lFeature(lNoInner);
+  std::vector<float> lLeaf(lNoInner + 1);
+  for(uint t = 0; t < aEns.noTrees(); ++t) {
+    fill_complete(aEns, aEns.tree(t)._root, 0, 0, lDepth, lSplit, lFeature, lLeaf);
+    os << "    {{";
+    for(uint i = 0; i < lNoInner; ++i) {
+      os << (0 < i ? ", " : "") << hex_float(lSplit[i]);
+    }
+    os << "}," << std::endl << "     {";
+    for(uint i = 0; i < lNoInner; ++i) {
+      os << (0 < i ? ", " : "") << lFeature[i];
+    }
+    os << "}," << std::endl << "     {";
+    for(uint i = 0; i <= lNoInner; ++i) {
+      os << (0 < i ? ", " : "") << hex_float(lLeaf[i]);
+    }
+    os << "}}," << std::endl;
+  }
+  os << "  };" << std::endl
+     << "};" << std::endl
+     << std::endl
+     << "#endif" << std::endl;
+  return true;
+}
+
+int
+main(const int argc, const char* argv[]) {
+  H2D::Cb lCb;
+  argdesc_vt lArgDesc;
+  construct_arg_desc(lArgDesc);
+
+  if(!parse_args<H2D::Cb>(1, argc, argv, lArgDesc, lCb)) {
+    std::cerr << "error while parsing arguments." << std::endl;
+    return -1;
+  }
+  if(lCb.help()) {
+    print_usage(std::cout, argv[0], lArgDesc);
+    return 0;
+  }
+  if(0 == lCb.xgb_codegen().size()) {
+    std::cerr << "no output header given (--xgb-codegen)." << std::endl;
+    return -1;
+  }
+
+  const std::string lModelFile = lCb.xgb_model_file();
+  TreeEnsemble lEns;
+  if(!lEns.read(lModelFile)) {
+    return -1;
+  }
+  std::ofstream lOs(lCb.xgb_codegen());
+  if(!lOs) {
+    std::cerr << "Can't open file '" << lCb.xgb_codegen() << "'." << std::endl;
+    return -1;
+  }
+  if(!generate(lOs, lEns, lModelFile, lCb.xgb_codegen_name())) {
+    return -1;
+  }
+  std::cout << "# " << lCb.xgb_codegen() << ": ";
+  lEns.print(std::cout);
+  return 0;
+}
+
@@ -10,8 +10,9 @@ ProcessQueryFile::ProcessQueryFile(const std::string &aDirIn,
                                    const std::string &aDirOut, Cb &aCb)
     : _dir_in(aDirIn), _dir_out(aDirOut), _filebase(), _data(), _query(),
       _esteval(), _construction_time_s(), _avg_query_time_us(),
-      _trace(aCb.trace()), _trainQuery() {
-  init(aDirIn, aDirOut, aCb);
+      _trace(aCb.trace()), _trainQuery(), _schedule(), _queryScheduled(),
+      _schedule_time_s(), _isValid(false) {
+  _isValid = init(aDirIn, aDirOut, aCb);
 }
 
 bool ProcessQueryFile::init(const std::string &aDirIn,
@@ -49,6 +50,9 @@ bool ProcessQueryFile::init(const std::string &aDirIn,
     return false;
   }
 
+  // 3. order of estimating the queries
+  init_schedule(aCb.queryOrder());
+
   // 5. calculate budget and sample size
   const double lTotal = data().total();
   const uint lSampleSize =
@@ -83,59 +87,76 @@ bool ProcessQueryFile::init(const std::string &aDirIn,
 
 bool ProcessQueryFile::run(const Cb &aCb) {
   summaryline_t lSummaryline;
-  lSummaryline._card = data().total();
-  lSummaryline._noDv = data().size();
-  lSummaryline._budget = aCb.budget();
-  lSummaryline._filename = aCb.sds() + '/' + aCb.ds();
-
+  init_summaryline(lSummaryline, aCb);
   return run_all_estimator(lSummaryline, aCb);
 }
 
+/*
+ * one estimator, its output goes to os.
+ * the data and queries are only read: for the same ProcessQueryFile,
+ * run_estimator may be called concurrently (main_sweep).
+ */
+
+bool ProcessQueryFile::run_estimator(const H2D_kind_t aEstKind, const Cb &aCb,
+                                     std::ostream &os) {
+  summaryline_t lSummaryline;
+  init_summaryline(lSummaryline, aCb);
+  return run_one_estimator(lSummaryline, aEstKind, aCb, os);
+}
+
+void ProcessQueryFile::init_summaryline(summaryline_t &aSummaryline,
+                                        const Cb &aCb) const {
+  aSummaryline._card = data().total();
+  aSummaryline._noDv = data().size();
+  aSummaryline._budget = aCb.budget();
+  aSummaryline._filename = aCb.sds() + '/' + aCb.ds();
+}
+
 bool ProcessQueryFile::run_all_estimator(summaryline_t &aSummaryline,
                                          const Cb &aCb) {
   if (aCb.estArea()) {
-    run_one_estimator(aSummaryline, H2D::H2D_EST_AREA, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_EST_AREA, aCb, std::cout);
   }
   if (aCb.regp()) {
-    run_one_estimator(aSummaryline, H2D::H2D_RegPart, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_RegPart, aCb, std::cout);
   }
   if (aCb.eqd()) {
-    run_one_estimator(aSummaryline, H2D::H2D_EquiDepth, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_EquiDepth, aCb, std::cout);
   }
   if (aCb.mhist2()) {
-    run_one_estimator(aSummaryline, H2D::H2D_MHIST2, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_MHIST2, aCb, std::cout);
   }
   if (aCb.qts()) {
 
-    run_one_estimator(aSummaryline, H2D::H2D_QTS, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_QTS, aCb, std::cout);
   }
   if (aCb.iqts()) {
-    run_one_estimator(aSummaryline, H2D::H2D_IQTS, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_IQTS, aCb, std::cout);
   }
   if (aCb.gxtree()) {
-    run_one_estimator(aSummaryline, H2D::H2D_GXTREE, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_GXTREE, aCb, std::cout);
   }
   if (aCb.sampling()) {
-    run_one_estimator(aSummaryline, H2D::H2D_Sampling, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_Sampling, aCb, std::cout);
   }
   if (aCb.xgb()) {
-    run_one_estimator(aSummaryline, H2D::H2D_XGB, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_XGB, aCb, std::cout);
   }
   if (aCb.exgb()) {
-    run_one_estimator(aSummaryline, H2D::H2D_EXGB, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_EXGB, aCb, std::cout);
   }
 
   if (aCb.lwxgb()) {
-    run_one_estimator(aSummaryline, H2D::H2D_LWXGB, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_LWXGB, aCb, std::cout);
   }
 
   if (aCb.nxgb()) {
-    run_one_estimator(aSummaryline, H2D::H2D_NXGB, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_NXGB, aCb, std::cout);
   }
 
   if (aCb.nreqd()) {
 
-    run_one_estimator(aSummaryline, H2D::H2D_NREQD, aCb);
+    run_one_estimator(aSummaryline, H2D::H2D_NREQD, aCb, std::cout);
   }
 
   return true;
@@ -143,15 +164,17 @@ bool ProcessQueryFile::run_all_estimator(summaryline_t &aSummaryline,
 
 bool ProcessQueryFile::run_one_estimator(summaryline_t &aSummaryline,
                                          const H2D_kind_t aEstKind,
-                                         const Cb &aCb) {
+                                         const Cb &aCb, std::ostream &os) {
 
   EstimatorBase2dim *lEstimator = new_estimator(aSummaryline, aEstKind, aCb);
   if (nullptr == lEstimator) {
-    std::cout << "estimator currently not supported: "
-              << h2d_kind_name(aEstKind) << std::endl;
+    os << "estimator currently not supported: " << h2d_kind_name(aEstKind)
+       << std::endl;
     return false;
   }
-  _esteval.init();
+  // _esteval holds the thetas, the counts are per call
+  EstimateEvaluator lEval(_esteval);
+  lEval.init();
   // uint lCount = 0;
   /*
   std::cout<< "................."<<std::endl;
@@ -162,18 +185,17 @@ bool ProcessQueryFile::run_one_estimator(summaryline_t &aSummaryline,
 */
   cmeasure_t lMeasNR;
   cmeasure_start(&lMeasNR);
-  for (const auto &lQuery : query()) {
-    // std::cout << "Query_" << (lQuery.no()) << std::endl;
-    const double lEstimate = lEstimator->estimate(
-        lQuery); // NR: estimate(lQuery) be jaye lQuery.rectangle()
-    _esteval.step(lQuery.card(), lEstimate);
-
-    _esteval.nstep(lQuery.card(), lEstimate);
-    //    _esteval.dstep(lQuery.no(),lQuery.card(), lEstimate);
+  if (!_schedule.empty()) {
+    evaluate_scheduled(lEstimator, aCb.noThreads(), aCb.latency(), aEstKind,
+                       aCb.queryOrder(), aCb.queryOrderCmp(), lEval, os);
+  } else if (1 < aCb.noThreads()) {
+    evaluate_parallel(lEstimator, aCb.noThreads(), aCb.latency(), lEval);
+  } else {
+    evaluate_chunk(lEstimator, 0, query().size(), aCb.latency(), lEval);
   }
   cmeasure_stop(&lMeasNR);
 
-  _esteval.fin();
+  lEval.fin();
 
   // std::cout << "Estimator " << h2d_kind_name(aEstKind) << std::endl;
 
@@ -181,7 +203,11 @@ bool ProcessQueryFile::run_one_estimator(summaryline_t &aSummaryline,
   //  _esteval.print(std::cout);
   //_esteval.printAllforOneEst(std::cout);
   //
-  _esteval.nprint(std::cout);
+  lEval.nprint(os);
+  if (aCb.latency()) {
+    lEval.lprint(os, std::string("! latency-ns ") + h2d_kind_name(aEstKind),
+                 CrystalClock::frequency() / 1.0e9);
+  }
   // _esteval.dprint(std::cout);
   const uint lTotal = data().total();
   const uint lCardClass = ((uint)std::floor(std::log2(lTotal)));
@@ -196,6 +222,303 @@ bool ProcessQueryFile::run_one_estimator(summaryline_t &aSummaryline,
 
 bool ProcessQueryFile::fin(const Cb &aCb) { return true; }
 
+/*
+ * evaluate query()[aBegin, aEnd) into aEval.
+ * with aLatency, every query is estimated on its own and the cycles
+ * spent in estimate() are recorded (two rdtsc, a few dozen cycles),
+ * otherwise the chunk is estimated by one call to estimate_batch.
+ */
+
+void ProcessQueryFile::evaluate_chunk(const EstimatorBase2dim *aEstimator,
+                                      const uint aBegin, const uint aEnd,
+                                      const bool aLatency,
+                                      EstimateEvaluator &aEval) const {
+  if (aLatency) {
+    for (uint i = aBegin; i < aEnd; ++i) {
+      const query_t &lQuery = query()[i];
+      const uint64_t lBegin = CrystalClock::current();
+      const double lEstimate = aEstimator->estimate(lQuery);
+      const uint64_t lEnd = CrystalClock::current();
+      aEval.step(lQuery.card(), lEstimate);
+      aEval.nstep(lQuery.card(), lEstimate);
+      aEval.lstep(lQuery.card(), CrystalClock::cycles(lBegin, lEnd));
+    }
+    return;
+  }
+  std::vector<double> lEstimates(aEnd - aBegin);
+  aEstimator->estimate_batch(query().data() + aBegin, aEnd - aBegin,
+                             lEstimates.data());
+  for (uint i = aBegin; i < aEnd; ++i) {
+    const query_t &lQuery = query()[i];
+    // std::cout << "Query_" << (lQuery.no()) << std::endl;
+    const double lEstimate = lEstimates[i - aBegin];
+    aEval.step(lQuery.card(), lEstimate);
+
+    aEval.nstep(lQuery.card(), lEstimate);
+    //    aEval.dstep(lQuery.no(),lQuery.card(), lEstimate);
+  }
+}
+
+/*
+ * evaluate all queries with aNoThreads threads.
+ * thread k evaluates the k-th contiguous chunk of query() into its own
+ * EstimateEvaluator, the evaluators are merged into aEval in chunk
+ * order. all counters (and thus nprint) are identical to the serial loop,
+ * only the q-error sums of the aggregates are added up per chunk.
+ * estimate() must be safe to call concurrently on a const estimator.
+ */
+
+void ProcessQueryFile::evaluate_parallel(const EstimatorBase2dim *aEstimator,
+                                         const uint aNoThreads,
+                                         const bool aLatency,
+                                         EstimateEvaluator &aEval) const {
+  const uint lNoQuery = query().size();
+  const uint lNoThreads = std::max<uint>(1, std::min<uint>(aNoThreads, lNoQuery));
+  const uint lChunkSize = (lNoQuery + lNoThreads - 1) / lNoThreads;
+
+  std::vector<EstimateEvaluator> lEval(lNoThreads);
+  for (auto &lEv : lEval) {
+    lEv.setTotalCard(aEval.getTotal());
+    for (uint i = 0; i < aEval.no_theta(); ++i) {
+      lEv.push_back(aEval.theta(i));
+    }
+    lEv.init();
+  }
+
+  std::vector<std::thread> lThreads;
+  lThreads.reserve(lNoThreads);
+  for (uint k = 0; k < lNoThreads; ++k) {
+    lThreads.emplace_back([this, aEstimator, aLatency, &lEval, k, lChunkSize, lNoQuery]() {
+      const uint lBegin = std::min<uint>(lNoQuery, k * lChunkSize);
+      const uint lEnd = std::min<uint>(lNoQuery, lBegin + lChunkSize);
+      evaluate_chunk(aEstimator, lBegin, lEnd, aLatency, lEval[k]);
+    });
+  }
+  for (auto &lThread : lThreads) {
+    lThread.join();
+  }
+  for (const auto &lEv : lEval) {
+    aEval.merge(lEv);
+  }
+}
+
+/*
+ * --query-order 1 (z-curve) or 2 (Hilbert curve):
+ * the centers of the queries are mapped onto a 2^15 x 2^15 grid over
+ * their bounding box (Hilbert::xy2d computes in int), the queries are
+ * sorted by the position of their grid cell on the curve, ties in file
+ * order. consecutive queries then mostly descend into the same parts of
+ * a tree synopsis.
+ */
+
+static const char *query_order_name(const uint aQueryOrder) {
+  switch (aQueryOrder) {
+  case 1:
+    return "z-curve";
+  case 2:
+    return "hilbert";
+  default:
+    return "file";
+  }
+}
+
+void ProcessQueryFile::init_schedule(const uint aQueryOrder) {
+  _schedule.clear();
+  _queryScheduled.clear();
+  if (2 < aQueryOrder) {
+    std::cout << "unknown query order " << aQueryOrder
+              << ", queries are estimated in file order." << std::endl;
+    return;
+  }
+  if ((0 == aQueryOrder) || query().empty()) {
+    return;
+  }
+  cmeasure_t lMeas;
+  cmeasure_start(&lMeas);
+
+  const uint lNoBits = 15;
+  const uint64_t lMaxCell = (((uint64_t)1) << lNoBits) - 1;
+  const uint lNoQuery = query().size();
+  double lXmin = std::numeric_limits<double>::max();
+  double lXmax = std::numeric_limits<double>::lowest();
+  double lYmin = std::numeric_limits<double>::max();
+  double lYmax = std::numeric_limits<double>::lowest();
+  for (const query_t &lQuery : query()) {
+    const rectangle_t &r = lQuery.rectangle();
+    const double lCx = (r.xlo() + r.xhi()) / 2;
+    const double lCy = (r.ylo() + r.yhi()) / 2;
+    lXmin = std::min(lXmin, lCx);
+    lXmax = std::max(lXmax, lCx);
+    lYmin = std::min(lYmin, lCy);
+    lYmax = std::max(lYmax, lCy);
+  }
+  const double lScaleX = (lXmin < lXmax) ? ((lMaxCell + 1) / (lXmax - lXmin)) : 0;
+  const double lScaleY = (lYmin < lYmax) ? ((lMaxCell + 1) / (lYmax - lYmin)) : 0;
+
+  const ZCurve<uint64_t> lZCurve(lNoBits);
+  const Hilbert lHilbert(1 << lNoBits);
+  std::vector<std::pair<uint64_t, uint>> lKey(lNoQuery);
+  for (uint i = 0; i < lNoQuery; ++i) {
+    const rectangle_t &r = query()[i].rectangle();
+    const uint64_t x = std::min<uint64_t>(
+        lMaxCell, (uint64_t)(((r.xlo() + r.xhi()) / 2 - lXmin) * lScaleX));
+    const uint64_t y = std::min<uint64_t>(
+        lMaxCell, (uint64_t)(((r.ylo() + r.yhi()) / 2 - lYmin) * lScaleY));
+    const uint64_t d = (1 == aQueryOrder) ? lZCurve.xy2d(x, y)
+                                          : (uint64_t)lHilbert.xy2d(x, y);
+    lKey[i] = std::make_pair(d, i);
+  }
+  std::sort(lKey.begin(), lKey.end());
+
+  _schedule.resize(lNoQuery);
+  _queryScheduled.resize(lNoQuery);
+  for (uint k = 0; k < lNoQuery; ++k) {
+    _schedule[k] = lKey[k].second;
+    _queryScheduled[k] = query()[lKey[k].second];
+  }
+  cmeasure_stop(&lMeas);
+  _schedule_time_s = cmeasure_total_s(&lMeas);
+
+  if (trace()) {
+    std::cout << "#order   = " << query_order_name(aQueryOrder) << " ("
+              << _schedule_time_s << " s)" << std::endl;
+  }
+}
+
+/*
+ * evaluate all queries in the order of _schedule.
+ * the estimates are scattered back to the positions of their queries
+ * and fed to aEval in file order, the output is that of the serial
+ * loop in file order. the time of the ordered run is printed:
+ * ! query-order <order> <estimator> <kind> <#queries> <file s> <ordered s> <speedup> <schedule s>
+ * only with --query-order-cmp <n> (aNoCmpRounds = n > 0) the queries
+ * are also estimated in file order (the same threads, results
+ * discarded). there are n rounds estimating in both orders, the round
+ * starts alternate between file and ordered so that neither profits
+ * from the caches warmed by the other, the times printed are the minima
+ * over all rounds (use n >= 2). otherwise <file s> and <speedup> are 0.
+ */
+
+void ProcessQueryFile::evaluate_scheduled(const EstimatorBase2dim *aEstimator,
+                                          const uint aNoThreads,
+                                          const bool aLatency,
+                                          const H2D_kind_t aEstKind,
+                                          const uint aQueryOrder,
+                                          const uint aNoCmpRounds,
+                                          EstimateEvaluator &aEval,
+                                          std::ostream &os) const {
+  const uint lNoQuery = query().size();
+  std::vector<double> lEstimate(lNoQuery);
+  std::vector<uint64_t> lCycles(aLatency ? lNoQuery : 0);
+
+  double lFileS = 0;
+  double lOrderedS = 0;
+  if (0 == aNoCmpRounds) {
+    cmeasure_t lMeasOrdered;
+    cmeasure_start(&lMeasOrdered);
+    estimate_all(aEstimator, _queryScheduled, _schedule.data(), aNoThreads,
+                 aLatency, lEstimate.data(), lCycles.data());
+    cmeasure_stop(&lMeasOrdered);
+    lOrderedS = cmeasure_total_s(&lMeasOrdered);
+  } else {
+    std::vector<double> lEstimateFile(lNoQuery);
+    std::vector<uint64_t> lCyclesFile(aLatency ? lNoQuery : 0);
+    lFileS = std::numeric_limits<double>::max();
+    lOrderedS = std::numeric_limits<double>::max();
+    for (uint lRound = 0; lRound < 2 * aNoCmpRounds; ++lRound) {
+      const bool lIsFile = ((lRound & 1) == ((lRound >> 1) & 1));
+      cmeasure_t lMeas;
+      cmeasure_start(&lMeas);
+      if (lIsFile) {
+        estimate_all(aEstimator, query(), nullptr, aNoThreads, aLatency,
+                     lEstimateFile.data(), lCyclesFile.data());
+      } else {
+        estimate_all(aEstimator, _queryScheduled, _schedule.data(),
+                     aNoThreads, aLatency, lEstimate.data(), lCycles.data());
+      }
+      cmeasure_stop(&lMeas);
+      double &lMin = (lIsFile ? lFileS : lOrderedS);
+      lMin = std::min(lMin, cmeasure_total_s(&lMeas));
+    }
+  }
+
+  for (uint i = 0; i < lNoQuery; ++i) {
+    const query_t &lQuery = query()[i];
+    aEval.step(lQuery.card(), lEstimate[i]);
+    aEval.nstep(lQuery.card(), lEstimate[i]);
+    if (aLatency) {
+      aEval.lstep(lQuery.card(), lCycles[i]);
+    }
+  }
+
+  os << "! query-order " << query_order_name(aQueryOrder) << ' '
+     << h2d_kind_name(aEstKind) << ' ' << aEstKind << ' ' << lNoQuery << ' '
+     << lFileS << ' ' << lOrderedS << ' '
+     << (((0 < lFileS) && (0 < lOrderedS)) ? (lFileS / lOrderedS) : 0) << ' '
+     << _schedule_time_s << std::endl;
+}
+
+/*
+ * estimate aQuery with aNoThreads threads, thread k takes the k-th
+ * contiguous chunk. the estimate of aQuery[k] goes to aEstimate[aIndex[k]]
+ * (aEstimate[k] if aIndex is null), with aLatency its cycles likewise
+ * to aCycles.
+ */
+
+void ProcessQueryFile::estimate_all(const EstimatorBase2dim *aEstimator,
+                                    const query_vt &aQuery, const uint *aIndex,
+                                    const uint aNoThreads, const bool aLatency,
+                                    double *aEstimate,
+                                    uint64_t *aCycles) const {
+  const uint lNoQuery = aQuery.size();
+  const uint lNoThreads =
+      std::max<uint>(1, std::min<uint>(aNoThreads, lNoQuery));
+  if (1 == lNoThreads) {
+    estimate_chunk(aEstimator, aQuery, aIndex, 0, lNoQuery, aLatency,
+                   aEstimate, aCycles);
+    return;
+  }
+  const uint lChunkSize = (lNoQuery + lNoThreads - 1) / lNoThreads;
+  std::vector<std::thread> lThreads;
+  lThreads.reserve(lNoThreads);
+  for (uint k = 0; k < lNoThreads; ++k) {
+    lThreads.emplace_back([this, aEstimator, &aQuery, aIndex, aLatency,
+                           aEstimate, aCycles, k, lChunkSize, lNoQuery]() {
+      const uint lBegin = std::min<uint>(lNoQuery, k * lChunkSize);
+      const uint lEnd = std::min<uint>(lNoQuery, lBegin + lChunkSize);
+      estimate_chunk(aEstimator, aQuery, aIndex, lBegin, lEnd, aLatency,
+                     aEstimate, aCycles);
+    });
+  }
+  for (auto &lThread : lThreads) {
+    lThread.join();
+  }
+}
+
+void ProcessQueryFile::estimate_chunk(const EstimatorBase2dim *aEstimator,
+                                      const query_vt &aQuery,
+                                      const uint *aIndex, const uint aBegin,
+                                      const uint aEnd, const bool aLatency,
+                                      double *aEstimate,
+                                      uint64_t *aCycles) const {
+  if (aLatency) {
+    for (uint k = aBegin; k < aEnd; ++k) {
+      const uint lPos = (nullptr == aIndex) ? k : aIndex[k];
+      const uint64_t lBegin = CrystalClock::current();
+      aEstimate[lPos] = aEstimator->estimate(aQuery[k]);
+      const uint64_t lEnd = CrystalClock::current();
+      aCycles[lPos] = CrystalClock::cycles(lBegin, lEnd);
+    }
+    return;
+  }
+  std::vector<double> lEstimates(aEnd - aBegin);
+  aEstimator->estimate_batch(aQuery.data() + aBegin, aEnd - aBegin,
+                             lEstimates.data());
+  for (uint k = aBegin; k < aEnd; ++k) {
+    aEstimate[(nullptr == aIndex) ? k : aIndex[k]] = lEstimates[k - aBegin];
+  }
+}
+
 int ProcessQueryFile::generate_train_query(std::ostream &os,
                                            const H2D::Data2dim &aData,
                                            const H2D::Cb &aCb, uint no_query) {
@@ -234,38 +557,45 @@ int ProcessQueryFile::generate_train_query(std::ostream &os,
 }
 
 bool ProcessQueryFile::read_data_file(const std::string &aFilename) {
-  _data.readHistFile(aFilename);
+  if (!(has_bin_sibling(aFilename) &&
+        read_hist_bin(bin_sibling(aFilename), _data))) {
+    _data.readHistFile(aFilename);
+  }
   if (0 == _data.size()) {
     std::cout << "Can't read data file '" << aFilename << "'." << std::endl;
     return false;
   }
   return true;
 }
+std::string ProcessQueryFile::synopsis_filename(const H2D_kind_t aEstKind,
+                                                const int aSubkind,
+                                                const Cb &aCb,
+                                                bool &aIsCurrent) const {
+  aIsCurrent = false;
+  if (aCb.synopsisDir().empty()) {
+    return std::string();
+  }
+  const std::string lRes = aCb.synopsisDir() + '/' + aCb.sds() + '/' +
+                           aCb.ds() + '.' + h2d_kind_name(aEstKind) + '_' +
+                           std::to_string(aSubkind) + '_' +
+                           std::to_string(aCb.budget()) + ".syn";
+  // a synopsis older than its data file is rebuilt, as a stale .bin file
+  const std::string lData = filebase() + ".hist";
+  std::error_code lEc;
+  if (std::filesystem::is_regular_file(lRes, lEc)) {
+    aIsCurrent = !std::filesystem::exists(lData, lEc) ||
+                 (std::filesystem::last_write_time(lData, lEc) <=
+                  std::filesystem::last_write_time(lRes, lEc));
+  }
+  return lRes;
+}
+
 bool ProcessQueryFile::read_train_query_file(const std::string &aFilename) {
   _trainQuery.clear();
-  std::ifstream lIs(aFilename);
-  if (!lIs) {
-    std::cout << "Can't open file '" << aFilename << "'." << std::endl;
-    return false;
-  }
-  query_t lQuery;
-  while (!lIs.eof()) {
-    lIs >> lQuery._no;
-    if (lIs.eof()) {
-      break;
-    }
-    lIs >> lQuery._card;
-    if (lIs.eof()) {
-      break;
-    }
-    if (lQuery._rectangle.read(lIs)) {
-      _trainQuery.push_back(lQuery);
-      if (_trainQuery.size() >= 20000) {
-        break;
-      }
-    } else {
-      std::cout << "can't read rectangle number " << trainQuery().size()
-                << std::endl;
+  if (!(has_bin_sibling(aFilename) &&
+        read_query_bin(bin_sibling(aFilename), _trainQuery, 20000))) {
+    _trainQuery.clear();
+    if (!read_query_text(aFilename, _trainQuery, 20000)) {
       return false;
     }
   }
@@ -316,26 +646,10 @@ int ProcessQueryFile::generate_train_query_2000(const H2D::Data2dim &aData,
 
 bool ProcessQueryFile::read_query_file(const std::string &aFilename) {
   _query.clear();
-  std::ifstream lIs(aFilename);
-  if (!lIs) {
-    std::cout << "Can't open file '" << aFilename << "'." << std::endl;
-    return false;
-  }
-  query_t lQuery;
-  while (!lIs.eof()) {
-    lIs >> lQuery._no;
-    if (lIs.eof()) {
-      break;
-    }
-    lIs >> lQuery._card;
-    if (lIs.eof()) {
-      break;
-    }
-    if (lQuery._rectangle.read(lIs)) {
-      _query.push_back(lQuery);
-    } else {
-      std::cout << "can't read rectangle number " << query().size()
-                << std::endl;
+  if (!(has_bin_sibling(aFilename) &&
+        read_query_bin(bin_sibling(aFilename), _query))) {
+    _query.clear();
+    if (!read_query_text(aFilename, _query)) {
       return false;
     }
   }
@@ -347,6 +661,22 @@ bool ProcessQueryFile::read_query_file(const std::string &aFilename) {
  * with default parameters (only external parameter is budget/samplesize)
  */
 
+/*
+ * after train_model the estimates come from the native evaluation of the
+ * saved model (XGBEstimator::model), XGBoost itself only predicts the
+ * test queries if the model could not be loaded, or with --xgb-check to
+ * compare both predictions.
+ */
+
+void ProcessQueryFile::fin_xgb(XGBEstimator *aEstimator,
+                               const H2D_kind_t aEstKind, const Cb &aCb) {
+  if (!aEstimator->model().isLoaded()) {
+    aEstimator->run_prediction();
+  } else if (aCb.xgb_check()) {
+    aEstimator->check_model(h2d_kind_name(aEstKind), std::cout);
+  }
+}
+
 EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
                                                    const H2D_kind_t aEstKind,
                                                    const H2D::Cb &aCb) {
@@ -454,13 +784,10 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
     lRes = new XGBEstimator(aCb, data().total(), filebase(), query(),
                             trainQuery());
 
-    lRes->fill_libsvm_trainfiles();
-    lRes->train_model((aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                       "_train_libsvm.dat")
-                          .c_str(),
-                      (aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                       "_eval_libsvm.dat")
-                          .c_str());
+    if (aCb.xgb_dump_libsvm()) {
+      lRes->fill_libsvm_trainfiles();
+    }
+    lRes->train_model();
     cmeasure_stop(&lMeas);
     /*
     std::cout << "train model time(s):" << std::endl;
@@ -471,10 +798,10 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
     cmeasure_start(&lMeas);
 
     cmeasure_start(&lMeas);
-    lRes->fill_libsvm_testfiles();
-    lRes->run_prediction((aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                          "_test_libsvm.dat")
-                             .c_str());
+    if (aCb.xgb_dump_libsvm()) {
+      lRes->fill_libsvm_testfiles();
+    }
+    fin_xgb(static_cast<XGBEstimator *>(lRes), aEstKind, aCb);
   /*  cmeasure_stop(&lMeas);
     std::cout << "XGB 1M queries pred time(s):" << std::endl;
     std::cout << cmeasure_total_s(&lMeas) << std::endl;
@@ -498,13 +825,10 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
                            //,lPhi,
                            data().total(), filebase(), query(), trainQuery());
     // std::cout<<"sakht"<<std::endl;
-    lRes->fill_libsvm_trainfiles();
-    lRes->train_model((aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                       "_exgb_train_libsvm.dat")
-                          .c_str(),
-                      (aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                       "_exgb_eval_libsvm.dat")
-                          .c_str());
+    if (aCb.xgb_dump_libsvm()) {
+      lRes->fill_libsvm_trainfiles();
+    }
+    lRes->train_model();
 
     cmeasure_stop(&lMeas);
     /*std::cout << "exgb train model time(s):" << std::endl;
@@ -514,10 +838,10 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
 */
     aSummaryline._constructionTime = cmeasure_total_s(&lMeas);
     cmeasure_start(&lMeas);
-    lRes->fill_libsvm_testfiles();
-    lRes->run_prediction((aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                          "_exgb_test_libsvm.dat")
-                             .c_str());
+    if (aCb.xgb_dump_libsvm()) {
+      lRes->fill_libsvm_testfiles();
+    }
+    fin_xgb(static_cast<XGBEstimator *>(lRes), aEstKind, aCb);
     cmeasure_stop(&lMeas);
     /*std::cout << "EXGB 1M query pred time(s):" << std::endl;
     std::cout << cmeasure_total_s(&lMeas) << std::endl;
@@ -539,13 +863,10 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
     lRes = new LWXGB(data(), aCb, data().total(), filebase(), query(),
                               trainQuery());
 
-    lRes->fill_libsvm_trainfiles();
-    lRes->train_model((aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                       "_lwxgb_train_libsvm.dat")
-                          .c_str(),
-                      (aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                       "_lwxgb_eval_libsvm.dat")
-                          .c_str());
+    if (aCb.xgb_dump_libsvm()) {
+      lRes->fill_libsvm_trainfiles();
+    }
+    lRes->train_model();
 
     cmeasure_stop(&lMeas);
     /*
@@ -556,10 +877,10 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
 */
     aSummaryline._constructionTime = cmeasure_total_s(&lMeas);
     cmeasure_start(&lMeas);
-    lRes->fill_libsvm_testfiles();
-    lRes->run_prediction((aCb.inDir()+"/" + aCb.sds() + "/" + aCb.ds() +
-                          "_lwxgb_test_libsvm.dat")
-                             .c_str());
+    if (aCb.xgb_dump_libsvm()) {
+      lRes->fill_libsvm_testfiles();
+    }
+    fin_xgb(static_cast<XGBEstimator *>(lRes), aEstKind, aCb);
     cmeasure_stop(&lMeas);
     /*
     std::cout << "LW-XGB 1M query pred time(s):" << std::endl;
@@ -573,10 +894,24 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
 
   case H2D::H2D_QTS: {
     H2D::QTS::kind_t lQTSKind = (H2D::QTS::kind_t)aCb.kind();
-    cmeasure_start(&lMeas);
-    H2D::QTS *lQts = new H2D::QTS(data(), lQTSKind, aCb.budget(), lPhi, lQ,
-                                  lTheta, aCb.trace());
-    cmeasure_stop(&lMeas);
+    bool lIsCurrent = false;
+    const std::string lSynFile =
+        synopsis_filename(aEstKind, lQTSKind, aCb, lIsCurrent);
+    H2D::QTS *lQts = nullptr;
+    if (lIsCurrent) {
+      lQts = H2D::QTS::load(lSynFile, lQTSKind, aCb.budget(), lPhi, lQ, lTheta,
+                            aCb.trace());
+    }
+    if (nullptr == lQts) {
+      cmeasure_start(&lMeas);
+      lQts = new H2D::QTS(data(), lQTSKind, aCb.budget(), lPhi, lQ, lTheta,
+                          aCb.trace());
+      cmeasure_stop(&lMeas);
+      if (!lSynFile.empty() && !lQts->save(lSynFile)) {
+        std::cerr << "could not save synopsis '" << lSynFile << "'"
+                  << std::endl;
+      }
+    }
 
     if (trace()) {
       std::cout << "QTS:" << std::endl;
@@ -623,31 +958,68 @@ EstimatorBase2dim *ProcessQueryFile::new_estimator(summaryline_t &aSummaryline,
   case H2D::H2D_GXTREE: {
     H2D::GxTree *lGxt = 0;
     H2D::GxTreeItp *lGxtItp = 0;
+    H2D::GxTree::synopsis_info_t lInfo;
     const bool lCheckEncoding = false;
-    cmeasure_start(&lMeas);
-    lGxt = new H2D::GxTree(data(), GxTree::K_GLMS, aCb.budget(),
-                           aCb.leafRefinement(), aCb.lrf(),
-                           aCb.minimumNodeTotal(), lPhi, lQ, lTheta, false);
-    lGxt->encode(lCheckEncoding);
-    // lGxt->printEncodingInfo(std::cout);
-
-    lGxtItp = new H2D::GxTreeItp(lGxt->outlier(), lGxt->encoding(), false);
-    lGxt->_gxtitp = lGxtItp;
-    cmeasure_stop(&lMeas);
-    aSummaryline._constructionTime = cmeasure_total_s(&lMeas);
-    aSummaryline._size = lGxt->size();
+    bool lIsCurrent = false;
+    const std::string lSynFile =
+        synopsis_filename(aEstKind, GxTree::K_GLMS, aCb, lIsCurrent);
+    if (lIsCurrent) {
+      lGxtItp = H2D::GxTreeItp::load(lSynFile, lInfo, false);
+      if (0 != lGxtItp &&
+          !lInfo.sameParameters(GxTree::K_GLMS, aCb.budget(),
+                                aCb.leafRefinement(), aCb.lrf(), lPhi, lQ,
+                                lTheta)) {
+        delete lGxtItp;
+        lGxtItp = 0;
+      }
+    }
+    if (0 == lGxtItp) {
+      // main_sweep: concurrent builds with the same value, no write
+      if (H2D::GxTree::noBuildThreads() != aCb.noBuildThreads()) {
+        H2D::GxTree::noBuildThreads(aCb.noBuildThreads());
+      }
+      cmeasure_start(&lMeas);
+      lGxt = new H2D::GxTree(data(), GxTree::K_GLMS, aCb.budget(),
+                             aCb.leafRefinement(), aCb.lrf(),
+                             aCb.minimumNodeTotal(), lPhi, lQ, lTheta, false);
+      lGxt->encode(lCheckEncoding);
+      // lGxt->printEncodingInfo(std::cout);
+
+      lGxtItp = new H2D::GxTreeItp(lGxt->outlier(), lGxt->encoding(), false);
+      lGxt->_gxtitp = lGxtItp;
+      cmeasure_stop(&lMeas);
+      lInfo = lGxt->synopsisInfo();
+      lInfo._constructionTime = cmeasure_total_s(&lMeas);
+      if (!lSynFile.empty() &&
+          !lGxt->save(lSynFile, lInfo._constructionTime)) {
+        std::cerr << "could not save synopsis '" << lSynFile << "'"
+                  << std::endl;
+      }
+    }
+    // a loaded GxTree reports the construction time measured when it was saved
+    aSummaryline._constructionTime = lInfo._constructionTime;
+    aSummaryline._size = lInfo._size;
     aSummaryline._subkind = GxTree::K_GLMS;
-    aSummaryline._nout = lGxt->noOutlier();
+    aSummaryline._nout = lInfo._noOutlier;
     aSummaryline._param._gxtree._leafRefinement = aCb.leafRefinement();
     aSummaryline._param._gxtree._lrf = aCb.lrf();
     aSummaryline._param._gxtree._minimumNodeTotal =
-        aSummaryline._param._gxtree._depth = lGxt->depth();
-    aSummaryline._param._gxtree._noNodes = lGxt->noNodes();
-    aSummaryline._param._gxtree._noGNodes = lGxt->noGNodes();
-    aSummaryline._param._gxtree._minSplit = lGxt->minSplit();
-    aSummaryline._param._gxtree._maxUnsplit = lGxt->maxUnsplit();
+        aSummaryline._param._gxtree._depth = lInfo._depth;
+    aSummaryline._param._gxtree._noNodes = lInfo._noNodes;
+    aSummaryline._param._gxtree._noGNodes = lInfo._noGNodes;
+    aSummaryline._param._gxtree._minSplit = lInfo._minSplit;
+    aSummaryline._param._gxtree._maxUnsplit = lInfo._maxUnsplit;
     aSummaryline._param._gxtree._encoded = 'E';
-    if (trace()) {
+    if (trace() && 0 == lGxt) {
+      std::cout << std::endl;
+      std::cout << "Gx-Tree: loaded from " << lSynFile << std::endl;
+      std::cout << "   depth: " << lInfo._depth << std::endl;
+      std::cout << "   #node: " << lInfo._noNodes << std::endl;
+      std::cout << "    size: " << lInfo._size << std::endl;
+      std::cout << "#outlier: " << lInfo._noOutlier << std::endl;
+      std::cout << std::endl;
+    }
+    if (trace() && 0 != lGxt) {
       std::cout << std::endl;
       std::cout << "Gx-Tree:" << std::endl;
       std::cout << "       q: " << lGxt->q() << std::endl;
@@ -6,16 +6,19 @@
 #include <string> 
 #include <vector>
 #include <filesystem>
+#include <thread>
     
 #include "infra/argbase.hh"
 #include "infra/aggregate.hh"
 #include "infra/matrix.hh"
 #include "infra/measure.hh"
+#include "infra/CrystalClock.hh"
 #include "infra/tmath.hh"
 #include "infra/types.hh"
 #include "infra/cb.hh"
 #include "infra/util.hh"
 #include "infra/data2dim.hh"
+#include "infra/binfile.hh"
 #include "infra/summaryline.hh"
 #include "infra/RegularPartitioning2dim.hh"
 #include "EstimatorArea/EstimatorArea.hh"
@@ -32,6 +35,8 @@
 #include "EXGB/EXGB.hh"
 #include "LWXGB/LWXGB.hh"
 #include "OneDEqDepHist/OneDEqDepHist.hh"
+#include "Hilbert/Hilbert.hh"
+#include "Hilbert/ZCurve.hh"
 #include <random>
 
 
@@ -44,6 +49,11 @@ class ProcessQueryFile {
                            Cb&          aCb);
   public:
     bool run(const Cb& aCb);
+    // runs the estimator aEstKind alone, its results go to os
+    bool run_estimator(const H2D_kind_t    aEstKind,
+                       const Cb&           aCb,
+                             std::ostream& os);
+    inline bool isValid() const { return _isValid; } // data and queries read
   private:
     bool init(const std::string& aDirIn,
               const std::string& aDirOut,
@@ -52,8 +62,43 @@ class ProcessQueryFile {
                            const Cb&            aCb);
     bool run_one_estimator(      summaryline_t& aSummaryline,
                            const H2D_kind_t     aEstKind, 
-                           const Cb&            aCb);
+                           const Cb&            aCb,
+                                 std::ostream&  os);
+    void init_summaryline(summaryline_t& aSummaryline, const Cb& aCb) const;
     bool fin(const Cb& aCb);
+    void evaluate_parallel(const EstimatorBase2dim* aEstimator,
+                           const uint               aNoThreads,
+                           const bool               aLatency,
+                                 EstimateEvaluator& aEval) const;
+    void evaluate_chunk(const EstimatorBase2dim* aEstimator,
+                        const uint               aBegin,
+                        const uint               aEnd,
+                        const bool               aLatency,
+                              EstimateEvaluator& aEval) const;
+    void init_schedule(const uint aQueryOrder);
+    void evaluate_scheduled(const EstimatorBase2dim* aEstimator,
+                            const uint               aNoThreads,
+                            const bool               aLatency,
+                            const H2D_kind_t         aEstKind,
+                            const uint               aQueryOrder,
+                            const uint               aNoCmpRounds,
+                                  EstimateEvaluator& aEval,
+                                  std::ostream&      os) const;
+    void estimate_all(const EstimatorBase2dim* aEstimator,
+                      const query_vt&          aQuery,
+                      const uint*              aIndex,
+                      const uint               aNoThreads,
+                      const bool               aLatency,
+                            double*            aEstimate,
+                            uint64_t*          aCycles) const;
+    void estimate_chunk(const EstimatorBase2dim* aEstimator,
+                        const query_vt&          aQuery,
+                        const uint*              aIndex,
+                        const uint               aBegin,
+                        const uint               aEnd,
+                        const bool               aLatency,
+                              double*            aEstimate,
+                              uint64_t*          aCycles) const;
   public:
     inline const std::string& filebase() const { return _filebase; }
     inline const std::string& dir_in() const { return _dir_in; }
@@ -73,6 +118,14 @@ class ProcessQueryFile {
     EstimatorBase2dim* new_estimator(      summaryline_t& aSummaryline,
                                      const H2D_kind_t     aEstKind,
                                      const Cb&            aCb);
+    static void fin_xgb(XGBEstimator* aEstimator, const H2D_kind_t aEstKind, const Cb& aCb);
+    // saved estimator <synopsisDir>/<sds>/<ds>.<kind>_<subkind>_<budget>.syn
+    // empty if there is no --synopsisDir.
+    // aIsCurrent: the file exists and is not older than the data file
+    std::string synopsis_filename(const H2D_kind_t aEstKind,
+                                  const int        aSubkind,
+                                  const Cb&        aCb,
+                                        bool&      aIsCurrent) const;
   private:
     std::string       _dir_in;
     std::string       _dir_out;
@@ -84,6 +137,10 @@ class ProcessQueryFile {
     double            _avg_query_time_us;
     bool              _trace;
     query_vt          _trainQuery;
+    std::vector<uint> _schedule;         // empty: file order, else index into _query of the k-th query estimated
+    query_vt          _queryScheduled;   // _query in the order of _schedule
+    double            _schedule_time_s;  // computing the schedule
+    bool              _isValid;          // result of init
 friend class XGBEstimator;
 };
 
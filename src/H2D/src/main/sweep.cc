@@ -0,0 +1,364 @@
+#include "sweep.hh"
+
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+
+
+#include "process_query_file.hh"
+
+extern "C" {
+#include "infra/cmeasure.h"
+}
+
+namespace H2D {
+
+/*
+ * work stealing pool.
+ * every worker owns a deque of tasks: it pushes and pops its own tasks
+ * at the back (depth first: the estimators of the data set it just
+ * loaded), idle workers steal from the front of the others (the oldest
+ * task, typically a data set not yet loaded).
+ * run returns when all tasks, including those pushed by tasks, are done.
+ */
+
+class wspool_t {
+  public:
+    typedef std::function<void(const uint)> task_t; // argument: number of the worker
+  private:
+    wspool_t(const wspool_t&);
+    wspool_t& operator=(const wspool_t&);
+  public:
+    wspool_t(const uint aNoWorkers);
+  public:
+    inline uint noWorkers() const { return _queue.size(); }
+    void push(const uint aWorker, task_t&& aTask);
+    void run();
+  private:
+    bool pop(const uint aWorker, task_t& aTask);
+    void work(const uint aWorker);
+  private:
+    struct queue_t {
+      std::mutex         _mutex;
+      std::deque<task_t> _task;
+      queue_t() : _mutex(), _task() {}
+    };
+  private:
+    std::vector<queue_t>    _queue;
+    std::mutex              _mutex;     // _noQueued, _noPending
+    std::condition_variable _cv;        // task queued or all done
+    uint                    _noQueued;  // in some deque
+    uint                    _noPending; // queued or running
+};
+
+wspool_t::wspool_t(const uint aNoWorkers)
+         : _queue(std::max<uint>(1, aNoWorkers)),
+           _mutex(), _cv(),
+           _noQueued(0), _noPending(0) {
+}
+
+void
+wspool_t::push(const uint aWorker, task_t&& aTask) {
+  {
+    std::lock_guard<std::mutex> lLock(_queue[aWorker]._mutex);
+    _queue[aWorker]._task.push_back(std::move(aTask));
+  }
+  {
+    std::lock_guard<std::mutex> lLock(_mutex);
+    ++_noQueued;
+    ++_noPending;
+  }
+  _cv.notify_one();
+}
+
+bool
+wspool_t::pop(const uint aWorker, task_t& aTask) {
+  bool lFound = false;
+  {
+    queue_t& lOwn = _queue[aWorker];
+    std::lock_guard<std::mutex> lLock(lOwn._mutex);
+    if(!lOwn._task.empty()) {
+      aTask = std::move(lOwn._task.back());
+      lOwn._task.pop_back();
+      lFound = true;
+    }
+  }
+  for(uint k = 1; !lFound && k < noWorkers(); ++k) {
+    queue_t& lVictim = _queue[(aWorker + k) % noWorkers()];
+    std::lock_guard<std::mutex> lLock(lVictim._mutex);
+    if(!lVictim._task.empty()) {
+      aTask = std::move(lVictim._task.front());
+      lVictim._task.pop_front();
+      lFound = true;
+    }
+  }
+  if(lFound) {
+    std::lock_guard<std::mutex> lLock(_mutex);
+    --_noQueued;
+  }
+  return lFound;
+}
+
+void
+wspool_t::work(const uint aWorker) {
+  task_t lTask;
+  while(true) {
+    if(pop(aWorker, lTask)) {
+      lTask(aWorker);
+      lTask = nullptr; // release what the task holds (e.g. its data set)
+      std::lock_guard<std::mutex> lLock(_mutex);
+      if(0 == --_noPending) {
+        _cv.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lLock(_mutex);
+    _cv.wait(lLock, [this] () { return (0 < _noQueued) || (0 == _noPending); });
+    if(0 == _noPending) {
+      return;
+    }
+  }
+}
+
+void
+wspool_t::run() {
+  std::vector<std::thread> lWorker;
+  lWorker.reserve(noWorkers());
+  for(uint k = 1; k < noWorkers(); ++k) {
+    lWorker.emplace_back([this, k] () { work(k); });
+  }
+  work(0);
+  for(auto& lThread : lWorker) {
+    lThread.join();
+  }
+}
+
+/*
+ * a loaded data set, shared by the estimator tasks of the data set.
+ * _cb is the Cb of the data set, ProcessQueryFile::init sets budget,
+ * sample size, theta and phi in it.
+ */
+
+class Sweep::dsrun_t {
+  private:
+    dsrun_t(const dsrun_t&);
+    dsrun_t& operator=(const dsrun_t&);
+  public:
+    dsrun_t(const Cb& aCb, const uint aDs)
+           : _ds(aDs), _cb(aCb), _proc(aCb.inDir(), aCb.outDir(), _cb) {}
+  public:
+    const uint       _ds;
+    Cb               _cb;
+    ProcessQueryFile _proc;
+};
+
+Sweep::Sweep(const Cb& aCb)
+      : _cb(aCb), _est(), _ds(),
+        _mutex(), _noDone(0), _noFailed(0) {
+}
+
+bool
+Sweep::option_kind(const std::string& aOption, H2D_kind_t& aKind) {
+  static const std::vector<std::pair<std::string, H2D_kind_t>> lOptionKind = {
+    {"est-area", H2D_EST_AREA},
+    {"regp",     H2D_RegPart},
+    {"eqd",      H2D_EquiDepth},
+    {"mhist2",   H2D_MHIST2},
+    {"qts",      H2D_QTS},
+    {"iqts",     H2D_IQTS},
+    {"gxt",      H2D_GXTREE},
+    {"sampling", H2D_Sampling},
+    {"xgb",      H2D_XGB},
+    {"exgb",     H2D_EXGB},
+    {"lwxgb",    H2D_LWXGB},
+    {"nxgb",     H2D_NXGB},
+    {"nreqd",    H2D_NREQD}
+  };
+  for(const auto& lEntry : lOptionKind) {
+    if(lEntry.first == aOption) {
+      aKind = lEntry.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+Sweep::read_manifest(const std::string& aFilename) {
+  std::ifstream lIs(aFilename);
+  if(!lIs) {
+    std::cerr << "can't open manifest '" << aFilename << "'." << std::endl;
+    return false;
+  }
+  std::string lLine;
+  uint lLineNo = 0;
+  while(std::getline(lIs, lLine)) {
+    ++lLineNo;
+    const size_t lComment = lLine.find('#');
+    if(std::string::npos != lComment) {
+      lLine.erase(lComment);
+    }
+    std::istringstream lLs(lLine);
+    std::string lWhat;
+    if(!(lLs >> lWhat)) {
+      continue;
+    }
+    bool lOk = false;
+    if("est" == lWhat) {
+      est_t lEst;
+      if((lLs >> lEst._syn >> lEst._option) && option_kind(lEst._option, lEst._kind)) {
+        lOk = true;
+        if(!(lLs >> lEst._subkind)) {
+          lOk = lLs.eof(); // no kind given
+          lEst._subkind = -1;
+        }
+      }
+      if(lOk) {
+        _est.push_back(lEst);
+      }
+    } else
+    if("ds" == lWhat) {
+      ds_t lDs;
+      if(lLs >> lDs._no >> lDs._sds >> lDs._ds) {
+        lOk = true;
+        _ds.push_back(lDs);
+      }
+    }
+    std::string lRest;
+    if(!lOk || (lLs >> lRest)) {
+      std::cerr << aFilename << ':' << lLineNo << ": bad manifest entry '"
+                << lLine << "'." << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * the data sets are dealt round robin to the deques of the workers,
+ * in reverse such that every worker starts with its first one.
+ */
+
+bool
+Sweep::run(const uint aNoThreads) {
+  _noDone = 0;
+  _noFailed = 0;
+  wspool_t lPool(aNoThreads);
+  for(uint d = _ds.size(); 0 < d--; ) {
+    const uint lWorker = d % lPool.noWorkers();
+    lPool.push(lWorker, [this, d, &lPool] (const uint aWorker) { load_task(aWorker, d, lPool); });
+  }
+  lPool.run();
+  return (0 == _noFailed);
+}
+
+/*
+ * load data set aDs and queue its estimator tasks at the back of the
+ * own deque. the last estimator task done frees the data set.
+ */
+
+void
+Sweep::load_task(const uint aWorker, const uint aDs, wspool_t& aPool) {
+  const ds_t& lDs = _ds[aDs];
+  Cb lCb(_cb);
+  lCb.sds(lDs._sds);
+  lCb.ds(lDs._ds);
+  cmeasure_t lMeas;
+  cmeasure_start(&lMeas);
+  std::shared_ptr<dsrun_t> lDsRun = std::make_shared<dsrun_t>(lCb, aDs);
+  cmeasure_stop(&lMeas);
+  if(!lDsRun->_proc.isValid()) {
+    {
+      std::lock_guard<std::mutex> lLock(_mutex);
+      _noFailed += _est.size();
+      _noDone   += _est.size();
+    }
+    print_progress(lDs, "load", false, cmeasure_total_s(&lMeas));
+    return;
+  }
+  if(_cb.trace()) {
+    print_progress(lDs, "load", true, cmeasure_total_s(&lMeas));
+  }
+  for(uint e = _est.size(); 0 < e--; ) {
+    aPool.push(aWorker, [this, lDsRun, e] (const uint) { est_task(*lDsRun, e); });
+  }
+}
+
+void
+Sweep::est_task(dsrun_t& aDsRun, const uint aEst) {
+  double lTime = 0;
+  const bool lOk = write_result(aDsRun, aEst, lTime);
+  {
+    std::lock_guard<std::mutex> lLock(_mutex);
+    ++_noDone;
+    _noFailed += !lOk;
+  }
+  print_progress(_ds[aDsRun._ds], _est[aEst]._syn, lOk, lTime);
+}
+
+/*
+ * the result is written to a temporary file renamed at the end,
+ * an interrupted sweep leaves no truncated .out file behind.
+ */
+
+bool
+Sweep::write_result(dsrun_t& aDsRun, const uint aEst, double& aTime) {
+  const ds_t&  lDs  = _ds[aDsRun._ds];
+  const est_t& lEst = _est[aEst];
+  const std::filesystem::path lFilename(result_filename(lDs, lEst));
+  std::filesystem::path lFilenameTmp(lFilename);
+  lFilenameTmp += ".tmp";
+
+  std::error_code lEc;
+  std::filesystem::create_directories(lFilename.parent_path(), lEc);
+  std::ofstream lOs(lFilenameTmp);
+  if(!lOs) {
+    std::cerr << "can't open '" << lFilenameTmp.string() << "'." << std::endl;
+    return false;
+  }
+
+  Cb lCb(aDsRun._cb);
+  lCb.kind(lEst._subkind);
+  // the estimator tasks of a data set run concurrently,
+  // every task saves its xgb booster to a file of its own.
+  lCb.xgb_model((lFilename.parent_path() / (lFilename.stem().string() + "_model.json")).string());
+  cmeasure_t lMeas;
+  cmeasure_start(&lMeas);
+  const bool lOk = aDsRun._proc.run_estimator(lEst._kind, lCb, lOs);
+  cmeasure_stop(&lMeas);
+  aTime = cmeasure_total_s(&lMeas);
+  lOs << std::endl; // as main_queryset_estimates
+  lOs.close();
+  if(!lOk || !lOs) {
+    std::filesystem::remove(lFilenameTmp, lEc);
+    return false;
+  }
+  std::filesystem::rename(lFilenameTmp, lFilename, lEc);
+  return !lEc;
+}
+
+std::string
+Sweep::result_filename(const ds_t& aDs, const est_t& aEst) const {
+  return _cb.outDir() + '/' + aDs._sds + '/'
+         + std::to_string(aDs._no) + '_' + aDs._sds + '_' + aDs._ds + '_' + aEst._syn
+         + ".out";
+}
+
+void
+Sweep::print_progress(const ds_t& aDs, const std::string& aWhat, const bool aOk, const double aTime) {
+  std::lock_guard<std::mutex> lLock(_mutex);
+  std::cout << std::setw(6) << _noDone << '/' << noTasks() << ' '
+            << (aOk ? "ok  " : "FAIL") << ' '
+            << aDs._sds << '/' << aDs._ds << ' ' << aWhat << ' '
+            << std::fixed << std::setprecision(3) << aTime << 's'
+            << std::defaultfloat << std::endl;
+}
+
+} // end namespace
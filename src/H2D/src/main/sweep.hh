@@ -0,0 +1,90 @@
+#ifndef H2D_MAIN_SWEEP_HH
+#define H2D_MAIN_SWEEP_HH
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "infra/types.hh"
+#include "infra/cb.hh"
+
+namespace H2D {
+
+class wspool_t; // sweep.cc
+
+/*
+ *  Sweep: runs the estimators of a manifest on all data sets of the
+ *  manifest in one process (main_sweep).
+ *  manifest, one entry per line, everything after '#' is a comment:
+ *    est <syn> <option> [<kind>]  estimator: <option> is the option of
+ *                                 main_queryset_estimates without '--',
+ *                                 <kind> its --kind (default -1),
+ *                                 e.g. est qts_2 qts 2
+ *    ds <no> <sds> <ds>           data set, e.g. ds 17 tiger tl_2013_02016_areawater
+ *  every (ds, est) pair is a task. the tasks run on a work stealing pool
+ *  of aNoThreads workers: a worker loads a data set (Data2dim, queries)
+ *  once and queues its estimator tasks in its own deque, idle workers
+ *  steal from the other end. the data set is freed after its last task.
+ *  the result of a task is written to
+ *    <outDir>/<sds>/<no>_<sds>_<ds>_<syn>.out
+ *  with the contents main_queryset_estimates --<option> --kind <kind>
+ *  prints for this data set (without --trace).
+ *  the xgb estimators save their booster to
+ *    <outDir>/<sds>/<no>_<sds>_<ds>_<syn>_model.json
+ *  (--xgb-model is ignored).
+ */
+
+class Sweep {
+  public:
+    struct est_t {
+      std::string _syn;     // synopsis name in result file name
+      std::string _option;
+      H2D_kind_t  _kind;
+      int         _subkind; // --kind
+      est_t() : _syn(), _option(), _kind(H2D_RegPart), _subkind(-1) {}
+    };
+    struct ds_t {
+      uint        _no;
+      std::string _sds;
+      std::string _ds;
+      ds_t() : _no(0), _sds(), _ds() {}
+    };
+    typedef std::vector<est_t> est_vt;
+    typedef std::vector<ds_t>  ds_vt;
+  private:
+    Sweep(const Sweep&);
+    Sweep& operator=(const Sweep&);
+  public:
+    Sweep(const Cb& aCb);
+  public:
+    bool read_manifest(const std::string& aFilename);
+    // false if any task failed
+    bool run(const uint aNoThreads);
+  public:
+    inline const est_vt& estimators() const { return _est; }
+    inline const ds_vt&  datasets() const { return _ds; }
+    inline       uint    noTasks() const { return _est.size() * _ds.size(); }
+    inline       uint    noFailed() const { return _noFailed; }
+  public:
+    // estimator kind of an option of main_queryset_estimates (without '--')
+    static bool option_kind(const std::string& aOption, H2D_kind_t& aKind);
+  private:
+    class dsrun_t;
+    void load_task(const uint aWorker, const uint aDs, wspool_t& aPool);
+    void est_task(dsrun_t& aDsRun, const uint aEst);
+    bool write_result(dsrun_t& aDsRun, const uint aEst, double& aTime);
+    std::string result_filename(const ds_t& aDs, const est_t& aEst) const;
+    void print_progress(const ds_t& aDs, const std::string& aWhat, const bool aOk, const double aTime);
+  private:
+    const Cb   _cb;
+    est_vt     _est;
+    ds_vt      _ds;
+    std::mutex _mutex;   // _noDone, _noFailed, progress output
+    uint       _noDone;
+    uint       _noFailed;
+};
+
+} // end namespace
+
+#endif
@@ -30,6 +30,7 @@ class Scale_S {
     inline uint32_t compress(const uint32_t i) const;
     inline uint32_t decompress(const uint32_t i) const;
     inline double   decompressDouble(const uint32_t i) const;
+    inline const double* decompressTable() const { return _decomprDouble.data(); } // [1 << noBits()], indexed as decompressDouble
     inline uint32_t noBits() const { return _noBits; }
     inline uint32_t maxNo() const { return _compr.size() - 1; }
     inline uint32_t limit() const { return _compr.size() - 1; }
@@ -106,6 +107,7 @@ class Scale_6 {
     inline uint32_t compress(const uint32_t aNumber) const;
     inline uint32_t decompress(const uint32_t aCode) const;
     inline double   decompressDouble(const uint32_t aCode) const;
+    inline const double* decompressTable() const { return _decomprD.data(); } // [1 << noBits()], indexed as decompressDouble
   public:
     double qerror(const uint32_t aBegin, const uint32_t aEnd) const;
   private:
@@ -170,6 +172,7 @@ class ScaleM {
     inline uint32_t compress(const uint32_t aNumber) const;
     inline uint32_t decompress(const uint32_t aCode) const;
     inline double   decompressDouble(const uint32_t aCode) const;
+    inline const double* decompressTable() const { return _decomprD.data(); } // [1 << noBits()], indexed as decompressDouble
   public:
     double qerror(const uint32_t aBegin, const uint32_t aEnd) const;
     
@@ -237,6 +240,7 @@ class Scale_L {
     inline uint32_t compress(const uint32_t aNumber) const;
     inline uint32_t decompress(const uint32_t aCode) const;
     inline double   decompressDouble(const uint32_t aCode) const;
+    inline const double* decompressTable() const { return _decomprD.data(); } // [1 << noBits()], indexed as decompressDouble
   public:
     double qerror(const uint32_t aBegin, const uint32_t aEnd) const;
   private:
@@ -47,6 +47,15 @@ class Aggregate {
       _sumsq += (x*x);
       _count += (Num) 1;
     }
+    // combine with an aggregate over a disjoint set of values
+    inline
+    void merge(const Aggregate& x) {
+      if(x._min < _min) _min = x._min;
+      if(x._max > _max) _max = x._max;
+      _sum   += x._sum;
+      _sumsq += x._sumsq;
+      _count += x._count;
+    }
     inline void fin() {}
   public:
      inline int    dist() const { return _dist; }
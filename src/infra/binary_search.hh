@@ -31,6 +31,40 @@ binary_search(const Telem& key, const Telem* arr, const Tidx n) {
   return mid;
 }
 
+// number of elements of the sorted array arr[0..n) that are smaller than key
+// (std::lower_bound), the loop body compiles to a conditional move
+template<typename Telem, typename Tidx>
+inline Tidx
+lower_bound_branchless(const Telem& key, const Telem* arr, Tidx n) {
+  if(0 == n) {
+    return 0;
+  }
+  const Telem* lBase = arr;
+  while(1 < n) {
+    const Tidx lHalf = n / 2;
+    lBase = (lBase[lHalf] < key) ? (lBase + lHalf) : lBase;
+    n -= lHalf;
+  }
+  return (Tidx) ((lBase - arr) + (*lBase < key));
+}
+
+// number of elements of the sorted array arr[0..n) that are smaller than or equal to key
+// (std::upper_bound)
+template<typename Telem, typename Tidx>
+inline Tidx
+upper_bound_branchless(const Telem& key, const Telem* arr, Tidx n) {
+  if(0 == n) {
+    return 0;
+  }
+  const Telem* lBase = arr;
+  while(1 < n) {
+    const Tidx lHalf = n / 2;
+    lBase = (lBase[lHalf] <= key) ? (lBase + lHalf) : lBase;
+    n -= lHalf;
+  }
+  return (Tidx) ((lBase - arr) + (*lBase <= key));
+}
+
 
 #endif
 
@@ -354,7 +354,7 @@ bit_distribute(const Tuint x, const Tuint aMask) {
   uint32_t c = 0; // count
   while(0 != m) {
     i = idx_lowest_bit_set(m);
-    m ^= (1 << i);
+    m ^= ((Tuint) 1 << i);
     r |= (((x >> c) & 0x1) << i);
     ++c;
   }
@@ -389,7 +389,7 @@ bit_gather(const Tuint x, const Tuint aMask) {
   uint32_t c = 0; // count
   while(0 != m) {
     i = idx_lowest_bit_set(m);
-    m ^= (1 << i);
+    m ^= ((Tuint) 1 << i);
     r |= (((x >> i) & 0x1) << c);
     ++c;
   }